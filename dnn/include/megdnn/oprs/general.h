@@ -1093,6 +1093,93 @@ protected:
 };
 using IndexingSetOneHot = IndexingSetOneHotForward;
 
+class EmbeddingBagBase : public OperatorBase {
+    DEF_OPR_IMPL_CTOR(EmbeddingBagBase, OperatorBase);
+    DEF_OPR_PARAM(EmbeddingBag);
+
+protected:
+    /*!
+     * \brief check index and offsets; return number of bags
+     *
+     * index must be a 1-dimensional int32 tensor, and offsets a 1-dimensional
+     * int32 tensor with one entry per bag
+     */
+    size_t check_index_offsets(const TensorLayout& index, const TensorLayout& offsets);
+};
+
+/*!
+ * \brief gather rows of an embedding table and reduce them per bag
+ *
+ * The i-th bag consists of index[offsets[i]:offsets[i+1]] (the last bag ends
+ * at the end of index); if param().lengths is true, offsets[i] is instead the
+ * number of indices in the i-th bag. For each bag this computes
+ * dst[i] = reduce(weight[index[j]] for j in bag i), where reduce is sum or
+ * mean according to param().mode. The gathered rows are never materialized.
+ *
+ * \param[in] weight (num_embeddings, dim) embedding table
+ * \param[in] index (nnz, ) int32 row indices of all bags concatenated
+ * \param[in] offsets (nr_bags, ) int32 start offsets or lengths of bags
+ * \param[out] dst (nr_bags, dim)
+ */
+class EmbeddingBagForward : public EmbeddingBagBase {
+    DEF_OPR_IMPL(EmbeddingBagForward, EmbeddingBagBase, 3, 1);
+
+public:
+    virtual void exec(
+            _megdnn_tensor_in weight, _megdnn_tensor_in index,
+            _megdnn_tensor_in offsets, _megdnn_tensor_out dst,
+            _megdnn_workspace workspace) = 0;
+    void deduce_layout(
+            const TensorLayout& weight, const TensorLayout& index,
+            const TensorLayout& offsets, TensorLayout& dst);
+    virtual size_t get_workspace_in_bytes(
+            const TensorLayout& weight, const TensorLayout& index,
+            const TensorLayout& offsets, const TensorLayout& dst) = 0;
+
+protected:
+    void check_exec(
+            const TensorLayout& weight, const TensorLayout& index,
+            const TensorLayout& offsets, const TensorLayout& dst,
+            size_t workspace_in_bytes);
+};
+using EmbeddingBag = EmbeddingBagForward;
+
+/*!
+ * \brief sparse gradient of EmbeddingBagForward w.r.t. weight
+ *
+ * Instead of a dense update of the whole table, the gradient is given in a
+ * compact (index, grad) form: grad[j] is the gradient contributed to row
+ * weight[index[j]] by the j-th lookup, i.e. diff[i] (divided by the bag size
+ * in MEAN mode) where i is the bag containing j. Rows referenced more than
+ * once appear once per reference and must be accumulated by the consumer.
+ *
+ * \param[in] diff (nr_bags, dim) gradient of dst
+ * \param[in] index (nnz, ) int32 row indices, as in forward
+ * \param[in] offsets (nr_bags, ) int32 start offsets or lengths, as in forward
+ * \param[out] grad (nnz, dim)
+ */
+class EmbeddingBagBackward : public EmbeddingBagBase {
+    DEF_OPR_IMPL(EmbeddingBagBackward, EmbeddingBagBase, 3, 1);
+
+public:
+    virtual void exec(
+            _megdnn_tensor_in diff, _megdnn_tensor_in index,
+            _megdnn_tensor_in offsets, _megdnn_tensor_out grad,
+            _megdnn_workspace workspace) = 0;
+    void deduce_layout(
+            const TensorLayout& diff, const TensorLayout& index,
+            const TensorLayout& offsets, TensorLayout& grad);
+    virtual size_t get_workspace_in_bytes(
+            const TensorLayout& diff, const TensorLayout& index,
+            const TensorLayout& offsets, const TensorLayout& grad) = 0;
+
+protected:
+    void check_exec(
+            const TensorLayout& diff, const TensorLayout& index,
+            const TensorLayout& offsets, const TensorLayout& grad,
+            size_t workspace_in_bytes);
+};
+
 /*!
  * \brief base class for indexing on multiple axes using vector indices
  *
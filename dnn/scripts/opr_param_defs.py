@@ -767,6 +767,17 @@ pdef('Sleep').add_fields('float32', Doc('time', 'time to sleep in seconds'), 0)
          'negative value to a lower diagonal.'),
      0))
 
+(pdef('EmbeddingBag').
+ add_enum('Mode',
+          Doc('SUM = 0', 'sum of the rows looked up by each bag'),
+          Doc('MEAN = 1', 'mean of the rows looked up by each bag; empty bags '
+              'produce zeros')).
+ add_fields(
+     'bool',
+     Doc('lengths', 'whether the offsets input gives the number of indices in '
+         'each bag instead of the start offset of each bag'),
+     'false'))
+
 (pdef('UniformRNG', version=0, is_legacy=True).
  add_fields('uint64', 'seed', 0))
 
@@ -0,0 +1,91 @@
+/**
+ * \file dnn/src/common/embedding_bag.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "megdnn/oprs.h"
+
+#include "src/common/utils.h"
+
+using namespace megdnn;
+
+size_t EmbeddingBagBase::check_index_offsets(
+        const TensorLayout& index, const TensorLayout& offsets) {
+    megdnn_assert(
+            index.ndim == 1 && offsets.ndim == 1,
+            "EmbeddingBag requires 1-dimensional index and offsets, got index=%s "
+            "offsets=%s",
+            index.to_string().c_str(), offsets.to_string().c_str());
+    megdnn_assert(
+            index.dtype == dtype::Int32() && offsets.dtype == dtype::Int32(),
+            "EmbeddingBag requires int32 index and offsets, got %s and %s",
+            index.dtype.name(), offsets.dtype.name());
+    megdnn_assert_contiguous(index);
+    megdnn_assert_contiguous(offsets);
+    return offsets.shape[0];
+}
+
+void EmbeddingBagForward::deduce_layout(
+        const TensorLayout& weight, const TensorLayout& index,
+        const TensorLayout& offsets, TensorLayout& dst) {
+    megdnn_assert(
+            weight.ndim == 2, "EmbeddingBag weight must be 2-dimensional, got %s",
+            weight.to_string().c_str());
+    size_t nr_bags = check_index_offsets(index, offsets);
+    dst = TensorLayout{TensorShape{nr_bags, weight.shape[1]}, weight.dtype};
+}
+
+void EmbeddingBagForward::check_exec(
+        const TensorLayout& weight, const TensorLayout& index,
+        const TensorLayout& offsets, const TensorLayout& dst,
+        size_t workspace_in_bytes) {
+    TensorLayout dst_expected;
+    megdnn_assert_eq_dtype(weight, dst);
+    deduce_layout(weight, index, offsets, dst_expected);
+    megdnn_assert_eq_layout(dst_expected, dst);
+    megdnn_assert_contiguous(weight);
+    megdnn_assert(
+            weight.dtype.category() == DTypeCategory::FLOAT,
+            "EmbeddingBag only supports float weight, got %s", weight.dtype.name());
+    auto required_workspace_in_bytes =
+            get_workspace_in_bytes(weight, index, offsets, dst);
+    megdnn_assert(workspace_in_bytes >= required_workspace_in_bytes);
+}
+
+void EmbeddingBagBackward::deduce_layout(
+        const TensorLayout& diff, const TensorLayout& index,
+        const TensorLayout& offsets, TensorLayout& grad) {
+    megdnn_assert(
+            diff.ndim == 2, "EmbeddingBag diff must be 2-dimensional, got %s",
+            diff.to_string().c_str());
+    size_t nr_bags = check_index_offsets(index, offsets);
+    megdnn_assert(
+            diff.shape[0] == nr_bags,
+            "EmbeddingBag diff has %zu rows, but there are %zu bags", diff.shape[0],
+            nr_bags);
+    grad = TensorLayout{TensorShape{index.shape[0], diff.shape[1]}, diff.dtype};
+}
+
+void EmbeddingBagBackward::check_exec(
+        const TensorLayout& diff, const TensorLayout& index,
+        const TensorLayout& offsets, const TensorLayout& grad,
+        size_t workspace_in_bytes) {
+    TensorLayout grad_expected;
+    megdnn_assert_eq_dtype(diff, grad);
+    deduce_layout(diff, index, offsets, grad_expected);
+    megdnn_assert_eq_layout(grad_expected, grad);
+    megdnn_assert_contiguous(diff);
+    megdnn_assert(
+            diff.dtype.category() == DTypeCategory::FLOAT,
+            "EmbeddingBag only supports float diff, got %s", diff.dtype.name());
+    auto required_workspace_in_bytes =
+            get_workspace_in_bytes(diff, index, offsets, grad);
+    megdnn_assert(workspace_in_bytes >= required_workspace_in_bytes);
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,80 @@
+/**
+ * \file dnn/src/common/embedding_bag_helper.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#pragma once
+
+#include "megdnn/oprs.h"
+
+#include "src/common/utils.h"
+
+namespace megdnn {
+namespace embedding_bag {
+
+//! workspace needed to hold the bag bounds computed by get_bag_bounds()
+inline size_t get_bounds_workspace_in_bytes(const TensorLayout& offsets) {
+    return (offsets.shape[0] + 1) * sizeof(size_t);
+}
+
+/*!
+ * \brief convert the offsets input to nr_bags + 1 bounds, so that bag i spans
+ *      index[bounds[i]:bounds[i+1]]
+ */
+inline void get_bag_bounds(
+        const dt_int32* offsets, size_t nr_bags, size_t nnz, bool lengths,
+        size_t* bounds) {
+    if (lengths) {
+        size_t acc = 0;
+        for (size_t i = 0; i < nr_bags; ++i) {
+            megdnn_assert(
+                    offsets[i] >= 0, "bad length of bag %zu in EmbeddingBag: %d", i,
+                    offsets[i]);
+            bounds[i] = acc;
+            acc += offsets[i];
+        }
+        megdnn_assert(
+                acc == nnz,
+                "total length of bags in EmbeddingBag is %zu, but there are %zu "
+                "indices",
+                acc, nnz);
+        bounds[nr_bags] = acc;
+    } else {
+        for (size_t i = 0; i < nr_bags; ++i) {
+            bounds[i] = offsets[i];
+            megdnn_assert(
+                    offsets[i] >= 0 && bounds[i] <= nnz &&
+                            (!i || bounds[i - 1] <= bounds[i]),
+                    "bad offset of bag %zu in EmbeddingBag: %d (nr_index=%zu)", i,
+                    offsets[i], nnz);
+        }
+        bounds[nr_bags] = nnz;
+    }
+}
+
+//! check a row index read from the index input
+inline void check_row(dt_int32 row, size_t num_embeddings) {
+    megdnn_assert(
+            row >= 0 && static_cast<size_t>(row) < num_embeddings,
+            "bad value in EmbeddingBag index: num_embeddings is %zu, index value is "
+            "%d",
+            num_embeddings, row);
+}
+
+//! scale applied to each row of a bag with given size
+inline float get_bag_scale(param::EmbeddingBag::Mode mode, size_t bag_size) {
+    if (mode == param::EmbeddingBag::Mode::MEAN && bag_size) {
+        return 1.f / static_cast<float>(bag_size);
+    }
+    return 1.f;
+}
+
+}  // namespace embedding_bag
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
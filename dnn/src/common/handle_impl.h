@@ -135,6 +135,8 @@ private:
     cb(ChecksumForward) \
     cb(IndexingOneHotForward) \
     cb(IndexingSetOneHotForward) \
+    cb(EmbeddingBagForward) \
+    cb(EmbeddingBagBackward) \
     cb(IndexingMultiAxisVec) \
     cb(IndexingSetMultiAxisVec) \
     cb(IndexingIncrMultiAxisVec) \
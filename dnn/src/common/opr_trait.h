@@ -99,6 +99,8 @@ DEF(Resize, 2, true, false);
 DEF(ResizeBackward, 2, true, false);
 DEF(IndexingOneHot, 3, true, true);
 DEF(IndexingSetOneHot, 3, true, false);
+DEF(EmbeddingBagForward, 4, true, true);
+DEF(EmbeddingBagBackward, 4, true, true);
 DEF(MaskConvolution, 4, true, true);
 DEF(MaskPropagate, 2, true, true);
 DEF(RelayoutFormat, 2, true, true);
@@ -0,0 +1,180 @@
+/**
+ * \file dnn/src/fallback/cond_take/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "src/fallback/cond_take/opr_impl.h"
+#include "src/common/cond_take/predicate.cuh"
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+
+using namespace megdnn;
+using namespace fallback;
+using namespace cond_take;
+
+using Param = CondTake::Param;
+
+namespace {
+
+//! number of elements processed by one task
+constexpr size_t BLOCK = 16384;
+
+size_t get_nr_blocks(size_t size) {
+    return div_ceil(size, BLOCK);
+}
+
+template <typename ctype>
+void gather_data(
+        size_t begin, size_t end, const dt_int32* idx, ctype* dest,
+        const ctype* src) {
+    for (size_t i = begin; i < end; ++i) {
+        dest[i] = src[idx[i]];
+    }
+}
+
+}  // anonymous namespace
+
+size_t CondTakeImpl::get_workspace_in_bytes(const TensorLayout& data) {
+    return (get_nr_blocks(data.total_nr_elems()) + 1) * sizeof(size_t);
+}
+
+CondTakeImpl::Output CondTakeImpl::exec(
+        _megdnn_tensor_in data, _megdnn_tensor_in mask, _megdnn_workspace workspace,
+        DynOutMallocPolicyCall malloc_policy) {
+    auto size = check_exec_get_size(data.layout, mask.layout, workspace.size);
+    auto nr_blocks = get_nr_blocks(size);
+    auto counts = workspace.ptr<size_t>();
+
+    if (size) {
+        switch (mask.layout.dtype.enumv()) {
+#define cb(_dt)                                    \
+    case DTypeTrait<_dt>::enumv: {                 \
+        using ctype = DTypeTrait<_dt>::ctype;      \
+        dispatch_count<ctype>(size, counts, mask); \
+        break;                                     \
+    }
+            MEGDNN_FOREACH_COMPUTING_DTYPE(cb)
+            cb(::megdnn::dtype::Bool)
+#undef cb
+            default:
+                megdnn_throw("bad mask dtype");
+        }
+    }
+
+    // convert per-block counts to output offsets
+    auto handle = static_cast<naive::HandleImpl*>(this->handle());
+    handle->megcore_dispatcher()->sync();
+    size_t out_size = 0;
+    for (size_t i = 0; i < nr_blocks; ++i) {
+        size_t cnt = counts[i];
+        counts[i] = out_size;
+        out_size += cnt;
+    }
+    counts[nr_blocks] = out_size;
+
+    auto out_data = malloc_policy.alloc_output(0, data.layout.dtype, {out_size});
+    auto out_idx = malloc_policy.alloc_output(1, dtype::Int32(), {out_size});
+    if (!out_size) {
+        return {{out_data, out_idx}};
+    }
+
+    switch (mask.layout.dtype.enumv()) {
+#define cb(_dt)                                                 \
+    case DTypeTrait<_dt>::enumv: {                              \
+        using ctype = DTypeTrait<_dt>::ctype;                   \
+        dispatch_write_idx<ctype>(size, counts, mask, out_idx); \
+        break;                                                  \
+    }
+        MEGDNN_FOREACH_COMPUTING_DTYPE(cb)
+        cb(::megdnn::dtype::Bool)
+#undef cb
+        default:
+            megdnn_throw("bad mask dtype");
+    }
+
+    size_t nr_gather = get_nr_blocks(out_size);
+    switch (data.layout.dtype.enumv()) {
+#define cb(_dt)                                                             \
+    case DTypeTrait<_dt>::enumv: {                                          \
+        using ctype = DTypeTrait<_dt>::ctype;                               \
+        auto kern = [=](size_t block, size_t) {                             \
+            gather_data<ctype>(                                             \
+                    block * BLOCK, std::min(out_size, (block + 1) * BLOCK), \
+                    out_idx.ptr<dt_int32>(), out_data.ptr<ctype>(),         \
+                    data.ptr<ctype>());                                     \
+        };                                                                  \
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(handle, nr_gather, kern);     \
+        break;                                                              \
+    }
+        MEGDNN_FOREACH_COMPUTING_DTYPE(cb)
+        cb(::megdnn::dtype::Bool)
+#undef cb
+        default:
+            megdnn_throw("bad data dtype");
+    }
+
+    return {{out_data, out_idx}};
+}
+
+template <typename ctype>
+void CondTakeImpl::dispatch_count(size_t size, size_t* counts, const TensorND& mask) {
+    auto handle = static_cast<naive::HandleImpl*>(this->handle());
+    KParam kparam(m_param);
+    switch (m_param.mode) {
+#define cb(_m)                                                                    \
+    case Param::Mode::_m: {                                                       \
+        Pred<PEnum::_m, ctype> pred(kparam);                                      \
+        auto kern = [=](size_t block, size_t) {                                   \
+            auto inp = mask.ptr<ctype>();                                         \
+            size_t cnt = 0;                                                       \
+            for (size_t i = block * BLOCK, end = std::min(size, i + BLOCK);       \
+                 i < end; ++i) {                                                  \
+                cnt += pred(inp[i]);                                              \
+            }                                                                     \
+            counts[block] = cnt;                                                  \
+        };                                                                        \
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(handle, get_nr_blocks(size), kern); \
+        return;                                                                   \
+    }
+        MEGDNN_FOREACH_COND_TAKE_MODE(cb)
+#undef cb
+    }
+    megdnn_assert_internal(0);
+}
+
+template <typename ctype>
+void CondTakeImpl::dispatch_write_idx(
+        size_t size, const size_t* offsets, const TensorND& mask,
+        const TensorND& out_idx) {
+    auto handle = static_cast<naive::HandleImpl*>(this->handle());
+    KParam kparam(m_param);
+    switch (m_param.mode) {
+#define cb(_m)                                                                    \
+    case Param::Mode::_m: {                                                       \
+        Pred<PEnum::_m, ctype> pred(kparam);                                      \
+        auto kern = [=](size_t block, size_t) {                                   \
+            auto inp = mask.ptr<ctype>();                                         \
+            auto dest = out_idx.ptr<dt_int32>() + offsets[block];                 \
+            for (size_t i = block * BLOCK, end = std::min(size, i + BLOCK);       \
+                 i < end; ++i) {                                                  \
+                if (pred(inp[i])) {                                               \
+                    *dest++ = i;                                                  \
+                }                                                                 \
+            }                                                                     \
+        };                                                                        \
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(handle, get_nr_blocks(size), kern); \
+        return;                                                                   \
+    }
+        MEGDNN_FOREACH_COND_TAKE_MODE(cb)
+#undef cb
+    }
+    megdnn_assert_internal(0);
+}
+
+// vim: syntax=cpp.doxygen
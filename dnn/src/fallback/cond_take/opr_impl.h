@@ -0,0 +1,47 @@
+/**
+ * \file dnn/src/fallback/cond_take/opr_impl.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#pragma once
+
+#include "src/naive/cond_take/opr_impl.h"
+
+namespace megdnn {
+namespace fallback {
+
+/*!
+ * \brief multi-threaded cond_take as a block-wise stream compaction
+ *
+ * The input is split into fixed-size blocks; the matched elements of each
+ * block are counted in parallel, a prefix sum over the counts gives the output
+ * offset of every block, and then the indices and data are written in
+ * parallel.
+ */
+class CondTakeImpl : public naive::CondTakeImpl {
+    template <typename ctype>
+    void dispatch_count(size_t size, size_t* counts, const TensorND& mask);
+    template <typename ctype>
+    void dispatch_write_idx(
+            size_t size, const size_t* offsets, const TensorND& mask,
+            const TensorND& out_idx);
+
+public:
+    using naive::CondTakeImpl::CondTakeImpl;
+
+    size_t get_workspace_in_bytes(const TensorLayout& data) override;
+
+    Output exec(
+            _megdnn_tensor_in data, _megdnn_tensor_in mask, _megdnn_workspace workspace,
+            DynOutMallocPolicyCall malloc_policy) override;
+};
+
+}  // namespace fallback
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
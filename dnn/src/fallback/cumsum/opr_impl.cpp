@@ -0,0 +1,238 @@
+/**
+ * \file dnn/src/fallback/cumsum/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "src/fallback/cumsum/opr_impl.h"
+
+#include "src/common/reduce_helper.h"
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+
+using namespace megdnn;
+using namespace fallback;
+
+namespace {
+
+//! max number of elements on the inner dimension handled by one scan line
+constexpr size_t CBLOCK = 256;
+//! number of rows on the scan axis in one chunk of the two-pass scan
+constexpr size_t CHUNK = 4096;
+
+/*!
+ * \brief how the (A, B, C) view of the input is split into tasks
+ *
+ * A scan line is one index on A and at most CBLOCK consecutive indices on C;
+ * it is scanned along B either by a single task, or by nr_chunks tasks in the
+ * two-pass mode.
+ */
+struct ScanPlan {
+    size_t A, B, C, cblock, nr_cblocks, chunk, nr_chunks;
+
+    ScanPlan(const TensorLayout& layout, size_t axis, size_t nr_threads) {
+        reduce::get_ABC(layout, A, B, C, axis);
+        cblock = std::max<size_t>(1, std::min(C, CBLOCK));
+        nr_cblocks = div_ceil(C, cblock);
+        chunk = B;
+        nr_chunks = 1;
+        if (nr_threads > 1 && B > CHUNK && nr_lines() < nr_threads * 2) {
+            chunk = CHUNK;
+            nr_chunks = div_ceil(B, CHUNK);
+        }
+    }
+
+    size_t nr_lines() const { return A * nr_cblocks; }
+
+    //! number of carry elements needed in workspace
+    size_t nr_carry() const {
+        return nr_chunks > 1 ? nr_lines() * nr_chunks * cblock : 0;
+    }
+
+    //! offset of the first element of a line
+    size_t line_offset(size_t line) const {
+        return line / nr_cblocks * B * C + line % nr_cblocks * cblock;
+    }
+
+    //! number of elements of a line on C
+    size_t line_width(size_t line) const {
+        return std::min(cblock, C - line % nr_cblocks * cblock);
+    }
+};
+
+/*!
+ * \brief scan rows [b0, b1) of a line whose row stride is C, starting from the
+ *      given carry (zero if carry is null)
+ */
+template <typename T, bool exclusive, bool reverse>
+void scan_range(
+        const T* src, T* dst, size_t C, size_t b0, size_t b1, size_t cw,
+        const T* carry) {
+    size_t n = b1 - b0;
+    auto row = [b0, b1](size_t i) { return reverse ? b1 - 1 - i : b0 + i; };
+    if (cw == 1) {
+        T sum = carry ? carry[0] : T(0);
+        for (size_t i = 0; i < n; ++i) {
+            size_t b = row(i) * C;
+            T x = src[b];
+            if (exclusive) {
+                dst[b] = sum;
+                sum += x;
+            } else {
+                sum += x;
+                dst[b] = sum;
+            }
+        }
+        return;
+    }
+
+    {
+        const T* __restrict sp = src + row(0) * C;
+        T* __restrict dp = dst + row(0) * C;
+        for (size_t c = 0; c < cw; ++c) {
+            dp[c] = exclusive ? T(0) : sp[c];
+        }
+        if (carry) {
+            for (size_t c = 0; c < cw; ++c) {
+                dp[c] += carry[c];
+            }
+        }
+    }
+    for (size_t i = 1; i < n; ++i) {
+        size_t b = row(i), prev = row(i - 1);
+        const T* __restrict sp = src + (exclusive ? prev : b) * C;
+        const T* __restrict prev_dp = dst + prev * C;
+        T* __restrict dp = dst + b * C;
+        for (size_t c = 0; c < cw; ++c) {
+            dp[c] = prev_dp[c] + sp[c];
+        }
+    }
+}
+
+//! sum of rows [b0, b1) of a line
+template <typename T>
+void sum_range(const T* src, size_t C, size_t b0, size_t b1, size_t cw, T* sum) {
+    for (size_t c = 0; c < cw; ++c) {
+        sum[c] = T(0);
+    }
+    for (size_t b = b0; b < b1; ++b) {
+        const T* __restrict sp = src + b * C;
+        for (size_t c = 0; c < cw; ++c) {
+            sum[c] += sp[c];
+        }
+    }
+}
+
+template <typename T, bool exclusive, bool reverse>
+void run_scan(
+        naive::HandleImpl* handle, const TensorND& src, const TensorND& dst,
+        T* carry_ws, const ScanPlan& plan) {
+    auto p = plan;
+    if (p.nr_chunks == 1) {
+        auto kern = [p, src, dst](size_t line, size_t) {
+            size_t off = p.line_offset(line);
+            scan_range<T, exclusive, reverse>(
+                    src.ptr<T>() + off, dst.ptr<T>() + off, p.C, 0, p.B,
+                    p.line_width(line), nullptr);
+        };
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(handle, p.nr_lines(), kern);
+        return;
+    }
+
+    // pass 1: sum of each chunk
+    auto sum_kern = [p, src, carry_ws](size_t task, size_t) {
+        size_t line = task / p.nr_chunks, chunk = task % p.nr_chunks;
+        sum_range<T>(
+                src.ptr<T>() + p.line_offset(line), p.C, chunk * p.chunk,
+                std::min(p.B, (chunk + 1) * p.chunk), p.line_width(line),
+                carry_ws + task * p.cblock);
+    };
+    MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(
+            handle, p.nr_lines() * p.nr_chunks, sum_kern);
+
+    // convert chunk sums of each line to carries in scan order
+    auto carry_kern = [p, carry_ws](size_t line, size_t) {
+        T* ws = carry_ws + line * p.nr_chunks * p.cblock;
+        for (size_t c = 0, cw = p.line_width(line); c < cw; ++c) {
+            T acc = T(0);
+            for (size_t k = 0; k < p.nr_chunks; ++k) {
+                size_t chunk = reverse ? p.nr_chunks - 1 - k : k;
+                T& v = ws[chunk * p.cblock + c];
+                T sum = v;
+                v = acc;
+                acc += sum;
+            }
+        }
+    };
+    MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(handle, p.nr_lines(), carry_kern);
+
+    // pass 2: scan each chunk from its carry
+    auto scan_kern = [p, src, dst, carry_ws](size_t task, size_t) {
+        size_t line = task / p.nr_chunks, chunk = task % p.nr_chunks;
+        size_t off = p.line_offset(line);
+        scan_range<T, exclusive, reverse>(
+                src.ptr<T>() + off, dst.ptr<T>() + off, p.C, chunk * p.chunk,
+                std::min(p.B, (chunk + 1) * p.chunk), p.line_width(line),
+                carry_ws + task * p.cblock);
+    };
+    MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(
+            handle, p.nr_lines() * p.nr_chunks, scan_kern);
+}
+
+template <typename T>
+void dispatch_scan(
+        naive::HandleImpl* handle, const TensorND& src, const TensorND& dst,
+        T* carry_ws, const ScanPlan& plan, bool exclusive, bool reverse) {
+#define cb(_exclusive, _reverse)                                                    \
+    if (exclusive == _exclusive && reverse == _reverse) {                           \
+        return run_scan<T, _exclusive, _reverse>(handle, src, dst, carry_ws, plan); \
+    }
+    cb(false, false);
+    cb(false, true);
+    cb(true, false);
+    cb(true, true);
+#undef cb
+}
+
+}  // anonymous namespace
+
+size_t CumsumForwardImpl::nr_threads() {
+    return static_cast<naive::HandleImpl*>(handle())
+            ->megcore_dispatcher()
+            ->nr_threads();
+}
+
+size_t CumsumForwardImpl::get_workspace_in_bytes(
+        const TensorLayout& src, const TensorLayout&) {
+    if (!src.total_nr_elems()) {
+        return 0;
+    }
+    ScanPlan plan{src, static_cast<size_t>(param().axis), nr_threads()};
+    return plan.nr_carry() * src.dtype.size();
+}
+
+void CumsumForwardImpl::exec(
+        _megdnn_tensor_in src, _megdnn_tensor_out dst, _megdnn_workspace workspace) {
+    check_exec(src.layout, dst.layout, workspace.size);
+    if (!src.layout.total_nr_elems()) {
+        return;
+    }
+    auto handle = static_cast<naive::HandleImpl*>(this->handle());
+    ScanPlan plan{src.layout, static_cast<size_t>(param().axis), nr_threads()};
+#define cb(DType)                                                                  \
+    if (src.layout.dtype == DType()) {                                             \
+        using ctype = DTypeTrait<DType>::ctype;                                    \
+        return dispatch_scan<ctype>(                                               \
+                handle, src, dst, workspace.ptr<ctype>(), plan, param().exclusive, \
+                param().reverse);                                                  \
+    }
+    MEGDNN_FOREACH_COMPUTING_DTYPE(cb)
+#undef cb
+    naive::CumsumForwardImpl::exec(src, dst, workspace);
+}
+
+// vim: syntax=cpp.doxygen
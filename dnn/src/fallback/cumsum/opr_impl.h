@@ -0,0 +1,43 @@
+/**
+ * \file dnn/src/fallback/cumsum/opr_impl.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#pragma once
+
+#include "src/naive/cumsum/opr_impl.h"
+
+namespace megdnn {
+namespace fallback {
+
+/*!
+ * \brief multi-threaded cumsum
+ *
+ * Independent scan lines are distributed over the worker threads, with the
+ * inner dimension processed as vectors. When there are too few lines to keep
+ * all threads busy, the scan axis is split into chunks and scanned in two
+ * passes: chunk sums are computed in parallel, converted to carries, and then
+ * each chunk is scanned in parallel starting from its carry.
+ */
+class CumsumForwardImpl : public naive::CumsumForwardImpl {
+public:
+    using naive::CumsumForwardImpl::CumsumForwardImpl;
+    void exec(
+            _megdnn_tensor_in src, _megdnn_tensor_out dst,
+            _megdnn_workspace workspace) override;
+    size_t get_workspace_in_bytes(
+            const TensorLayout& src, const TensorLayout& dst) override;
+
+private:
+    size_t nr_threads();
+};
+
+}  // namespace fallback
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
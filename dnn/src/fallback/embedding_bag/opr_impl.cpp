@@ -0,0 +1,143 @@
+/**
+ * \file dnn/src/fallback/embedding_bag/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "src/fallback/embedding_bag/opr_impl.h"
+
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+
+#include <cstring>
+
+using namespace megdnn;
+using namespace fallback;
+using namespace embedding_bag;
+
+namespace {
+
+//! number of bags processed by a single task, so that each task touches
+//! roughly the same amount of output
+size_t get_bags_per_task(size_t dim) {
+    constexpr size_t TASK_ELEMS = 1024;
+    return std::max<size_t>(1, TASK_ELEMS / std::max<size_t>(dim, 1));
+}
+
+void forward_bag(
+        const float* weight, const dt_int32* index, const size_t* bounds,
+        float* __restrict dst, size_t num_embeddings, size_t dim,
+        param::EmbeddingBag::Mode mode) {
+    size_t begin = bounds[0], end = bounds[1];
+    if (begin == end) {
+        memset(dst, 0, sizeof(float) * dim);
+        return;
+    }
+    check_row(index[begin], num_embeddings);
+    memcpy(dst, weight + index[begin] * dim, sizeof(float) * dim);
+    for (size_t j = begin + 1; j < end; ++j) {
+        check_row(index[j], num_embeddings);
+        const float* __restrict row = weight + index[j] * dim;
+        for (size_t c = 0; c < dim; ++c) {
+            dst[c] += row[c];
+        }
+    }
+    float scale = get_bag_scale(mode, end - begin);
+    if (scale != 1.f) {
+        for (size_t c = 0; c < dim; ++c) {
+            dst[c] *= scale;
+        }
+    }
+}
+
+void backward_bag(
+        const float* __restrict diff, const size_t* bounds, float* grad, size_t dim,
+        param::EmbeddingBag::Mode mode) {
+    size_t begin = bounds[0], end = bounds[1];
+    float scale = get_bag_scale(mode, end - begin);
+    for (size_t j = begin; j < end; ++j) {
+        float* __restrict row = grad + j * dim;
+        if (scale == 1.f) {
+            memcpy(row, diff, sizeof(float) * dim);
+        } else {
+            for (size_t c = 0; c < dim; ++c) {
+                row[c] = diff[c] * scale;
+            }
+        }
+    }
+}
+
+}  // anonymous namespace
+
+void EmbeddingBagForwardImpl::exec(
+        _megdnn_tensor_in weight, _megdnn_tensor_in index, _megdnn_tensor_in offsets,
+        _megdnn_tensor_out dst, _megdnn_workspace workspace) {
+    if (weight.layout.dtype != dtype::Float32()) {
+        return naive::EmbeddingBagForwardImpl::exec(
+                weight, index, offsets, dst, workspace);
+    }
+    check_exec(weight.layout, index.layout, offsets.layout, dst.layout, workspace.size);
+    size_t num_embeddings = weight.layout[0], dim = weight.layout[1],
+           nnz = index.layout[0], nr_bags = offsets.layout[0];
+    if (!nr_bags) {
+        return;
+    }
+    auto bounds = workspace.ptr<size_t>();
+    auto mode = param().mode;
+    bool lengths = param().lengths;
+    MEGDNN_DISPATCH_CPU_KERN_OPR(
+            get_bag_bounds(offsets.ptr<dt_int32>(), nr_bags, nnz, lengths, bounds));
+
+    size_t bags_per_task = get_bags_per_task(dim);
+    auto run = [=](size_t task_id, size_t) {
+        const float* wptr = weight.ptr<dt_float32>();
+        const dt_int32* iptr = index.ptr<dt_int32>();
+        float* dptr = dst.ptr<dt_float32>();
+        size_t bag_end = std::min(nr_bags, (task_id + 1) * bags_per_task);
+        for (size_t bag = task_id * bags_per_task; bag < bag_end; ++bag) {
+            forward_bag(
+                    wptr, iptr, bounds + bag, dptr + bag * dim, num_embeddings, dim,
+                    mode);
+        }
+    };
+    MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN_OPR(run, div_ceil(nr_bags, bags_per_task));
+}
+
+void EmbeddingBagBackwardImpl::exec(
+        _megdnn_tensor_in diff, _megdnn_tensor_in index, _megdnn_tensor_in offsets,
+        _megdnn_tensor_out grad, _megdnn_workspace workspace) {
+    if (diff.layout.dtype != dtype::Float32()) {
+        return naive::EmbeddingBagBackwardImpl::exec(
+                diff, index, offsets, grad, workspace);
+    }
+    check_exec(diff.layout, index.layout, offsets.layout, grad.layout, workspace.size);
+    size_t dim = diff.layout[1], nnz = index.layout[0], nr_bags = offsets.layout[0];
+    auto bounds = workspace.ptr<size_t>();
+    auto mode = param().mode;
+    bool lengths = param().lengths;
+    MEGDNN_DISPATCH_CPU_KERN_OPR({
+        get_bag_bounds(offsets.ptr<dt_int32>(), nr_bags, nnz, lengths, bounds);
+        // lookups that belong to no bag receive no gradient
+        memset(grad.ptr<dt_float32>(), 0, sizeof(float) * bounds[0] * dim);
+    });
+    if (!nr_bags) {
+        return;
+    }
+
+    size_t bags_per_task = get_bags_per_task(dim);
+    auto run = [=](size_t task_id, size_t) {
+        const float* dptr = diff.ptr<dt_float32>();
+        float* gptr = grad.ptr<dt_float32>();
+        size_t bag_end = std::min(nr_bags, (task_id + 1) * bags_per_task);
+        for (size_t bag = task_id * bags_per_task; bag < bag_end; ++bag) {
+            backward_bag(dptr + bag * dim, bounds + bag, gptr, dim, mode);
+        }
+    };
+    MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN_OPR(run, div_ceil(nr_bags, bags_per_task));
+}
+
+// vim: syntax=cpp.doxygen
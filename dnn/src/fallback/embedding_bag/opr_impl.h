@@ -0,0 +1,42 @@
+/**
+ * \file dnn/src/fallback/embedding_bag/opr_impl.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#pragma once
+
+#include "src/naive/embedding_bag/opr_impl.h"
+
+namespace megdnn {
+namespace fallback {
+
+/*!
+ * \brief float32 EmbeddingBag that streams each looked up row directly into
+ *      the output of its bag, with bags distributed over the worker threads
+ */
+class EmbeddingBagForwardImpl : public naive::EmbeddingBagForwardImpl {
+public:
+    using naive::EmbeddingBagForwardImpl::EmbeddingBagForwardImpl;
+    void exec(
+            _megdnn_tensor_in weight, _megdnn_tensor_in index,
+            _megdnn_tensor_in offsets, _megdnn_tensor_out dst,
+            _megdnn_workspace workspace) override;
+};
+
+class EmbeddingBagBackwardImpl : public naive::EmbeddingBagBackwardImpl {
+public:
+    using naive::EmbeddingBagBackwardImpl::EmbeddingBagBackwardImpl;
+    void exec(
+            _megdnn_tensor_in diff, _megdnn_tensor_in index, _megdnn_tensor_in offsets,
+            _megdnn_tensor_out grad, _megdnn_workspace workspace) override;
+};
+
+}  // namespace fallback
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
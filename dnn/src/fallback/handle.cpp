@@ -15,10 +15,13 @@
 #include "src/fallback/add_update/opr_impl.h"
 #include "src/fallback/batched_matrix_mul/opr_impl.h"
 #include "src/fallback/concat/opr_impl.h"
+#include "src/fallback/cond_take/opr_impl.h"
 #include "src/fallback/conv_bias/opr_impl.h"
 #include "src/fallback/convolution/opr_impl.h"
+#include "src/fallback/cumsum/opr_impl.h"
 #include "src/fallback/elemwise/opr_impl.h"
 #include "src/fallback/elemwise_multi_type/opr_impl.h"
+#include "src/fallback/embedding_bag/opr_impl.h"
 #include "src/fallback/flip/opr_impl.h"
 #include "src/fallback/gaussian_blur/opr_impl.h"
 #include "src/fallback/group_local/opr_impl.h"
@@ -70,6 +73,10 @@ MEGDNN_SPECIALIZE_CREATE_OPERATOR(Resize)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(BatchedMatrixMulForward)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(ConvBias)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(PowC)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(EmbeddingBagForward)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(EmbeddingBagBackward)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(CumsumForward)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(CondTake)
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpragmas"
@@ -0,0 +1,106 @@
+/**
+ * \file dnn/src/naive/embedding_bag/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "src/naive/embedding_bag/opr_impl.h"
+
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+
+using namespace megdnn;
+using namespace naive;
+using namespace embedding_bag;
+
+namespace {
+
+template <typename ctype>
+void forward(
+        const ctype* weight, const dt_int32* index, const dt_int32* offsets,
+        ctype* dst, size_t* bounds, size_t num_embeddings, size_t dim, size_t nnz,
+        size_t nr_bags, const param::EmbeddingBag& param) {
+    get_bag_bounds(offsets, nr_bags, nnz, param.lengths, bounds);
+    for (size_t bag = 0; bag < nr_bags; ++bag) {
+        float scale = get_bag_scale(param.mode, bounds[bag + 1] - bounds[bag]);
+        for (size_t c = 0; c < dim; ++c) {
+            float acc = 0;
+            for (size_t j = bounds[bag]; j < bounds[bag + 1]; ++j) {
+                check_row(index[j], num_embeddings);
+                acc += static_cast<float>(weight[index[j] * dim + c]);
+            }
+            dst[bag * dim + c] = static_cast<ctype>(acc * scale);
+        }
+    }
+}
+
+template <typename ctype>
+void backward(
+        const ctype* diff, const dt_int32* index, const dt_int32* offsets,
+        ctype* grad, size_t* bounds, size_t dim, size_t nnz, size_t nr_bags,
+        const param::EmbeddingBag& param) {
+    get_bag_bounds(offsets, nr_bags, nnz, param.lengths, bounds);
+    // lookups that belong to no bag receive no gradient
+    for (size_t j = 0; j < bounds[0]; ++j) {
+        for (size_t c = 0; c < dim; ++c) {
+            grad[j * dim + c] = static_cast<ctype>(0.f);
+        }
+    }
+    for (size_t bag = 0; bag < nr_bags; ++bag) {
+        float scale = get_bag_scale(param.mode, bounds[bag + 1] - bounds[bag]);
+        for (size_t j = bounds[bag]; j < bounds[bag + 1]; ++j) {
+            for (size_t c = 0; c < dim; ++c) {
+                grad[j * dim + c] = static_cast<ctype>(
+                        static_cast<float>(diff[bag * dim + c]) * scale);
+            }
+        }
+    }
+}
+
+}  // anonymous namespace
+
+void EmbeddingBagForwardImpl::exec(
+        _megdnn_tensor_in weight, _megdnn_tensor_in index, _megdnn_tensor_in offsets,
+        _megdnn_tensor_out dst, _megdnn_workspace workspace) {
+    check_exec(weight.layout, index.layout, offsets.layout, dst.layout, workspace.size);
+    size_t num_embeddings = weight.layout[0], dim = weight.layout[1],
+           nnz = index.layout[0], nr_bags = offsets.layout[0];
+    auto bounds = workspace.ptr<size_t>();
+#define cb(DType)                                                                    \
+    if (weight.layout.dtype == DType()) {                                            \
+        using ctype = typename DTypeTrait<DType>::ctype;                             \
+        MEGDNN_DISPATCH_CPU_KERN_OPR(forward<ctype>(                                 \
+                weight.ptr<ctype>(), index.ptr<dt_int32>(), offsets.ptr<dt_int32>(), \
+                dst.ptr<ctype>(), bounds, num_embeddings, dim, nnz, nr_bags,         \
+                param()));                                                           \
+        return;                                                                      \
+    }
+    MEGDNN_FOREACH_COMPUTING_DTYPE_FLOAT(cb)
+#undef cb
+    megdnn_throw("bad dtype for EmbeddingBag");
+}
+
+void EmbeddingBagBackwardImpl::exec(
+        _megdnn_tensor_in diff, _megdnn_tensor_in index, _megdnn_tensor_in offsets,
+        _megdnn_tensor_out grad, _megdnn_workspace workspace) {
+    check_exec(diff.layout, index.layout, offsets.layout, grad.layout, workspace.size);
+    size_t dim = diff.layout[1], nnz = index.layout[0], nr_bags = offsets.layout[0];
+    auto bounds = workspace.ptr<size_t>();
+#define cb(DType)                                                                  \
+    if (diff.layout.dtype == DType()) {                                            \
+        using ctype = typename DTypeTrait<DType>::ctype;                           \
+        MEGDNN_DISPATCH_CPU_KERN_OPR(backward<ctype>(                              \
+                diff.ptr<ctype>(), index.ptr<dt_int32>(), offsets.ptr<dt_int32>(), \
+                grad.ptr<ctype>(), bounds, dim, nnz, nr_bags, param()));           \
+        return;                                                                    \
+    }
+    MEGDNN_FOREACH_COMPUTING_DTYPE_FLOAT(cb)
+#undef cb
+    megdnn_throw("bad dtype for EmbeddingBagBackward");
+}
+
+// vim: syntax=cpp.doxygen
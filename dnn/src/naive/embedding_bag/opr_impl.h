@@ -0,0 +1,49 @@
+/**
+ * \file dnn/src/naive/embedding_bag/opr_impl.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#pragma once
+#include "megdnn/oprs.h"
+
+#include "src/common/embedding_bag_helper.h"
+
+namespace megdnn {
+namespace naive {
+
+class EmbeddingBagForwardImpl : public EmbeddingBagForward {
+public:
+    using EmbeddingBagForward::EmbeddingBagForward;
+    void exec(
+            _megdnn_tensor_in weight, _megdnn_tensor_in index,
+            _megdnn_tensor_in offsets, _megdnn_tensor_out dst,
+            _megdnn_workspace workspace) override;
+    size_t get_workspace_in_bytes(
+            const TensorLayout&, const TensorLayout&, const TensorLayout& offsets,
+            const TensorLayout&) override {
+        return embedding_bag::get_bounds_workspace_in_bytes(offsets);
+    }
+};
+
+class EmbeddingBagBackwardImpl : public EmbeddingBagBackward {
+public:
+    using EmbeddingBagBackward::EmbeddingBagBackward;
+    void exec(
+            _megdnn_tensor_in diff, _megdnn_tensor_in index, _megdnn_tensor_in offsets,
+            _megdnn_tensor_out grad, _megdnn_workspace workspace) override;
+    size_t get_workspace_in_bytes(
+            const TensorLayout&, const TensorLayout&, const TensorLayout& offsets,
+            const TensorLayout&) override {
+        return embedding_bag::get_bounds_workspace_in_bytes(offsets);
+    }
+};
+
+}  // namespace naive
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
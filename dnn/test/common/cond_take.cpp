@@ -37,6 +37,11 @@ std::vector<CondTakeTestcase> CondTakeTestcase::make() {
                 TensorLayout{{1024}, dtype::Float32()},
                 TensorLayout{{1024}, dtype::Int32()},
         });
+        ret.push_back({
+                Param{static_cast<Param::Mode>(mode), 100},
+                TensorLayout{{3, 33333}, dtype::Float32()},
+                TensorLayout{{3, 33333}, dtype::Int32()},
+        });
     }
 
     NormalRNG data_rng;
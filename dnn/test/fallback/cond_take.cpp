@@ -0,0 +1,44 @@
+/**
+ * \file dnn/test/fallback/cond_take.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "test/common/cond_take.h"
+#include "test/common/checker.h"
+#include "test/common/utils.h"
+#include "test/fallback/fixture.h"
+
+using namespace megdnn;
+using namespace test;
+
+namespace {
+void run_cond_take_test(Handle* handle) {
+    auto handle_naive = create_cpu_handle(2, false);
+    auto opr_naive = handle_naive->create_operator<CondTake>();
+    auto opr = handle->create_operator<CondTake>();
+
+    size_t tot_size = 0;
+    for (auto&& i : CondTakeTestcase::make()) {
+        auto ret_naive = i.run(opr_naive.get()), ret = i.run(opr.get());
+        MEGDNN_ASSERT_TENSOR_EQ(*ret_naive.first, *ret.first);
+        MEGDNN_ASSERT_TENSOR_EQ(*ret_naive.second, *ret.second);
+        tot_size += ret_naive.first->layout.total_nr_elems();
+    }
+    ASSERT_GT(tot_size, (size_t)0);
+}
+}  // namespace
+
+TEST_F(FALLBACK, COND_TAKE) {
+    run_cond_take_test(handle());
+}
+
+TEST_F(FALLBACK_MULTI_THREADS, COND_TAKE) {
+    run_cond_take_test(handle());
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,62 @@
+/**
+ * \file dnn/test/fallback/cumsum.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "test/common/checker.h"
+#include "test/common/rng.h"
+#include "test/fallback/fixture.h"
+
+using namespace megdnn;
+using namespace test;
+
+namespace {
+void run_cumsum_test(Handle* handle) {
+    Checker<Cumsum> checker(handle);
+    UniformIntRNG rng_int{-10, 10};
+    UniformFloatRNG rng_float{-1.f, 1.f};
+    struct TestArg {
+        TensorShape shape;
+        int32_t axis;
+    };
+    // short scan axis, long scan axis with few lines (chunked two-pass scan),
+    // and wide inner dimension split into several lines
+    std::vector<TestArg> args{
+            {{2, 3, 4}, 1},     {{7}, 0},          {{10000}, 0},
+            {{3, 9000}, 1},     {{2, 9000, 5}, 1}, {{4, 300, 513}, 1},
+            {{5000, 3, 2}, 0},  {{3, 2, 5000}, 2}};
+    for (auto&& arg : args) {
+        for (bool exclusive : {false, true}) {
+            for (bool reverse : {false, true}) {
+                param::Cumsum param{arg.axis, exclusive, reverse};
+                checker.set_param(param)
+                        .set_dtype(0, dtype::Int32())
+                        .set_dtype(1, dtype::Int32())
+                        .set_rng(0, &rng_int)
+                        .execs({arg.shape, {}});
+                checker.set_param(param)
+                        .set_dtype(0, dtype::Float32())
+                        .set_dtype(1, dtype::Float32())
+                        .set_rng(0, &rng_float)
+                        .set_epsilon(1e-3)
+                        .execs({arg.shape, {}});
+            }
+        }
+    }
+}
+}  // namespace
+
+TEST_F(FALLBACK, CUMSUM) {
+    run_cumsum_test(handle());
+}
+
+TEST_F(FALLBACK_MULTI_THREADS, CUMSUM) {
+    run_cumsum_test(handle());
+}
+
+// vim: syntax=cpp.doxygen
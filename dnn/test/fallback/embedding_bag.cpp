@@ -0,0 +1,59 @@
+/**
+ * \file dnn/test/fallback/embedding_bag.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "test/common/checker.h"
+#include "test/common/rng.h"
+#include "test/fallback/fixture.h"
+
+using namespace megdnn;
+using namespace test;
+
+namespace {
+//! make offsets non-decreasing and bounded by the number of indices
+void make_valid_offsets(TensorNDArray& tensors) {
+    auto&& index = tensors[1];
+    auto&& offsets = tensors[2];
+    size_t nnz = index.layout[0], nr_bags = offsets.layout[0];
+    auto ptr = offsets.ptr<dt_int32>();
+    for (size_t i = 0; i < nr_bags; ++i) {
+        // leave some bags empty
+        ptr[i] = i % 3 == 1 && i ? ptr[i - 1] : nnz * i / nr_bags;
+    }
+}
+
+template <typename Opr>
+void run_embedding_bag_test(Handle* handle, const TensorShapeArray& shapes) {
+    Checker<Opr> checker(handle);
+    UniformIntRNG rng_idx{0, 99};
+    checker.set_dtype(1, dtype::Int32{})
+            .set_dtype(2, dtype::Int32{})
+            .set_rng(1, &rng_idx)
+            .set_tensors_constraint(make_valid_offsets);
+    for (auto mode :
+         {EmbeddingBag::Param::Mode::SUM, EmbeddingBag::Param::Mode::MEAN}) {
+        EmbeddingBag::Param param;
+        param.mode = mode;
+        checker.set_param(param).execs(shapes);
+    }
+}
+}  // namespace
+
+TEST_F(FALLBACK, EMBEDDING_BAG) {
+    run_embedding_bag_test<EmbeddingBag>(handle(), {{100, 33}, {300}, {37}, {}});
+    run_embedding_bag_test<EmbeddingBag>(handle(), {{100, 1}, {17}, {20}, {}});
+    run_embedding_bag_test<EmbeddingBag>(handle(), {{100, 2048}, {64}, {8}, {}});
+}
+
+TEST_F(FALLBACK, EMBEDDING_BAG_BACKWARD) {
+    run_embedding_bag_test<EmbeddingBagBackward>(handle(), {{37, 33}, {300}, {37}, {}});
+    run_embedding_bag_test<EmbeddingBagBackward>(handle(), {{8, 2048}, {64}, {8}, {}});
+}
+
+// vim: syntax=cpp.doxygen
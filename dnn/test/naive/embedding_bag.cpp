@@ -0,0 +1,91 @@
+/**
+ * \file dnn/test/naive/embedding_bag.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+
+#include "megdnn/dtype.h"
+#include "megdnn/oprs.h"
+#include "test/common/checker.h"
+#include "test/naive/fixture.h"
+
+namespace megdnn {
+namespace test {
+
+namespace {
+// clang-format off
+TensorND embedding_weight() {
+    return TensorValue({4, 2}, dtype::Float32(), {0, 1,
+                                                  2, 3,
+                                                  4, 5,
+                                                  6, 7});
+}
+// clang-format on
+}  // namespace
+
+TEST_F(NAIVE, EMBEDDING_BAG_SUM) {
+    Checker<EmbeddingBag> checker(handle(), false);
+    EmbeddingBag::Param param;
+    param.mode = EmbeddingBag::Param::Mode::SUM;
+    checker.set_param(param).exect(
+            Testcase{
+                    embedding_weight(),
+                    TensorValue({5}, dtype::Int32(), {0, 2, 3, 3, 1}),
+                    TensorValue({3}, dtype::Int32(), {0, 2, 2}),
+                    {}},
+            Testcase{
+                    {},
+                    {},
+                    {},
+                    TensorValue({3, 2}, dtype::Float32(), {4, 6, 0, 0, 14, 17})});
+}
+
+TEST_F(NAIVE, EMBEDDING_BAG_MEAN_LENGTHS) {
+    Checker<EmbeddingBag> checker(handle(), false);
+    EmbeddingBag::Param param;
+    param.mode = EmbeddingBag::Param::Mode::MEAN;
+    param.lengths = true;
+    checker.set_param(param).exect(
+            Testcase{
+                    embedding_weight(),
+                    TensorValue({5}, dtype::Int32(), {0, 2, 3, 3, 1}),
+                    TensorValue({3}, dtype::Int32(), {2, 0, 3}),
+                    {}},
+            Testcase{
+                    {},
+                    {},
+                    {},
+                    TensorValue(
+                            {3, 2}, dtype::Float32(),
+                            {2.f, 3.f, 0.f, 0.f, 14.f / 3, 17.f / 3})});
+}
+
+TEST_F(NAIVE, EMBEDDING_BAG_BACKWARD) {
+    Checker<EmbeddingBagBackward> checker(handle(), false);
+    EmbeddingBag::Param param;
+    param.mode = EmbeddingBag::Param::Mode::MEAN;
+    checker.set_param(param).exect(
+            Testcase{
+                    TensorValue({2, 2}, dtype::Float32(), {2, 4, 3, 6}),
+                    TensorValue({4}, dtype::Int32(), {1, 1, 0, 3}),
+                    TensorValue({2}, dtype::Int32(), {1, 2}),
+                    {}},
+            Testcase{
+                    {},
+                    {},
+                    {},
+                    TensorValue(
+                            {4, 2}, dtype::Float32(),
+                            {0.f, 0.f, 2.f, 4.f, 1.5f, 3.f, 1.5f, 3.f})});
+}
+
+}  // namespace test
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
@@ -16,7 +16,11 @@ from .core._imperative_rt.common import (
 )
 from .core._imperative_rt.common import set_prealloc_config as _set_prealloc_config
 from .core._imperative_rt.common import what_is_xpu as _what_is_xpu
-from .core._imperative_rt.utils import _try_coalesce_all_free_memory
+from .core._imperative_rt.utils import (
+    _get_cpu_blob_cache_stats,
+    _set_cpu_blob_cache_limit,
+    _try_coalesce_all_free_memory,
+)
 
 __all__ = [
     "is_cuda_available",
@@ -32,6 +36,8 @@ __all__ = [
     "reset_max_memory_stats",
     "set_prealloc_config",
     "coalesce_free_memory",
+    "get_cpu_blob_cache_stats",
+    "set_cpu_blob_cache_limit",
     "DeviceType",
 ]
 
@@ -266,3 +272,25 @@ def coalesce_free_memory():
        * This function may do nothing if there are no chunks that can be freed.
     """
     return _try_coalesce_all_free_memory()
+
+
+def get_cpu_blob_cache_stats(device: Optional[str] = None) -> dict:
+    r"""Returns statistics of the cache of freed tensor memory on a CPU computing device.
+
+    The result contains ``nr_alloc`` (number of allocations), ``nr_hit``
+    (allocations served by the cache), ``cached_bytes`` (bytes currently cached)
+    and ``limit`` (max bytes cached per device).
+    """
+    if device is None:
+        device = get_default_device()
+    return _get_cpu_blob_cache_stats(CompNode(device))
+
+
+def set_cpu_blob_cache_limit(nbytes: int):
+    r"""Sets max bytes of freed tensor memory kept for reuse on each CPU computing device.
+
+    The default limit is 256MB, and could also be set by the environment variable
+    ``MEGENGINE_CPU_BLOB_CACHE_LIMIT``. Set to 0 to disable the cache.
+    """
+    assert nbytes >= 0
+    _set_cpu_blob_cache_limit(nbytes)
@@ -15,6 +15,7 @@ from ..core._imperative_rt.core2 import clear_candidates as _clear_candidates
 _eviction_threshold = 0
 _evictee_minimum_size = 1024 ** 2
 _enable_sqrt_sampling = False
+_enable_measured_cost = False
 
 
 def _str2bytes(text: str) -> int:
@@ -116,6 +117,30 @@ def enable_sqrt_sampling(mod, value: bool):
     _set_option("enable_dtr_sqrt_sampling", _enable_sqrt_sampling)
 
 
+@property
+def enable_measured_cost(mod):
+    r"""Get or set whether to use measured device time as the recompute cost
+    of tensors. When enabled, the first execution of each operator on each
+    input shape is timed on the device, and later executions use the measured
+    time instead of an estimate from tensor sizes. This makes the eviction
+    decisions more accurate for models that mix cheap and expensive operators.
+
+    Examples:
+        .. code-block::
+
+           import megengine as mge
+           mge.dtr.enable_measured_cost = True
+    """
+    return _enable_measured_cost
+
+
+@enable_measured_cost.setter
+def enable_measured_cost(mod, value: bool):
+    global _enable_measured_cost
+    _enable_measured_cost = value
+    _set_option("enable_dtr_measured_cost", _enable_measured_cost)
+
+
 def enable():
     r"""Enable to record computing path of tensors and to perform DTR policy."""
     _set_option("enable_dtr_auto_drop", 1)
@@ -8,5 +8,6 @@
 # "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 from .dtr_config import DTRConfig
 from .graph_opt_config import GraphOptimizationConfig
+from .lazy_eval import lazy_eval
 from .sublinear_memory_config import SublinearMemoryConfig
 from .tracing import TraceError, exclude_from_trace, trace
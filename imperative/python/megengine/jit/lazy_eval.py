@@ -0,0 +1,82 @@
+# -*- coding: utf-8 -*-
+# MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+#
+# Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+from .. import _atexit
+from ..core._imperative_rt.core2 import LazyEval
+
+# compiled windows hold graphs and must be released before comp nodes
+_atexit(LazyEval.clear_cache)
+
+
+class lazy_eval:
+    r"""Context manager that defers eager ops and executes them as graphs.
+
+    Ops applied inside the context are recorded into a window, which is compiled and
+    executed when it reaches ``window`` ops, when a shape or value that can not be
+    inferred is required (e.g. by :meth:`~.Tensor.numpy`), and on exit. Windows are
+    compiled with graph optimizations, so chains of elementwise ops are fused
+    (by JIT at ``opt_level`` 3 if MegEngine is built with it). Compiled windows are
+    cached by their ops and input shapes across contexts, so loops only compile once.
+
+    Args:
+        window: max number of ops in a window. Default: 64
+        opt_level: optimization level for compiling windows. Default: 3
+
+    Examples:
+
+        .. code-block::
+
+            import megengine.functional as F
+            from megengine.jit import lazy_eval
+
+            with lazy_eval():
+                y = F.relu(x * 2 + 1) * 0.5
+            print(y.numpy())
+    """
+
+    def __init__(self, window: int = 64, opt_level: int = 3):
+        assert window > 0, "window must be positive"
+        graph_options = {
+            "no_force_inplace": True,
+            "graph_opt_level": opt_level,
+        }
+
+        def apply_options(options):
+            for k, v in graph_options.items():
+                setattr(options, k, v)
+
+        self._impl = LazyEval()
+        self._impl.window = window
+        self._impl.options_visitor = apply_options
+
+    def flush(self):
+        r"""Executes ops recorded so far."""
+        self._impl.flush()
+
+    @staticmethod
+    def get_cache_stats() -> dict:
+        r"""Returns statistics of the cache of compiled windows.
+
+        ``nr_hits`` and ``nr_compiles`` count windows reused from and added to the
+        cache. ``last_nr_elemwise_ops`` is the number of elementwise ops recorded in
+        the last compiled window, and ``last_nr_elemwise_oprs`` the number of
+        elementwise operators left in it after fusion.
+        """
+        return LazyEval.get_cache_stats()
+
+    @staticmethod
+    def clear_cache():
+        r"""Drops all compiled windows and resets the statistics."""
+        LazyEval.clear_cache()
+
+    def __enter__(self):
+        self._impl.enter()
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self._impl.exit()
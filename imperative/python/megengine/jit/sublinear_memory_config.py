@@ -29,6 +29,13 @@ class SublinearMemoryConfig:
             in sublinear memory optimization. Default: half of cpu number in the system.
             Note: the value must be greater or equal to one.
             It can also be set through the environmental variable 'MGB_SUBLINEAR_MEMORY_WORKERS'.
+        memory_budget_mb: memory budget of bottleneck size in MB. If positive, the
+            plan that recomputes least within the budget is picked from the time/memory
+            Pareto front of searched plans, instead of the plan with least memory. Default: 0.
+            It can also be set through the environmental variable 'MGB_SUBLINEAR_MEMORY_BUDGET_MB'.
+        enable_plan_cache: whether to cache searched plans in the persistent cache keyed
+            by the graph hash, so compiling the same graph again skips the search; plans
+            are saved to file if a file-backed persistent cache is used. Default: False.
     
     Note that the environmental variable MGB_COMP_GRAPH_OPT must be set to 'enable_sublinear_memory_opt=1'
     in order for the above environmental variable to be effective.
@@ -41,6 +48,8 @@ class SublinearMemoryConfig:
         genetic_pool_size: int = 20,
         lb_memory_mb: int = 0,
         num_worker: int = max(1, get_device_count("cpu") // 2),
+        memory_budget_mb: int = 0,
+        enable_plan_cache: bool = False,
     ):
         assert thresh_nr_try >= 0, "thresh_nr_try must be greater or equal to zero"
         self.thresh_nr_try = thresh_nr_try
@@ -53,3 +62,8 @@ class SublinearMemoryConfig:
         self.lb_memory_mb = lb_memory_mb
         assert num_worker > 0, "num_worker must be greater or equal to one"
         self.num_worker = num_worker
+        assert (
+            memory_budget_mb >= 0
+        ), "memory_budget_mb must be greater or equal to zero"
+        self.memory_budget_mb = memory_budget_mb
+        self.enable_plan_cache = enable_plan_cache
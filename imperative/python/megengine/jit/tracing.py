@@ -101,6 +101,12 @@ class trace:
         opt_level: optimization level for compiling trace. Default: 2
         graph_opt_config: configuration for graph optimization. Default: None
         symbolic_shape: whether to use symbolic shape for tracing. Default: True
+        shape_cache_size: max number of compiled graphs specialized for input shapes
+            that recur, other input shapes are served by a graph with dynamic shapes.
+            Specialized graphs are compiled in background. When enabled, the graph is
+            launched when a traced value is first read rather than when the traced
+            function is called, so it does not overlap with the python code replayed
+            before that. 0 disables specialization. Default: 8
     """
 
     def __new__(cls, *args, **kwargs):
@@ -120,6 +126,7 @@ class trace:
         opt_level: int = 2,
         graph_opt_config: GraphOptimizationConfig = None,
         symbolic_shape: bool = True,
+        shape_cache_size: int = 8,
     ):
         self.__wrapped__ = function
         self._capture_as_const = capture_as_const or record_only
@@ -174,6 +181,12 @@ class trace:
             graph_options[
                 "sublinear_mem_config.num_worker"
             ] = sublinear_memory_config.num_worker
+            graph_options[
+                "sublinear_mem_config.memory_budget_mb"
+            ] = sublinear_memory_config.memory_budget_mb
+            graph_options[
+                "sublinear_mem_config.enable_plan_cache"
+            ] = sublinear_memory_config.enable_plan_cache
         if int(os.getenv("MEGENGINE_INPLACE_UPDATE", "0")):
             graph_options["var_sanity_check_first_run"] = False
 
@@ -193,6 +206,7 @@ class trace:
         self._trace.profile = profiling
         self._trace.array_comparator = array_comparator
         self._trace.record_input_shapes = _input_node_use_static_shape()
+        self._trace.shape_cache_size = shape_cache_size
 
     def __call__(self, *args, **kwargs):
         global active_trace
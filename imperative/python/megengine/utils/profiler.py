@@ -9,6 +9,7 @@
 import json
 import os
 import re
+import signal
 from contextlib import ContextDecorator, contextmanager
 from functools import wraps
 from typing import List
@@ -16,10 +17,15 @@ from weakref import WeakSet
 
 from .. import _atexit
 from ..core._imperative_rt.core2 import (
+    dump_sampling_profile,
+    dump_sampling_profile_on_signal,
+    get_sampling_profile_stats,
     pop_scope,
     push_scope,
     start_profile,
+    start_sampling_profile,
     stop_profile,
+    stop_sampling_profile,
     sync,
 )
 from ..logger import get_logger
@@ -163,6 +169,85 @@ class Profiler(ContextDecorator):
         self.dump()
 
 
+class SamplingProfiler:
+    r"""Low-overhead profiler that only times sampled ops, so it could be always on.
+
+    Each sampled op records its latency and the memory allocated by MegEngine on its
+    device. Recent samples of each thread are kept in a ring buffer, and all samples
+    are aggregated into per-op latency histograms and memory high-water marks.
+
+    Sampling could also be enabled without code changes by setting environment
+    variable ``MEGENGINE_SAMPLING_PROFILE`` to a sample rate. If
+    ``MEGENGINE_SAMPLING_PROFILE_DUMP`` is set too, results are dumped with it as path
+    prefix on ``SIGUSR2``.
+
+    Args:
+        sample_rate: sample 1 in ``sample_rate`` ops, 0 means sampling by time window
+            only. Default: 100
+        window_us: sample all ops in the first ``window_us`` microseconds of every
+            ``period_us`` microseconds. Default: 0
+        period_us: see ``window_us``. Default: 0
+        sync_device: sync device after sampled ops, so that latency includes device
+            time. Default: False
+        capacity: number of recent samples kept by each thread. Default: 4096
+
+    Examples:
+
+        .. code-block::
+
+           from megengine.utils.profiler import SamplingProfiler
+
+           profiler = SamplingProfiler(sample_rate=100).start()
+           profiler.dump_on_signal("profile/sampling")
+           # train as usual, and send SIGUSR2 to dump
+           print(profiler.stats()["latency"])
+    """
+
+    def __init__(
+        self,
+        sample_rate: int = 100,
+        window_us: int = 0,
+        period_us: int = 0,
+        sync_device: bool = False,
+        capacity: int = 4096,
+    ):
+        self._config = (sample_rate, window_us, period_us, sync_device, capacity)
+
+    def start(self):
+        start_sampling_profile(*self._config)
+        return self
+
+    def stop(self):
+        stop_sampling_profile()
+
+    def dump(self, path: str):
+        r"""Dumps recent samples to ``path`` in chrome timeline format."""
+        dirname = os.path.dirname(path)
+        if dirname and not os.path.exists(dirname):
+            os.makedirs(dirname)
+        dump_sampling_profile(path)
+
+    def dump_on_signal(self, path: str, signum: int = None):
+        r"""Dumps to ``{path}.{pid}.chrome_timeline.json`` when ``signum`` (default
+        ``SIGUSR2``) is received."""
+        if signum is None:
+            signum = signal.SIGUSR2
+        dirname = os.path.dirname(path)
+        if dirname and not os.path.exists(dirname):
+            os.makedirs(dirname)
+        dump_sampling_profile_on_signal(signum, path)
+
+    def stats(self):
+        r"""Returns per-op latency histograms and memory high-water marks."""
+        return get_sampling_profile_stats()
+
+    def __enter__(self):
+        return self.start()
+
+    def __exit__(self, val, tp, trace):
+        self.stop()
+
+
 @contextmanager
 def scope(name):
     push_scope(name)
@@ -242,7 +242,23 @@ void init_graph_rt(py::module m) {
                     })
             .def("get_static_memory_alloc_info",
                  &cg::AsyncExecutable::get_static_memory_alloc_info,
-                 py::call_guard<py::gil_scoped_release>());
+                 py::call_guard<py::gil_scoped_release>())
+            .def("get_static_mem_plan_cache_stat", [](cg::AsyncExecutable* exec) {
+                auto stat = exec->get_static_mem_plan_cache_stat();
+                py::dict ret;
+                ret["nr_hit"] = stat.nr_hit;
+                ret["nr_miss"] = stat.nr_miss;
+                ret["nr_cached"] = stat.nr_cached;
+                return ret;
+            })
+            .def("dump_static_mem_plan",
+                 [](cg::AsyncExecutable* exec) {
+                     return py::bytes(exec->dump_static_mem_plan());
+                 })
+            .def("load_static_mem_plan",
+                 [](cg::AsyncExecutable* exec, py::bytes buf) {
+                     exec->load_static_mem_plan(buf);
+                 });
 
     auto PyComputingGraph =
             py::class_<cg::ComputingGraph, std::shared_ptr<cg::ComputingGraph>>(
@@ -482,9 +498,11 @@ void init_graph_rt(py::module m) {
                 DEF_READWRITE(enable_dtr_memory_opt)
                 DEF_READWRITE(no_profiling_on_shape_change)
                 DEF_READWRITE(enable_var_mem_defragment)
+                DEF_READWRITE(dynamic_mem_compact_threshold)
                 DEF_READWRITE(enable_grad_var_static_reshape)
                 DEF_READWRITE(enable_memory_swap)
                 DEF_READWRITE(comp_node_seq_record_level)
+                DEF_READWRITE(comp_node_seq_record_cache_bytes)
                 DEF_READWRITE(no_force_inplace)
                 DEF_READWRITE(sublinear_mem_config)
                 DEF_READWRITE(dtr_config)
@@ -500,7 +518,10 @@ void init_graph_rt(py::module m) {
 
     py::class_<cg::ComputingGraph::Options::SeqOpt>(PyComputingGraphOptions, "SeqOpt")
             DEF_READWRITE(enable_mem_plan_opt) DEF_READWRITE(enable_mem_reuse_alloc)
-                    DEF_READWRITE(enable_seq_comp_node_opt);
+                    DEF_READWRITE(enable_seq_comp_node_opt)
+                            DEF_READWRITE(static_mem_plan_cache_size)
+                                    DEF_READWRITE(static_mem_optimal_alloc_time)
+                                            DEF_READWRITE(static_infer_cache_size);
 
 #undef CURRENT_CLASS
 #define CURRENT_CLASS cg::ComputingGraph::Options::GraphOpt
@@ -523,7 +544,9 @@ void init_graph_rt(py::module m) {
     py::class_<cg::ComputingGraph::Options::SublinearMemConfig>(
             PyComputingGraphOptions, "SublinearMemConfig") DEF_READWRITE(thresh_nr_try)
             DEF_READWRITE(genetic_nr_iter) DEF_READWRITE(genetic_pool_size)
-                    DEF_READWRITE(lb_memory_mb) DEF_READWRITE(num_worker);
+                    DEF_READWRITE(lb_memory_mb) DEF_READWRITE(num_worker)
+                            DEF_READWRITE(memory_budget_mb)
+                                    DEF_READWRITE(enable_plan_cache);
 
 #undef CURRENT_CLASS
 
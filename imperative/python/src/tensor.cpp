@@ -222,18 +222,34 @@ TensorWrapper::TensorWrapper(PyObject* args, PyObject* kwargs) {
                 CreateTensor::Kind kind = is_const ? CreateTensor::Const
                                         : no_cache ? CreateTensor::Unique
                                                    : CreateTensor::Common;
-                HostTensorND ret(cn);
-                ret = npy::np2tensor(data.ptr(), npy::Meth::copy_into(&ret), dtype);
-                mgb_assert(
-                        ret.layout().is_empty() || ret.layout().is_contiguous(),
-                        "host value should be continuous");
-                ValueShape shape;
-                for (size_t i = 0; i < data.ndim(); ++i) {
-                    shape[shape.ndim++] = data.shape(i);
+                constexpr size_t size_threshold = TensorShape::MAX_NDIM;
+                if (kind != CreateTensor::Const &&
+                    cn.device_type() == CompNode::DeviceType::CPU &&
+                    data.size() > size_threshold) {
+                    // host memory is device memory on cpu, so numpy data is copied
+                    // into device storage once, rather than into a host value which
+                    // would be copied again by the interpreter
+                    auto hv = npy::np2tensor(data.ptr(), npy::Meth::borrow(cn), dtype);
+                    DeviceTensorND dv{cn, hv.shape(), hv.dtype()};
+                    HostTensorND::make_proxy(dv).copy_from_fixlayout(hv);
+                    m_tensor = std::make_shared<Tensor>(imperative::apply(
+                            CreateTensor(kind, cn, dv.layout()),
+                            DeviceStorage::make(dv.storage()))[0]);
+                } else {
+                    HostTensorND ret(cn);
+                    ret = npy::np2tensor(
+                            data.ptr(), npy::Meth::copy_into(&ret), dtype);
+                    mgb_assert(
+                            ret.layout().is_empty() || ret.layout().is_contiguous(),
+                            "host value should be continuous");
+                    ValueShape shape;
+                    for (size_t i = 0; i < data.ndim(); ++i) {
+                        shape[shape.ndim++] = data.shape(i);
+                    }
+                    m_tensor = std::make_shared<Tensor>(imperative::apply(
+                            CreateTensor(kind, cn, ret.dtype(), shape),
+                            HostStorage::make(ret.storage()))[0]);
                 }
-                m_tensor = std::make_shared<Tensor>(imperative::apply(
-                        CreateTensor(kind, cn, ret.dtype(), shape),
-                        HostStorage::make(ret.storage()))[0]);
             }
 
             if (!name.empty()) {
@@ -1341,6 +1357,45 @@ void init_tensor(py::module m) {
             results = nullptr;
         };
     });
+    m.def("start_sampling_profile",
+          [](size_t sample_rate, uint64_t window_us, uint64_t period_us,
+             bool sync_device, size_t capacity) {
+              imperative::SamplingProfiler::Config config;
+              config.sample_rate = sample_rate;
+              config.window_us = window_us;
+              config.period_us = period_us;
+              config.sync_device = sync_device;
+              config.capacity = capacity;
+              imperative::SamplingProfiler::start(config);
+          });
+    m.def("stop_sampling_profile", &imperative::SamplingProfiler::stop);
+    m.def("dump_sampling_profile", &imperative::SamplingProfiler::dump);
+    m.def("dump_sampling_profile_on_signal",
+          &imperative::SamplingProfiler::dump_on_signal);
+    m.def("get_sampling_profile_stats", []() {
+        auto bundle = imperative::SamplingProfiler::collect();
+        auto to_us = [](imperative::profiler::Duration duration) {
+            return std::chrono::duration_cast<
+                           std::chrono::duration<double, std::micro>>(duration)
+                    .count();
+        };
+        py::dict histograms;
+        for (auto&& [name, histogram] : bundle.histograms) {
+            py::dict item;
+            item["count"] = histogram.count;
+            item["mean_us"] = to_us(histogram.total) / histogram.count;
+            item["max_us"] = to_us(histogram.max);
+            item["log2_us_buckets"] = py::cast(std::vector<uint64_t>(
+                    histogram.buckets.begin(), histogram.buckets.end()));
+            histograms[py::str(name)] = item;
+        }
+        py::dict stats;
+        stats["latency"] = histograms;
+        stats["memory_high_water"] = py::cast(bundle.memory_high_water);
+        stats["nr_sample"] = bundle.samples.size();
+        return stats;
+    });
+    imperative::SamplingProfiler::init_from_env();
     m.def("sync", [channel]() {
         if (channel->check_available()) {
             channel->sync();
@@ -1394,6 +1449,7 @@ void init_tensor(py::module m) {
         bool capture_as_const = false;
         bool profile = false;
         bool record_input_shapes = false;
+        size_t shape_cache_size = 0;
         py::function options_visitor;
         std::shared_ptr<TracingTransformation> tracing;
         std::shared_ptr<CompiledTransformation> compiled;
@@ -1437,6 +1493,14 @@ void init_tensor(py::module m) {
                 self.compiled->set_value_comparator(
                         std::bind(&Trace::compare_value, this, _1, _2));
                 self.options_visitor(py::cast(&self.compiled->options()));
+                self.compiled->set_options_visitor(
+                        [this](ComputingGraph::Options& options) {
+                            py::gil_scoped_acquire _;
+                            options_visitor(py::cast(&options));
+                        });
+                // profiler is attached to a single graph
+                self.compiled->set_shape_cache_size(
+                        self.profile ? 0 : self.shape_cache_size);
                 self.compiled->compile();
             }
             // register transformations
@@ -1517,6 +1581,7 @@ void init_tensor(py::module m) {
     py::class_<Trace>(m, "Trace")
             .def(py::init<>())
             .def_readwrite("record_input_shapes", &Trace::record_input_shapes)
+            .def_readwrite("shape_cache_size", &Trace::shape_cache_size)
             .def_readwrite("array_comparator", &Trace::array_comparator)
             .def_readwrite("profile", &Trace::profile)
             .def_property_readonly(
@@ -1528,6 +1593,17 @@ void init_tensor(py::module m) {
                             return (ComputingGraph::Options*)nullptr;
                         }
                     })
+            .def("get_shape_cache_stats",
+                 [](Trace& self) -> py::object {
+                     if (!self.compiled) {
+                         return py::none();
+                     }
+                     auto [nr_compiled, nr_hit] = self.compiled->shape_cache_stats();
+                     py::dict stats;
+                     stats["nr_compiled"] = nr_compiled;
+                     stats["nr_hit"] = nr_hit;
+                     return stats;
+                 })
             .def("get_profile",
                  [](Trace& self) -> py::object {
                      if (self.profiler.second && self.compiled) {
@@ -1563,6 +1639,64 @@ void init_tensor(py::module m) {
                 }
             });
 
+    /**
+     * \brief lazy evaluation of eager code in windows
+     *
+     */
+    struct LazyEval {
+        size_t window = 64;
+        py::function options_visitor;
+        std::shared_ptr<LazyEvalTransformation> lazy_eval;
+
+        //! compiled windows are shared by all lazy evals, so that a loop body
+        //! entering a new context on each iteration compiles only once
+        static std::shared_ptr<LazyEvalTransformation::WindowCache>& window_cache() {
+            static auto cache = std::make_shared<LazyEvalTransformation::WindowCache>();
+            return cache;
+        }
+
+        void enter() {
+            mgb_assert(!lazy_eval, "lazy eval has been entered");
+            lazy_eval = std::make_shared<LazyEvalTransformation>(
+                    false, window, window_cache());
+            if (options_visitor) {
+                options_visitor(py::cast(&lazy_eval->options()));
+            }
+            transformations.register_at<Segment::Eval>(lazy_eval);
+        }
+
+        void exit() {
+            mgb_assert(lazy_eval, "lazy eval has not been entered");
+            auto lazy = std::move(lazy_eval);
+            transformations.unregister<Segment::Eval>(lazy);
+            lazy->check_exception();
+        }
+    };
+
+    py::class_<LazyEval>(m, "LazyEval")
+            .def(py::init<>())
+            .def_readwrite("window", &LazyEval::window)
+            .def_readwrite("options_visitor", &LazyEval::options_visitor)
+            .def("enter", &LazyEval::enter)
+            .def("exit", &LazyEval::exit)
+            .def("flush",
+                 [](LazyEval& self) {
+                     mgb_assert(self.lazy_eval, "lazy eval has not been entered");
+                     self.lazy_eval->flush();
+                 })
+            .def_static(
+                    "get_cache_stats",
+                    []() {
+                        auto stats = LazyEval::window_cache()->stats();
+                        py::dict ret;
+                        ret["nr_hits"] = stats.nr_hits;
+                        ret["nr_compiles"] = stats.nr_compiles;
+                        ret["last_nr_elemwise_ops"] = stats.last_nr_elemwise_ops;
+                        ret["last_nr_elemwise_oprs"] = stats.last_nr_elemwise_oprs;
+                        return ret;
+                    })
+            .def_static("clear_cache", []() { LazyEval::window_cache()->clear(); });
+
     m.def("reduce_to_scalar", [](py::object op, py::object tensor) -> py::object {
         auto reduce_to_scalar = [](const OpDef& op, const ValueRef& input) {
             auto make_scalar_shape = [&](CompNode device) {
@@ -220,6 +220,16 @@ void init_utils(py::module m) {
     m.def("_defrag", [](const mgb::CompNode& cn) {
         mgb::imperative::BlobManager::inst()->defrag(cn);
     });
+    m.def("_get_cpu_blob_cache_stats", [](const mgb::CompNode& cn) {
+        auto stats = mgb::imperative::BlobManager::inst()->get_cache_stats(cn);
+        return py::dict(
+                py::arg("nr_alloc") = stats.nr_alloc, py::arg("nr_hit") = stats.nr_hit,
+                py::arg("cached_bytes") = stats.cached_bytes,
+                py::arg("limit") = stats.limit);
+    });
+    m.def("_set_cpu_blob_cache_limit", [](size_t limit) {
+        mgb::imperative::BlobManager::inst()->set_cache_limit(limit);
+    });
     m.def("_set_fork_exec_path_for_timed_func",
           [](const std::string& arg0, const ::std::string arg1) {
               using namespace std::placeholders;
@@ -1,12 +1,13 @@
 import subprocess
 import sys
+import time
 
 import numpy as np
 import pytest
 
 import megengine as mge
 import megengine.functional as F
-from megengine.core import set_option
+from megengine.core import get_option, set_option
 from megengine.core._imperative_rt.core2 import AsyncError
 
 
@@ -122,3 +123,81 @@ def test_async_error():
             F.utils._simulate_error()
     finally:
         mge.config.async_level = orig_lvl
+
+
+def test_cpu_blob_cache():
+    old_limit = mge.device.get_cpu_blob_cache_stats("cpu0")["limit"]
+    mge.device.set_cpu_blob_cache_limit(64 * 1024 * 1024)
+    x = mge.tensor(np.random.rand(1000).astype("float32"), device="cpu0")
+    for _ in range(10):
+        y = x * 2 + 1
+        np.testing.assert_allclose(y.numpy(), x.numpy() * 2 + 1, rtol=1e-6)
+        del y
+    stats = mge.device.get_cpu_blob_cache_stats("cpu0")
+    assert stats["nr_hit"] > 0
+    assert stats["nr_hit"] <= stats["nr_alloc"]
+    mge.device.set_cpu_blob_cache_limit(0)
+    assert mge.device.get_cpu_blob_cache_stats("cpu0")["cached_bytes"] == 0
+    mge.device.set_cpu_blob_cache_limit(old_limit)
+
+
+def test_cpu_put_from_numpy():
+    data = np.random.rand(2, 100).astype("float32")
+    x = mge.tensor(data, device="cpu0")
+    y = mge.tensor(data[:, ::2], device="cpu0", dtype="float16")
+    expect = data.copy()
+    data[:] = 0
+    np.testing.assert_equal(x.numpy(), expect)
+    np.testing.assert_equal(y.numpy(), expect[:, ::2].astype("float16"))
+    np.testing.assert_allclose((x * 2).numpy(), expect * 2, rtol=1e-6)
+
+
+def test_command_batch():
+    old_batch_size = get_option("command_batch_size")
+    try:
+        set_option("command_batch_size", 4)
+        # batched ops run in submission order, interleaved with other commands
+        data = np.random.rand(100).astype("float32")
+        x = mge.tensor(data, device="cpu0")
+        consts = np.arange(50, dtype="float32") / 50
+        cs = [mge.tensor(c, device="cpu0") for c in consts]
+        expect = data.copy()
+        for i in range(50):
+            x = x * cs[i] + cs[-i - 1]
+            expect = expect * consts[i] + consts[-i - 1]
+        np.testing.assert_allclose(x.numpy(), expect, rtol=1e-5)
+
+        # a batch larger than the number of ops is flushed by the sync
+        set_option("command_batch_size", 1000)
+        ys = [x + cs[i] for i in range(8)]
+        for i, y in enumerate(ys):
+            np.testing.assert_allclose(y.numpy(), expect + consts[i], rtol=1e-5)
+    finally:
+        set_option("command_batch_size", old_batch_size)
+
+
+def test_command_batch_flush_on_idle():
+    # allocations counted by the blob cache show when ops actually run
+    old_batch_size = get_option("command_batch_size")
+    old_limit = mge.device.get_cpu_blob_cache_stats("cpu0")["limit"]
+    mge.device.set_cpu_blob_cache_limit(64 * 1024 * 1024)
+    try:
+        set_option("command_batch_size", 1000)
+        x = mge.tensor(np.random.rand(100).astype("float32"), device="cpu0")
+        a = mge.tensor(np.random.rand(512, 512).astype("float32"), device="cpu0")
+        a.numpy()
+        nr_alloc = lambda: mge.device.get_cpu_blob_cache_stats("cpu0")["nr_alloc"]
+        begin = nr_alloc()
+        # ops held back while the worker is busy are flushed once it drains
+        # its queue, without any sync from the caller
+        b = F.matmul(a, a)
+        ys = [x + i for i in range(8)]
+        deadline = time.time() + 10
+        while nr_alloc() < begin + 9 and time.time() < deadline:
+            time.sleep(0.01)
+        assert nr_alloc() >= begin + 9
+        for i, y in enumerate(ys):
+            np.testing.assert_allclose(y.numpy(), x.numpy() + i, rtol=1e-5)
+    finally:
+        set_option("command_batch_size", old_batch_size)
+        mge.device.set_cpu_blob_cache_limit(old_limit)
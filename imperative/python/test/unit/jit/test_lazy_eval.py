@@ -0,0 +1,63 @@
+# -*- coding: utf-8 -*-
+# MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+#
+# Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+import numpy as np
+
+import megengine.functional as F
+from megengine import tensor
+from megengine.jit import lazy_eval
+
+
+def test_lazy_eval_elemwise_chain():
+    x_np = np.random.randn(4, 8).astype("float32")
+    expect = np.maximum(x_np * 2 + 1, 0) * 0.5
+    x = tensor(x_np)
+    lazy_eval.clear_cache()
+    for i in range(3):
+        # a new context per iteration still reuses the compiled window
+        with lazy_eval(opt_level=2):
+            y = F.relu(x * 2 + 1) * 0.5
+            z = y + x
+        np.testing.assert_allclose(y.numpy(), expect, rtol=1e-6)
+        np.testing.assert_allclose(z.numpy(), expect + x_np, rtol=1e-6)
+        stats = lazy_eval.get_cache_stats()
+        if i == 0:
+            nr_windows = stats["nr_compiles"]
+            assert nr_windows > 0 and stats["nr_hits"] == 0
+            # mul, add, relu, mul and add are fused into fewer oprs
+            assert stats["last_nr_elemwise_ops"] == 5
+            assert stats["last_nr_elemwise_oprs"] < 5
+        else:
+            assert stats["nr_compiles"] == nr_windows
+            assert stats["nr_hits"] == nr_windows * i
+    lazy_eval.clear_cache()
+
+
+def test_lazy_eval_different_ops():
+    x_np = np.random.randn(4, 8).astype("float32")
+    x = tensor(x_np)
+    lazy_eval.clear_cache()
+    with lazy_eval():
+        y = x + 1
+    np.testing.assert_allclose(y.numpy(), x_np + 1, rtol=1e-6)
+    with lazy_eval():
+        y = x - 1
+    np.testing.assert_allclose(y.numpy(), x_np - 1, rtol=1e-6)
+    assert lazy_eval.get_cache_stats()["nr_hits"] == 0
+    lazy_eval.clear_cache()
+
+
+def test_lazy_eval_read_inside():
+    x = tensor(np.arange(6, dtype="float32").reshape(2, 3))
+    with lazy_eval() as le:
+        y = x * 3
+        np.testing.assert_equal(y.numpy(), np.arange(6).reshape(2, 3) * 3)
+        z = y.sum(axis=1)
+        le.flush()
+        assert z.shape == (2,)
+    np.testing.assert_equal(z.numpy(), [9, 36])
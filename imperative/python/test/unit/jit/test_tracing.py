@@ -10,6 +10,7 @@ import inspect
 import io
 import itertools
 import random
+import time
 from tempfile import mkstemp
 
 import numpy as np
@@ -432,6 +433,31 @@ def test_trace_reshape(trace_mode):
     f(x3)
 
 
+@pytest.mark.parametrize("shape_cache_size", [0, 1, 2])
+def test_trace_shape_cache(shape_cache_size):
+    @trace(symbolic=True, shape_cache_size=shape_cache_size)
+    def f(x):
+        return F.relu(x * 2 - 1).sum(axis=1)
+
+    def run(batch):
+        x = np.random.randn(batch, 10).astype("float32")
+        expect = np.maximum(x * 2 - 1, 0).sum(axis=1)
+        np.testing.assert_allclose(f(tensor(x)).numpy(), expect, rtol=1e-5)
+
+    for batch in [2, 4, 2, 4, 8, 2, 4, 4, 8, 2]:
+        run(batch)
+    if shape_cache_size == 0:
+        assert f._trace.get_shape_cache_stats() == {"nr_compiled": 0, "nr_hit": 0}
+        return
+    # specialized graphs are compiled in background, and used once ready
+    deadline = time.time() + 60
+    while f._trace.get_shape_cache_stats()["nr_hit"] < 2 and time.time() < deadline:
+        run(2)
+    stats = f._trace.get_shape_cache_stats()
+    assert stats["nr_compiled"] >= 1
+    assert stats["nr_hit"] >= 2
+
+
 def test_trace_topk():
     x = tensor([5, 2, 7, 1, 0, 3, 2])
 
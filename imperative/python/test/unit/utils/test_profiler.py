@@ -17,7 +17,7 @@ from megengine import distributed as dist
 from megengine import tensor
 from megengine.jit import trace
 from megengine.module import Module
-from megengine.utils.profiler import Profiler, scope
+from megengine.utils.profiler import Profiler, SamplingProfiler, scope
 
 
 class Simple(Module):
@@ -105,3 +105,29 @@ def test_profiler_dist(format, trace_mode):
 
     assert os.path.exists(profile_path), "profiling results not found"
     assert len(os.listdir(tempdir.name)) == n_gpus + 1
+
+
+def test_sampling_profiler():
+    tempdir = tempfile.TemporaryDirectory()
+    path = os.path.join(tempdir.name, "sampling.chrome_timeline.json")
+    model = Simple()
+    with SamplingProfiler(sample_rate=2, capacity=8) as profiler:
+        for _ in range(20):
+            model(tensor([1.0])).numpy()
+    stats = profiler.stats()
+    assert stats["latency"]
+    assert 0 < stats["nr_sample"] <= 8
+    for histogram in stats["latency"].values():
+        assert sum(histogram["log2_us_buckets"]) == histogram["count"]
+    profiler.dump(path)
+    with open(path, "r") as f:
+        events = json.load(f)["traceEvents"]
+    assert any(event.get("ph") == "X" for event in events)
+
+    # a new run reuses the buffers and only reports its own samples
+    nr_op = sum(histogram["count"] for histogram in stats["latency"].values())
+    with SamplingProfiler(sample_rate=2, capacity=8) as profiler:
+        model(tensor([1.0])).numpy()
+    stats = profiler.stats()
+    assert stats["nr_sample"] <= 8
+    assert sum(histogram["count"] for histogram in stats["latency"].values()) < nr_op
@@ -52,8 +52,12 @@ void BlobManagerImpl::alloc_with_defrag(Blob* blob, size_t size) {
 }
 
 void BlobManagerImpl::alloc_direct(Blob* blob, size_t size) {
-    DeviceTensorStorage storage(blob->m_comp_node);
     mgb_assert(blob->m_comp_node.valid());
+    if (auto cached = m_cpu_cache->alloc(blob->m_comp_node, size)) {
+        blob->m_storage = std::move(cached);
+        return;
+    }
+    DeviceTensorStorage storage(blob->m_comp_node);
     storage.ensure_size(size);
     blob->m_storage = storage.raw_storage();
 }
@@ -72,13 +76,20 @@ DeviceTensorND BlobManagerImpl::alloc_workspace_with_defrag(
 
 DeviceTensorND BlobManagerImpl::alloc_workspace(CompNode cn, TensorLayout layout) {
     DeviceTensorStorage storage(cn);
-    storage.ensure_size(layout.dtype.size(layout.total_nr_elems()));
+    auto size = layout.dtype.size(layout.total_nr_elems());
+    if (auto cached = m_cpu_cache->alloc(cn, size)) {
+        storage.reset(cn, size, std::move(cached));
+    } else {
+        storage.ensure_size(size);
+    }
     DeviceTensorND dev_tensor;
     dev_tensor.reset(storage, layout);
     return dev_tensor;
 }
 
 void BlobManagerImpl::defrag(const CompNode& cn) {
+    // cached blocks are the cheapest memory to give back
+    m_cpu_cache->clear(cn);
     BlobSetWithMux* blobs_set_ptr;
     {
         MGB_LOCK_GUARD(m_mtx);
@@ -142,6 +153,134 @@ void BlobManagerImpl::defrag(const CompNode& cn) {
     cn.sync();
 }
 
+BlobManager::CacheStats BlobManagerImpl::get_cache_stats(CompNode cn) {
+    return m_cpu_cache->stats(cn);
+}
+
+void BlobManagerImpl::set_cache_limit(size_t limit) {
+    m_cpu_cache->set_limit(limit);
+}
+
+/* ============================== CpuCache ============================== */
+
+namespace {
+//! round \p size up to one of four size classes per power of two, so at most
+//! a quarter of each block is wasted
+size_t cpu_cache_size_class(size_t size) {
+    constexpr size_t MIN_SIZE = 64;
+    if (size <= MIN_SIZE) {
+        return MIN_SIZE;
+    }
+    size_t step = 1;
+    while (step * 8 < size) {
+        step <<= 1;
+    }
+    return (size + step - 1) / step * step;
+}
+}  // anonymous namespace
+
+BlobManagerImpl::CpuCache::CpuCache() {
+    m_limit = 256 * 1024 * 1024;
+    if (auto env = MGB_GETENV("MEGENGINE_CPU_BLOB_CACHE_LIMIT")) {
+        m_limit = std::stoull(env);
+    }
+}
+
+Blob::RawStorage BlobManagerImpl::CpuCache::alloc(CompNode cn, size_t size) {
+    if (cn.device_type() != CompNode::DeviceType::CPU || !size) {
+        return {};
+    }
+    auto size_class = cpu_cache_size_class(size);
+    void* ptr = nullptr;
+    {
+        MGB_LOCK_GUARD(m_mtx);
+        if (!m_limit || size_class > m_limit || is_finalized()) {
+            return {};
+        }
+        auto&& list = m_free_lists[cn];
+        ++list.stats.nr_alloc;
+        auto iter = list.blocks.find(size_class);
+        if (iter != list.blocks.end() && !iter->second.empty()) {
+            ptr = iter->second.back();
+            iter->second.pop_back();
+            list.stats.cached_bytes -= size_class;
+            ++list.stats.nr_hit;
+        }
+    }
+    if (!ptr) {
+        ptr = cn.alloc_device(size_class);
+    }
+    return Blob::RawStorage(
+            static_cast<dt_byte*>(ptr),
+            [self = shared_from_this(), cn, size_class](dt_byte* p) {
+                self->release(cn, p, size_class);
+            });
+}
+
+void BlobManagerImpl::CpuCache::release(CompNode cn, void* ptr, size_t size) {
+    {
+        MGB_LOCK_GUARD(m_mtx);
+        if (!is_finalized()) {
+            auto&& list = m_free_lists[cn];
+            if (list.stats.cached_bytes + size <= m_limit) {
+                list.blocks[size].push_back(ptr);
+                list.stats.cached_bytes += size;
+                return;
+            }
+        }
+    }
+    cn.free_device(ptr);
+}
+
+void BlobManagerImpl::CpuCache::clear(CompNode cn, FreeList& list) {
+    for (auto&& [size, blocks] : list.blocks) {
+        for (auto ptr : blocks) {
+            cn.free_device(ptr);
+        }
+    }
+    list.blocks.clear();
+    list.stats.cached_bytes = 0;
+}
+
+void BlobManagerImpl::CpuCache::clear(CompNode cn) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto iter = m_free_lists.find(cn);
+    if (iter != m_free_lists.end()) {
+        clear(cn, iter->second);
+    }
+}
+
+BlobManager::CacheStats BlobManagerImpl::CpuCache::stats(CompNode cn) {
+    MGB_LOCK_GUARD(m_mtx);
+    CacheStats ret;
+    auto iter = m_free_lists.find(cn);
+    if (iter != m_free_lists.end()) {
+        ret = iter->second.stats;
+    }
+    ret.limit = m_limit;
+    return ret;
+}
+
+void BlobManagerImpl::CpuCache::set_limit(size_t limit) {
+    MGB_LOCK_GUARD(m_mtx);
+    m_limit = limit;
+    for (auto&& [cn, list] : m_free_lists) {
+        if (list.stats.cached_bytes > limit) {
+            clear(cn, list);
+        }
+    }
+}
+
+std::shared_ptr<void> BlobManagerImpl::CpuCache::on_comp_node_finalize() {
+    MGB_LOCK_GUARD(m_mtx);
+    // blocks released from now on are freed directly
+    for (auto&& [cn, list] : m_free_lists) {
+        clear(cn, list);
+    }
+    m_free_lists.clear();
+    return {};
+}
+
 struct BlobManagerStub : BlobManager {
     void alloc_direct(Blob* blob, size_t size) {
         mgb_assert(0, "prohibited after global variable destruction");
@@ -159,6 +298,8 @@ struct BlobManagerStub : BlobManager {
     void defrag(const CompNode& cn) {
         mgb_assert(0, "prohibited after global variable destruction");
     };
+    CacheStats get_cache_stats(CompNode cn) { return {}; };
+    void set_cache_limit(size_t limit){};
 };
 
 BlobManager* BlobManager::inst() {
@@ -36,8 +36,49 @@ class BlobManagerImpl final : public BlobManager {
         BlobData(Blob* in_blob);
     };
 
+    /*!
+     * \brief size-class cache of blob and workspace storage on CPU comp nodes
+     *
+     * Sizes are rounded up to one of four classes per power of two. Freed
+     * storage goes to the free list of its comp node and is reused at once:
+     * tasks on a CPU comp node run in dispatch order, so the new owner can
+     * not overtake pending tasks of the old one, as with free_device().
+     */
+    class CpuCache final : public CompNodeDepedentObject,
+                           public std::enable_shared_from_this<CpuCache> {
+        struct FreeList {
+            std::unordered_map<size_t, std::vector<void*>> blocks;
+            CacheStats stats;
+        };
+
+        std::mutex m_mtx;
+        size_t m_limit;
+        CompNode::UnorderedMap<FreeList> m_free_lists;
+
+        std::shared_ptr<void> on_comp_node_finalize() override;
+
+        void release(CompNode cn, void* ptr, size_t size);
+
+        //! free all blocks in \p list; m_mtx must be held
+        static void clear(CompNode cn, FreeList& list);
+
+    public:
+        CpuCache();
+
+        //! allocate at least \p size bytes; return empty storage if \p cn
+        //! is not cached
+        Blob::RawStorage alloc(CompNode cn, size_t size);
+
+        void clear(CompNode cn);
+
+        CacheStats stats(CompNode cn);
+
+        void set_limit(size_t limit);
+    };
+
     std::mutex m_mtx;
     CompNode::UnorderedMap<BlobSetWithMux> m_comp2blobs_map;
+    std::shared_ptr<CpuCache> m_cpu_cache = std::make_shared<CpuCache>();
 
     void defrag(const CompNode& cn) override;
 
@@ -56,6 +97,10 @@ public:
     void register_blob(Blob* blob) override;
 
     void unregister_blob(Blob* blob) override;
+
+    CacheStats get_cache_stats(CompNode cn) override;
+
+    void set_cache_limit(size_t limit) override;
 };
 
 }  // namespace imperative
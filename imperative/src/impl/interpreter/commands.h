@@ -60,6 +60,18 @@ struct ApplyOp {
     const char* get_name() const { return "ApplyOp"; }
 };
 
+//! consecutive ApplyOp commands submitted to the worker as one entry
+struct ApplyOpBatch {
+    SmallVector<ApplyOp> ops;
+
+    template <typename TFunctor>
+    void get_props(TFunctor&& functor) const {
+        functor("nr_op", ops.size());
+    }
+
+    const char* get_name() const { return "ApplyOpBatch"; }
+};
+
 struct Del {
     TensorInfo* dest;
 
@@ -147,8 +159,8 @@ struct PopScope {
 };
 
 using CommandData = std::variant<
-        Put, ApplyOp, Del, GetValue, Drop, SetOption, StartProfile, StopProfile,
-        PushScope, PopScope>;
+        Put, ApplyOp, ApplyOpBatch, Del, GetValue, Drop, SetOption, StartProfile,
+        StopProfile, PushScope, PopScope>;
 
 struct Command {
     uint64_t id;
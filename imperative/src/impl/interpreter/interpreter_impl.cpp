@@ -19,8 +19,10 @@
 #include "megbrain/imperative/ops/backward_graph.h"
 #include "megbrain/imperative/ops/opr_attr.h"
 #include "megbrain/imperative/ops/utility.h"
+#include "megbrain/imperative/utils/helper.h"
 #include "megbrain/imperative/utils/stats.h"
 #include "megbrain/imperative/utils/to_string.h"
+#include "megbrain/utils/hash.h"
 
 #include "../blob_manager_impl.h"
 #include "../event_pool.h"
@@ -111,6 +113,11 @@ ChannelImpl::WorkerState& ChannelImpl::get_worker_state() {
     return m_worker_state;
 }
 
+void ChannelImpl::WorkQueue::process_one_task(Command& icmd) {
+    CleanupGuard _{[this] { m_owner->on_worker_task_finished(); }};
+    m_owner->process_one_task(icmd);
+}
+
 void ChannelImpl::WorkQueue::on_async_queue_worker_thread_start() {
     sys::set_thread_name("worker");
     m_owner->m_worker_state.tid = std::this_thread::get_id();
@@ -156,7 +163,7 @@ TensorInfo* ChannelImpl::put_impl(const HostTensorND& value, bool no_cache) {
         info->h_value = value;
         info->desc.value = value.proxy_to_default_cpu();
     }
-    m_worker.add_task(
+    submit(
             {Profiler::next_id(), Put{info, value, no_cache},
              get_channel_state().stack_manager.dump()});
     if (m_async_level == 0) {
@@ -205,7 +212,7 @@ void ChannelImpl::del_impl(Handle handle) {
     mgb_assert(m_valid_handle.count(handle), "invalid handle: %p", handle);
     auto* info = reinterpret_cast<TensorInfo*>(handle);
     m_valid_handle.erase(handle);
-    m_worker.add_task(
+    submit(
             {Profiler::next_id(), Del{info}, get_channel_state().stack_manager.dump()});
 }
 
@@ -218,7 +225,7 @@ void ChannelImpl::drop(Handle handle) {
                 m_valid_handle.find(handle) != m_valid_handle.end(),
                 "invalid handle: %p", handle);
         auto* info = reinterpret_cast<TensorInfo*>(handle);
-        m_worker.add_task(
+        submit(
                 {Profiler::next_id(), Drop{info},
                  get_channel_state().stack_manager.dump()});
     }
@@ -355,7 +362,7 @@ void ChannelImpl::dispatch_kernel(
     MGB_RECORD_EVENT(
             OpDispatchEvent, cmd.id, name, op_info_getter, tinfo_to_tid(cmd.inputs),
             tinfo_to_tid(cmd.outputs), state.stack_manager.dump());
-    m_worker.add_task(
+    submit(
             {Profiler::next_id(), std::move(cmd),
              get_channel_state().stack_manager.dump()});
     if (!validated && options.async_level == 1) {
@@ -500,7 +507,73 @@ void ChannelImpl::sync() {
     sync_impl();
 }
 
+void ChannelImpl::submit(Command cmd) {
+    auto&& options = get_channel_state().options;
+    MGB_LOCK_GUARD(m_pending_mutex);
+    if (options.command_batch_size > 1) {
+        if (auto* apply = std::get_if<ApplyOp>(&cmd.data)) {
+            if (m_pending_applies.empty()) {
+                m_pending_trace = std::move(cmd.trace);
+            }
+            m_pending_applies.push_back(std::move(*apply));
+            // an idle worker is not kept waiting; a busy one flushes the
+            // held back ops itself when its queue drains, see
+            // on_worker_task_finished()
+            if (m_pending_applies.size() >= options.command_batch_size ||
+                !m_nr_queued_cmd.load()) {
+                flush_pending_applies_unsafe();
+            }
+            return;
+        }
+    }
+    flush_pending_applies_unsafe();
+    add_task(std::move(cmd), 1);
+}
+
+void ChannelImpl::flush_pending_applies() {
+    MGB_LOCK_GUARD(m_pending_mutex);
+    flush_pending_applies_unsafe();
+}
+
+void ChannelImpl::flush_pending_applies_unsafe() {
+    size_t nr = m_pending_applies.size();
+    if (!nr) {
+        return;
+    }
+    Command cmd{Profiler::next_id(), {}, std::move(m_pending_trace)};
+    if (nr == 1) {
+        cmd.data = std::move(m_pending_applies[0]);
+    } else {
+        cmd.data = ApplyOpBatch{std::move(m_pending_applies)};
+    }
+    m_pending_applies.clear();
+    add_task(std::move(cmd), nr);
+}
+
+void ChannelImpl::on_worker_task_finished() {
+    // the counter is decreased before checking the held back ops, so either
+    // the worker sees the op added by submit() or submit() sees an idle worker
+    if (m_nr_queued_cmd.fetch_sub(1) == 1) {
+        flush_pending_applies();
+    }
+}
+
+void ChannelImpl::add_task(Command cmd, size_t nr_command) {
+    ++m_nr_queued_cmd;
+    if (!Profiler::is_profiling()) {
+        m_worker.add_task(std::move(cmd));
+        return;
+    }
+    auto begin = std::chrono::steady_clock::now();
+    m_worker.add_task(std::move(cmd));
+    auto duration = std::chrono::steady_clock::now() - begin;
+    MGB_RECORD_EVENT(
+            CommandSubmitEvent, nr_command,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+
 void ChannelImpl::sync_impl() {
+    flush_pending_applies();
     m_worker.wait_all_task_finish();
     MGB_LOCK_GUARD(m_mutex);
     check_worker_exc_unsafe();
@@ -518,6 +591,7 @@ void ChannelImpl::close() {
     mgb_assert(m_valid_handle.empty());
     mgb_log_debug("%ld tensor exists before channel close", (long)valid_handles.size());
     sync_impl();
+    m_dtr.measured_cost.clear();
     m_closed = true;
 }
 
@@ -533,7 +607,7 @@ void ChannelImpl::set_option(std::string name, size_t value) {
     mgb_assert(check_available(), "Channel already closed");
     auto& state = get_channel_state();
     state.options.set_option(name, value);
-    m_worker.add_task(
+    submit(
             {Profiler::next_id(), SetOption{name, value},
              get_channel_state().stack_manager.dump()});
 }
@@ -541,7 +615,7 @@ void ChannelImpl::set_option(std::string name, size_t value) {
 void ChannelImpl::clear_candidates() {
     MGB_LOCK_GUARD(m_spin);
     mgb_assert(check_available(), "Channel already closed");
-    m_dtr.candidates.clear();
+    m_dtr.clear_candidates();
 }
 
 TensorInfo* ChannelImpl::alloc() {
@@ -765,9 +839,30 @@ void ChannelImpl::do_apply_op(const ApplyOp& cmd, std::string reason) {
                 (Profiler::get_option("profile_device", 0)), RecordDeviceEvent,
                 Timer::record_device(device));
     }
+    bool measure_cost = state.options.enable_dtr_auto_drop &&
+                        state.options.enable_dtr_measured_cost && !inputs.empty();
+    size_t cost_key = 0;
+    bool measuring = false;
+    if (measure_cost) {
+        cost_key = DynamicSublinear::MeasuredCost::key(*cmd.op, inputs);
+        measuring = m_dtr.measured_cost.start(cost_key, inputs[0]->comp_node());
+    }
+    // discard the pending measurement if the op throws before it is stopped
+    CleanupGuard measuring_guard{[&] {
+        if (measuring) {
+            m_dtr.measured_cost.cancel();
+        }
+    }};
+    bool sampling = SamplingProfiler::should_sample();
+    auto sample_start = sampling ? Timer::record_host() : profiler::HostTime{};
     // Apply op
     // Here std::move is REQUIRED for removing duplicated references.
     auto outputs = apply_on_physical_tensor(apply_on_physical_tensor, *cmd.op, inputs);
+    if (sampling) {
+        SamplingProfiler::record(
+                cmd.op->trait()->name, sample_start,
+                outputs.empty() ? CompNode{} : outputs[0]->comp_node());
+    }
     // After execute
     for (auto&& [device, kernel_id] : kernels) {
         MGB_RECORD_EVENT_IF(
@@ -802,9 +897,18 @@ void ChannelImpl::do_apply_op(const ApplyOp& cmd, std::string reason) {
             estimate_compute_time += i->blob()->size();
         }
         m_dtr.estimate_timestamp += estimate_compute_time / 1e8;
+        double compute_time = estimate_compute_time;
+        if (measure_cost) {
+            if (measuring) {
+                m_dtr.measured_cost.stop(estimate_compute_time);
+                measuring = false;
+            }
+            m_dtr.measured_cost.poll();
+            compute_time = m_dtr.measured_cost.get(cost_key, estimate_compute_time);
+        }
         for (auto i : cmd.outputs) {
             if (i != nullptr) {
-                i->compute_time = estimate_compute_time;
+                i->compute_time = compute_time;
             }
         }
         m_dtr.unpin(cmd.inputs, state);
@@ -925,6 +1029,7 @@ bool ChannelImpl::check_available() {
 }
 
 TensorPtr ChannelImpl::wait_tensor(TensorInfo* info, TensorProp prop) {
+    flush_pending_applies();
     std::unique_lock<decltype(m_mutex)> lock(m_mutex);
     mgb_assert(!m_waitee, "duplicate waitee");
     m_waitee = info;
@@ -936,7 +1041,7 @@ TensorPtr ChannelImpl::wait_tensor(TensorInfo* info, TensorProp prop) {
     if (require_host && !host_available()) {
         // avoid dead lock
         lock.unlock();
-        m_worker.add_task(
+        submit(
                 {Profiler::next_id(), GetValue{info},
                  get_channel_state().stack_manager.dump()});
         lock.lock();
@@ -1172,29 +1277,40 @@ void ChannelImpl::process_one_task(Command& icmd) {
             static_assert(!std::is_same_v<T, T>);
         }
     };
+    auto run_cmd = [&](const auto& cmd) {
+        using T = std::decay_t<decltype(cmd)>;
+        if (!options.catch_worker_execption) {
+            cmd_visitor(cmd);
+            return;
+        }
+        try {
+            cmd_visitor(cmd);
+        } catch (...) {
+            MGB_LOCK_GUARD(m_mutex);
+            if constexpr (std::is_same_v<T, ApplyOp>) {
+                for (auto oup : cmd.outputs) {
+                    oup->invalid = true;
+                }
+            } else if constexpr (std::is_same_v<T, Put>) {
+                cmd.dest->invalid = true;
+            }
+            m_worker_exc = std::current_exception();
+            MGB_RECORD_EVENT(WorkerExceptionEvent);
+            if (m_waitee) {
+                notify_tensor_unsafe(m_waitee);
+            }
+        }
+    };
     std::visit(
             [&](const auto& cmd) {
                 using T = std::decay_t<decltype(cmd)>;
-                if (!options.catch_worker_execption) {
-                    cmd_visitor(cmd);
-                    return;
-                }
-                try {
-                    cmd_visitor(cmd);
-                } catch (...) {
-                    MGB_LOCK_GUARD(m_mutex);
-                    if constexpr (std::is_same_v<T, ApplyOp>) {
-                        for (auto oup : cmd.outputs) {
-                            oup->invalid = true;
-                        }
-                    } else if constexpr (std::is_same_v<T, Put>) {
-                        cmd.dest->invalid = true;
-                    }
-                    m_worker_exc = std::current_exception();
-                    MGB_RECORD_EVENT(WorkerExceptionEvent);
-                    if (m_waitee) {
-                        notify_tensor_unsafe(m_waitee);
+                if constexpr (std::is_same_v<T, ApplyOpBatch>) {
+                    // each op is processed as a separate command
+                    for (auto&& i : cmd.ops) {
+                        run_cmd(i);
                     }
+                } else {
+                    run_cmd(cmd);
                 }
             },
             icmd.data);
@@ -1219,7 +1335,7 @@ void ChannelImpl::start_profile() {
     mgb_assert(check_available(), "Channel already closed");
     auto capture_tensors = collect_valid_tensors();
     if (capture_tensors.size() > 0) {
-        m_worker.add_task(
+        submit(
                 {Profiler::next_id(), StartProfile{std::move(capture_tensors)},
                  get_channel_state().stack_manager.dump()});
     }
@@ -1230,7 +1346,7 @@ void ChannelImpl::stop_profile() {
     mgb_assert(check_available(), "Channel already closed");
     auto escape_tensors = collect_valid_tensors();
     if (escape_tensors.size() > 0) {
-        m_worker.add_task(
+        submit(
                 {Profiler::next_id(), StopProfile{std::move(escape_tensors)},
                  get_channel_state().stack_manager.dump()});
     }
@@ -1242,7 +1358,7 @@ void ChannelImpl::push_scope(std::string name) {
     auto& state = get_channel_state();
     state.stack_manager.enter(name);
     MGB_RECORD_EVENT(ScopeEvent, name);
-    m_worker.add_task(
+    submit(
             {Profiler::next_id(), PushScope{name},
              get_channel_state().stack_manager.dump()});
 }
@@ -1253,7 +1369,7 @@ void ChannelImpl::pop_scope(std::string name) {
     auto& state = get_channel_state();
     state.stack_manager.exit(name);
     MGB_RECORD_EVENT(ScopeFinishEvent, name);
-    m_worker.add_task(
+    submit(
             {Profiler::next_id(), PopScope{name},
              get_channel_state().stack_manager.dump()});
 }
@@ -1308,9 +1424,11 @@ void ChannelImpl::DynamicSublinear::update_dsu_after_recompute(TensorInfo* ptr)
     dsu_fa->t -= ptr->compute_time;
     ptr->dsu_ptr->parent.reset();
     ptr->dsu_ptr->t = ptr->compute_time;
+    invalidate_neighbors(ptr);
 }
 
 void ChannelImpl::DynamicSublinear::update_dsu_after_evict(TensorInfo* ptr) {
+    invalidate_neighbors(ptr);
     for (auto i : ptr->producer->inputs) {
         if (i->evict_type == EvictType::DROP) {
             merge(i->dsu_ptr, ptr->dsu_ptr);
@@ -1346,47 +1464,130 @@ double ChannelImpl::DynamicSublinear::estimate_neighbor_cost(TensorInfo* ptr) {
     return cost;
 }
 
+double ChannelImpl::DynamicSublinear::score(TensorInfo* ptr) {
+    if (!ptr->producer || !ptr->ptr || ptr->evict_type != EvictType::NONE ||
+        ptr->cand_index == UINT_MAX) {
+        return -1;
+    }
+    double neighbor_cost = estimate_neighbor_cost(ptr);
+    size_t begin_ptr = reinterpret_cast<size_t>(ptr->ptr->blob()->storage().get());
+    auto side_info = ptr->ptr->comp_node().get_free_left_and_right(
+            begin_ptr, begin_ptr + ptr->ptr->blob()->size());
+    double free_mem = side_info.first + side_info.second;
+    return ptr->eval_func(
+            neighbor_cost, free_mem, estimate_timestamp, 1.0, 1.0, 1.0, 1.0001);
+}
+
+TensorInfo* ChannelImpl::DynamicSublinear::pop_best_scored() {
+    // drop stale entries once they outnumber the candidates
+    if (scored_candidates.size() > 2 * candidates.size() + 64) {
+        scored_candidates.clear();
+        dirty_candidates.assign(candidates.begin(), candidates.end());
+    }
+    auto cmp = std::greater<ScoredCandidate>();
+    std::sort(dirty_candidates.begin(), dirty_candidates.end());
+    dirty_candidates.erase(
+            std::unique(dirty_candidates.begin(), dirty_candidates.end()),
+            dirty_candidates.end());
+    for (auto i : dirty_candidates) {
+        auto iter = candidate_version.find(i);
+        if (iter == candidate_version.end()) {
+            continue;
+        }
+        double msps = score(i);
+        if (msps >= 0) {
+            scored_candidates.push_back({msps, iter->second, i});
+            std::push_heap(scored_candidates.begin(), scored_candidates.end(), cmp);
+        }
+    }
+    dirty_candidates.clear();
+
+    auto&& heap = scored_candidates;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), cmp);
+        auto entry = heap.back();
+        heap.pop_back();
+        auto iter = candidate_version.find(entry.ptr);
+        if (iter == candidate_version.end() || iter->second != entry.version) {
+            continue;
+        }
+        double msps = score(entry.ptr);
+        if (msps < 0) {
+            continue;
+        }
+        if (heap.empty() || msps <= heap.front().score) {
+            // the tensor is either evicted or pinned by the caller; push it
+            // back in case it stays a candidate
+            invalidate(entry.ptr);
+            return entry.ptr;
+        }
+        heap.push_back({msps, entry.version, entry.ptr});
+        std::push_heap(heap.begin(), heap.end(), cmp);
+    }
+    return nullptr;
+}
+
+void ChannelImpl::DynamicSublinear::invalidate(TensorInfo* ptr) {
+    auto iter = candidate_version.find(ptr);
+    if (iter != candidate_version.end()) {
+        iter->second = ++next_version;
+        dirty_candidates.push_back(ptr);
+    }
+}
+
+void ChannelImpl::DynamicSublinear::invalidate_neighbors(TensorInfo* ptr) {
+    // estimate_neighbor_cost() of a tensor reads the inputs and outputs of
+    // its producer, so the outputs of the producer and of the users of ptr
+    // depend on it
+    auto invalidate_outputs = [this](TensorInfo::ComputePath* path) {
+        for (auto i : path->outputs) {
+            if (i) {
+                invalidate(i);
+            }
+        }
+    };
+    if (ptr->producer) {
+        invalidate_outputs(ptr->producer);
+    }
+    for (auto path : ptr->users) {
+        invalidate_outputs(path);
+    }
+}
+
+void ChannelImpl::DynamicSublinear::clear_candidates() {
+    candidates.clear();
+    scored_candidates.clear();
+    candidate_version.clear();
+    dirty_candidates.clear();
+}
+
 TensorInfo* ChannelImpl::DynamicSublinear::find_best_tensor(
         bool enable_dtr_sqrt_sampling = false) {
     if (candidates.empty())
         return nullptr;
+    if (!enable_dtr_sqrt_sampling) {
+        return pop_best_scored();
+    }
 
+    // score about sqrt(n) randomly sampled candidates
     double min_msps = -1;
     TensorInfo* best = nullptr;
     size_t sz = 1;
-    if (enable_dtr_sqrt_sampling) {
-        while (sz * sz <= candidates.size())
-            sz++;
-        sz--;
-    } else {
-        sz = candidates.size();
-    }
+    while (sz * sz <= candidates.size())
+        sz++;
+    sz--;
 
     size_t ti = rand() % sz;
     for (size_t vi = 0; vi < sz; vi++) {
-        if (!enable_dtr_sqrt_sampling) {
-            ti = vi;
-        }
         auto i = candidates[ti];
-        if (i->producer && i->ptr && i->evict_type == EvictType::NONE) {
-            double neighbor_cost = estimate_neighbor_cost(i);
-            size_t begin_ptr =
-                    reinterpret_cast<size_t>(i->ptr->blob()->storage().get());
-            auto side_info = i->ptr->comp_node().get_free_left_and_right(
-                    begin_ptr, begin_ptr + i->ptr->blob()->size());
-            double free_mem = side_info.first + side_info.second;
-            double msps = i->eval_func(
-                    neighbor_cost, free_mem, estimate_timestamp, 1.0, 1.0, 1.0, 1.0001);
-            if (min_msps < 0 || msps < min_msps) {
-                min_msps = msps;
-                best = i;
-            }
-        }
-        if (enable_dtr_sqrt_sampling) {
-            ti += rand() % sz;
-            if (ti > candidates.size())
-                break;
+        double msps = score(i);
+        if (msps >= 0 && (min_msps < 0 || msps < min_msps)) {
+            min_msps = msps;
+            best = i;
         }
+        ti += rand() % sz;
+        if (ti >= candidates.size())
+            break;
     }
     return best;
 }
@@ -1419,6 +1620,8 @@ void ChannelImpl::DynamicSublinear::insert_candidate(TensorInfo* ptr) {
             ptr->cand_index);
     ptr->cand_index = candidates.size();
     candidates.push_back(ptr);
+    candidate_version[ptr] = ++next_version;
+    dirty_candidates.push_back(ptr);
     if (!comp_node.valid()) {
         comp_node = ptr->ptr->comp_node();
     }
@@ -1436,9 +1639,94 @@ void ChannelImpl::DynamicSublinear::erase_candidate(TensorInfo* ptr) {
         candidates[ptr->cand_index]->cand_index = ptr->cand_index;
         candidates.pop_back();
         ptr->cand_index = UINT_MAX;
+        candidate_version.erase(ptr);
     }
 }
 
 void ChannelImpl::DynamicSublinear::update_used_time(TensorInfo* ptr) {
     ptr->last_used_time = estimate_timestamp;
+    invalidate(ptr);
+}
+
+size_t ChannelImpl::DynamicSublinear::MeasuredCost::key(
+        const OpDef& op, const SmallVector<TensorPtr>& inputs) {
+    size_t ret = op.hash();
+    for (auto&& i : inputs) {
+        auto&& layout = i->layout();
+        ret = hash_pair_combine(ret, static_cast<size_t>(layout.dtype.enumv()));
+        for (size_t j = 0; j < layout.ndim; ++j) {
+            ret = hash_pair_combine(ret, layout.shape[j]);
+        }
+    }
+    return ret;
+}
+
+std::unique_ptr<CompNode::Event> ChannelImpl::DynamicSublinear::MeasuredCost::
+        alloc_event(CompNode cn) {
+    for (auto&& i : free_events) {
+        if (i->comp_node() == cn) {
+            auto ret = std::move(i);
+            i = std::move(free_events.back());
+            free_events.pop_back();
+            return ret;
+        }
+    }
+    return cn.create_event(CompNode::Event::NEED_TIMER);
+}
+
+bool ChannelImpl::DynamicSublinear::MeasuredCost::start(size_t key, CompNode cn) {
+    if (seconds.count(key)) {
+        return false;
+    }
+    for (auto&& i : pending) {
+        if (i.key == key) {
+            return false;
+        }
+    }
+    pending.push_back({key, 0, alloc_event(cn), alloc_event(cn)});
+    pending.back().start->record();
+    return true;
+}
+
+void ChannelImpl::DynamicSublinear::MeasuredCost::stop(double estimate) {
+    mgb_assert(!pending.empty());
+    pending.back().estimate = estimate;
+    pending.back().end->record();
+}
+
+void ChannelImpl::DynamicSublinear::MeasuredCost::cancel() {
+    mgb_assert(!pending.empty());
+    auto&& i = pending.back();
+    free_events.push_back(std::move(i.start));
+    free_events.push_back(std::move(i.end));
+    pending.pop_back();
+}
+
+void ChannelImpl::DynamicSublinear::MeasuredCost::poll() {
+    while (!pending.empty() && pending.front().end->finished()) {
+        auto&& i = pending.front();
+        double t = i.start->elapsed_time_until(*i.end);
+        seconds[i.key] = t;
+        sum_estimate += i.estimate;
+        sum_seconds += t;
+        free_events.push_back(std::move(i.start));
+        free_events.push_back(std::move(i.end));
+        pending.pop_front();
+    }
+}
+
+double ChannelImpl::DynamicSublinear::MeasuredCost::get(
+        size_t key, double estimate) const {
+    auto iter = seconds.find(key);
+    if (iter == seconds.end() || sum_seconds <= 0) {
+        return estimate;
+    }
+    return iter->second * sum_estimate / sum_seconds;
+}
+
+void ChannelImpl::DynamicSublinear::MeasuredCost::clear() {
+    seconds.clear();
+    pending.clear();
+    free_events.clear();
+    sum_estimate = sum_seconds = 0;
 }
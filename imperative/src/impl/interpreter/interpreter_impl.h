@@ -16,6 +16,7 @@
 #include <list>
 #include <stack>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 #include <variant>
 #include "megbrain/comp_node.h"
@@ -93,6 +94,27 @@ private:
     TensorPtr wait_tensor(TensorInfo* info, profiler::TensorProp prop);
     void notify_tensor_unsafe(TensorInfo* info);
 
+    /*!
+     * \brief send a command to the worker
+     *
+     * ApplyOp commands are held back while the worker is busy, and sent as
+     * one ApplyOpBatch command when the batch is full, any other command is
+     * submitted, or the worker has processed all queued commands; see
+     * option command_batch_size.
+     */
+    void submit(Command cmd);
+
+    //! send the held back ApplyOp commands; must be called before waiting
+    //! for the worker
+    void flush_pending_applies();
+    void flush_pending_applies_unsafe();
+
+    //! called by the worker after each command
+    void on_worker_task_finished();
+
+    //! push \p cmd, which carries \p nr_command ops, to the worker queue
+    void add_task(Command cmd, size_t nr_command);
+
     void process_one_task(Command&);
 
     void check_worker_exc_unsafe();
@@ -140,6 +162,13 @@ private:
     std::stack<std::tuple<ApplyOp, size_t, TensorInfo*, std::string>> m_apply_stack;
     bool m_applying = false;
     bool m_closed = false;
+    //! ApplyOp commands not sent to the worker yet and the trace of the
+    //! first one, see submit(); guarded by m_pending_mutex
+    SmallVector<ApplyOp> m_pending_applies;
+    StackManager::Trace m_pending_trace;
+    std::mutex m_pending_mutex;
+    //! number of commands pushed to the worker but not processed yet
+    std::atomic_size_t m_nr_queued_cmd{0};
 
     struct WorkQueue : AsyncQueueSC<Command, WorkQueue> {
         // set max_spin=0 to prevent Queue fetch task in busy wait manner.
@@ -161,7 +190,7 @@ private:
                 update_max_items(val);
             }
         }
-        void process_one_task(Command& icmd) { m_owner->process_one_task(icmd); }
+        void process_one_task(Command& icmd);
         void on_async_queue_worker_thread_start() override;
 
     private:
@@ -203,11 +232,34 @@ private:
          * (2) is in memory, (3) is not pinned. Evaluation function refers to:
          * @see: TensorInfo::eval_func.
          *
+         * Without sampling, the best tensor is taken from scored_candidates
+         * rather than by scoring all candidates.
+         *
          * \return the pointer of the best tensor; nullptr is returned if no
          * available tensor is found
          */
         TensorInfo* find_best_tensor(bool);
 
+        //! score of a candidate, or a negative value if it is not available
+        double score(TensorInfo* ptr);
+
+        //! pop the best candidate from scored_candidates
+        TensorInfo* pop_best_scored();
+
+        /*!
+         * \brief mark the score of a candidate as changed
+         *
+         * Its entries in scored_candidates become stale, and it is scored
+         * again by the next find_best_tensor().
+         */
+        void invalidate(TensorInfo* ptr);
+
+        //! invalidate candidates whose neighbor cost depends on ptr
+        void invalidate_neighbors(TensorInfo* ptr);
+
+        //! clear the candidate set and the index on it
+        void clear_candidates();
+
         /*!
          * \brief estimate the cost of recomputing tensor ptr
          *
@@ -286,6 +338,86 @@ private:
         //! store all tensors that may be evicted
         SmallVector<TensorInfo*> candidates;
 
+        struct ScoredCandidate {
+            double score;
+            size_t version;
+            TensorInfo* ptr;
+
+            bool operator>(const ScoredCandidate& rhs) const {
+                return score > rhs.score;
+            }
+        };
+
+        /*!
+         * \brief min-heap of scored candidates, kept across evictions
+         *
+         * An entry is valid while the version of its tensor in
+         * candidate_version is unchanged, so a tensor is looked up only
+         * through candidate_version and freed tensors are never accessed.
+         * Versions are changed when the last used time or the neighbor cost
+         * of a tensor changes. The free memory around a tensor and the
+         * current time also affect its score but are not tracked, so the
+         * popped tensor is scored again and pushed back unless it is still
+         * no worse than the next one.
+         */
+        std::vector<ScoredCandidate> scored_candidates;
+
+        //! current score version of each candidate
+        std::unordered_map<TensorInfo*, size_t> candidate_version;
+
+        //! candidates to be scored and pushed by the next find_best_tensor()
+        std::vector<TensorInfo*> dirty_candidates;
+
+        size_t next_version = 0;
+
+        /*!
+         * \brief measured device time of ops
+         *
+         * If enabled by option enable_dtr_measured_cost, the first
+         * application of an op on each input layout is timed by events on
+         * the device, and later applications use the measured time as their
+         * recompute cost instead of the estimate from tensor sizes.
+         */
+        struct MeasuredCost {
+            struct Pending {
+                size_t key;
+                double estimate;
+                std::unique_ptr<CompNode::Event> start, end;
+            };
+
+            //! seconds measured for each key
+            std::unordered_map<size_t, double> seconds;
+            std::deque<Pending> pending;
+            //! events of finished measurements, for reuse
+            std::vector<std::unique_ptr<CompNode::Event>> free_events;
+            //! sums over finished measurements, to convert seconds into
+            //! the unit of estimated cost
+            double sum_estimate = 0, sum_seconds = 0;
+
+            //! identify an op applied on given inputs
+            static size_t key(const OpDef& op, const SmallVector<TensorPtr>& inputs);
+
+            std::unique_ptr<CompNode::Event> alloc_event(CompNode cn);
+
+            //! start measuring; return false if already measured or pending
+            bool start(size_t key, CompNode cn);
+
+            //! stop the measurement started by the last start()
+            void stop(double estimate);
+
+            //! discard the measurement started by the last start()
+            void cancel();
+
+            //! collect finished measurements
+            void poll();
+
+            //! measured cost in the unit of \p estimate, or \p estimate
+            //! itself if the key has not been measured
+            double get(size_t key, double estimate) const;
+
+            void clear();
+        } measured_cost;
+
         bool is_bad_op(std::string op_name) {
             return std::find(op_blacklist.begin(), op_blacklist.end(), op_name) !=
                    op_blacklist.end();
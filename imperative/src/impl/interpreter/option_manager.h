@@ -46,6 +46,10 @@ public:
             "device is gpu.");
     DEF_OPTION(enable_dtr_auto_drop, "MEGENGINE_DTR_AUTO_DROP", 0, "");
     DEF_OPTION(enable_dtr_sqrt_sampling, "MEGENGINE_DTR_SQRT_SAMPLING", 0, "");
+    DEF_OPTION(
+            enable_dtr_measured_cost, "MEGENGINE_DTR_MEASURED_COST", 0,
+            "use device time measured on the first run of each op as its "
+            "recompute cost in dtr, instead of an estimate from tensor sizes");
     DEF_OPTION(
             dtr_eviction_threshold, "MEGENGINE_DTR_EVICTION_THRESHOLD", 0,
             "auto drop will start whenever gpu memory usage exceeds this value.");
@@ -53,6 +57,10 @@ public:
             dtr_evictee_minimum_size, "MEGENGINE_DTR_EVICTEE_MINIMUM_SIZE", 1048576,
             "the minimum memory value of a tensor added to the candidate set");
     DEF_OPTION(record_computing_path, "MEGENGINE_RECORD_COMPUTING_PATH", 0, "");
+    DEF_OPTION(
+            command_batch_size, "MEGENGINE_COMMAND_BATCH_SIZE", 16,
+            "max number of consecutive ops sent to the worker as one command; ops are "
+            "only held back while the worker is busy. 0 or 1 to disable batching");
 
 #undef DEF_OPTION
 
@@ -445,6 +445,20 @@ OP_TRAIT_REG(Diag, Diag).apply_on_var_node(apply_on_var_node).fallback();
 }  // namespace diag
 }  // namespace
 
+namespace {
+namespace embedding_bag {
+auto apply_on_var_node(const OpDef& def, const VarNodeArray& inputs) {
+    auto&& op = static_cast<const EmbeddingBag&>(def);
+    mgb_assert(inputs.size() == 3);
+    OperatorNodeConfig config{op.make_name()};
+    return opr::EmbeddingBag::make(inputs[0], inputs[1], inputs[2], op.param(), config);
+}
+OP_TRAIT_REG(EmbeddingBag, EmbeddingBag)
+        .apply_on_var_node(apply_on_var_node)
+        .fallback();
+}  // namespace embedding_bag
+}  // namespace
+
 namespace {
 namespace roi_pooling {
 VarNodeArray apply_on_var_node(const OpDef& def, const VarNodeArray& inputs) {
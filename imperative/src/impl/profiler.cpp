@@ -11,7 +11,17 @@
 
 #include "megbrain/imperative/profiler.h"
 
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <process.h>
+#else
+#error Unsupported platform
+#endif
+
+#include <algorithm>
 #include <chrono>
+#include <csignal>
 
 #include "megbrain/imperative/ops/opr_attr.h"
 #include "megbrain/imperative/physical_tensor.h"
@@ -69,6 +79,239 @@ void Profiler::dump_profile(std::string basename, std::string format, bundle_t r
     return (iter->second)(basename, std::move(result));
 }
 
+/* ========================== SamplingProfiler ========================== */
+
+struct SamplingProfiler::ThreadBuffer {
+    std::thread::id tid;
+    size_t generation;
+    Config config;
+    profiler::HostTime start_at;
+    //! written by owner thread only, samples[i % size] holds the i-th sample
+    std::vector<Sample> samples;
+    std::atomic_uint64_t head{0};
+    uint64_t nr_op = 0;
+    //! guards aggregated results, which are also read by collect()
+    std::mutex mutex;
+    std::unordered_map<const char*, Histogram> histograms;
+    SmallVector<std::pair<CompNode, size_t>> memory_high_water;
+    //! set when the owner thread exits, and the buffer is freed by next start()
+    std::atomic_bool exited{false};
+
+    void reset(size_t new_generation) {
+        generation = new_generation;
+        config = sm_config;
+        start_at = sm_start_at;
+        samples.assign(std::max<size_t>(config.capacity, 1), Sample{});
+        head.store(0, std::memory_order_relaxed);
+        nr_op = 0;
+        histograms.clear();
+        memory_high_water.clear();
+    }
+};
+
+std::atomic_bool SamplingProfiler::sm_enabled{false};
+std::atomic_bool SamplingProfiler::sm_dump_requested{false};
+std::atomic_size_t SamplingProfiler::sm_generation{0};
+std::mutex SamplingProfiler::sm_mutex;
+SamplingProfiler::Config SamplingProfiler::sm_config;
+profiler::HostTime SamplingProfiler::sm_start_at = profiler::HostTime::min();
+std::string SamplingProfiler::sm_signal_basename;
+std::vector<std::unique_ptr<SamplingProfiler::ThreadBuffer>>
+        SamplingProfiler::sm_buffers;
+
+auto SamplingProfiler::get_buffer() -> ThreadBuffer& {
+    struct BufferOwner {
+        ThreadBuffer* buffer = nullptr;
+        ~BufferOwner() {
+            if (buffer) {
+                buffer->exited.store(true, std::memory_order_release);
+            }
+        }
+    };
+    thread_local BufferOwner tm_owner;
+    auto*& buffer = tm_owner.buffer;
+    auto generation = sm_generation.load(std::memory_order_acquire);
+    if (!buffer || buffer->generation != generation) {
+        MGB_LOCK_GUARD(sm_mutex);
+        // each thread keeps a single buffer, which is reset for each run
+        if (!buffer) {
+            auto new_buffer = std::make_unique<ThreadBuffer>();
+            new_buffer->tid = std::this_thread::get_id();
+            buffer = new_buffer.get();
+            sm_buffers.push_back(std::move(new_buffer));
+        }
+        buffer->reset(sm_generation.load());
+    }
+    return *buffer;
+}
+
+bool SamplingProfiler::should_sample() {
+    if (!is_enabled()) {
+        return false;
+    }
+    if (sm_dump_requested.load(std::memory_order_relaxed) &&
+        sm_dump_requested.exchange(false)) {
+        dump(ssprintf(
+                "%s.%d.chrome_timeline.json", sm_signal_basename.c_str(),
+                static_cast<int>(getpid())));
+    }
+    auto& buffer = get_buffer();
+    auto&& config = buffer.config;
+    if (config.sample_rate && ++buffer.nr_op % config.sample_rate == 0) {
+        return true;
+    }
+    if (config.period_us) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                               Timer::record_host() - buffer.start_at)
+                               .count();
+        return static_cast<uint64_t>(elapsed) % config.period_us < config.window_us;
+    }
+    return false;
+}
+
+void SamplingProfiler::record(
+        const char* name, profiler::HostTime start, CompNode device) {
+    auto& buffer = get_buffer();
+    if (buffer.config.sync_device && device.valid()) {
+        device.sync();
+    }
+    Sample sample{name, start, Timer::record_host() - start, device, 0};
+    if (device.valid()) {
+        // bytes allocated by the comp node allocator, which is cheap to query
+        // unlike the device-wide memory status
+        sample.used_memory = device.get_used_memory();
+    }
+    auto head = buffer.head.load(std::memory_order_relaxed);
+    buffer.samples[head % buffer.samples.size()] = sample;
+    buffer.head.store(head + 1, std::memory_order_release);
+
+    // bucket i holds latency in [2^(i-1), 2^i) us, and bucket 0 holds those below 1us
+    uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+                          sample.duration)
+                          .count();
+    size_t bucket = 0;
+    while ((us >> bucket) && bucket + 1 < NR_BUCKETS) {
+        ++bucket;
+    }
+    MGB_LOCK_GUARD(buffer.mutex);
+    auto& histogram = buffer.histograms[name];
+    ++histogram.count;
+    histogram.total += sample.duration;
+    histogram.max = std::max(histogram.max, sample.duration);
+    ++histogram.buckets[bucket];
+    if (device.valid()) {
+        auto iter = std::find_if(
+                buffer.memory_high_water.begin(), buffer.memory_high_water.end(),
+                [&](auto&& item) { return item.first == device; });
+        if (iter == buffer.memory_high_water.end()) {
+            buffer.memory_high_water.push_back({device, sample.used_memory});
+        } else {
+            iter->second = std::max(iter->second, sample.used_memory);
+        }
+    }
+}
+
+void SamplingProfiler::start(Config config) {
+    mgb_assert(
+            config.sample_rate || (config.period_us && config.window_us),
+            "either sample rate or time window should be specified");
+    MGB_LOCK_GUARD(sm_mutex);
+    sm_config = config;
+    sm_start_at = Timer::record_host();
+    ++sm_generation;
+    // buffers of exited threads only hold samples of previous runs
+    sm_buffers.erase(
+            std::remove_if(
+                    sm_buffers.begin(), sm_buffers.end(),
+                    [](auto&& buffer) {
+                        return buffer->exited.load(std::memory_order_acquire);
+                    }),
+            sm_buffers.end());
+    sm_enabled.store(true, std::memory_order_release);
+}
+
+void SamplingProfiler::stop() {
+    sm_enabled.store(false, std::memory_order_release);
+}
+
+auto SamplingProfiler::collect() -> Bundle {
+    Bundle bundle;
+    MGB_LOCK_GUARD(sm_mutex);
+    bundle.start_at = sm_start_at;
+    auto generation = sm_generation.load();
+    for (auto&& buffer : sm_buffers) {
+        if (buffer->generation != generation) {
+            continue;
+        }
+        bundle.thread_dict[buffer->tid] = sys::get_thread_name(buffer->tid);
+        uint64_t capacity = buffer->samples.size();
+        auto head = buffer->head.load(std::memory_order_acquire);
+        auto begin = head > capacity ? head - capacity : 0;
+        std::vector<Sample> samples;
+        for (auto i = begin; i < head; ++i) {
+            samples.push_back(buffer->samples[i % capacity]);
+        }
+        // drop samples whose slots may have been overwritten while copying, including
+        // the one being written now
+        auto new_head = buffer->head.load(std::memory_order_acquire) + 1;
+        auto valid_begin = new_head > capacity ? new_head - capacity : 0;
+        for (auto i = std::max(begin, valid_begin); i < head; ++i) {
+            bundle.samples.push_back({buffer->tid, samples[i - begin]});
+        }
+        MGB_LOCK_GUARD(buffer->mutex);
+        for (auto&& [name, histogram] : buffer->histograms) {
+            auto& dest = bundle.histograms[name ? name : "unknown"];
+            dest.count += histogram.count;
+            dest.total += histogram.total;
+            dest.max = std::max(dest.max, histogram.max);
+            for (size_t i = 0; i < NR_BUCKETS; ++i) {
+                dest.buckets[i] += histogram.buckets[i];
+            }
+        }
+        for (auto&& [device, used] : buffer->memory_high_water) {
+            auto& dest = bundle.memory_high_water[device.to_string()];
+            dest = std::max(dest, used);
+        }
+    }
+    std::sort(bundle.samples.begin(), bundle.samples.end(), [](auto& lhs, auto& rhs) {
+        return lhs.second.start < rhs.second.start;
+    });
+    return bundle;
+}
+
+void SamplingProfiler::dump(std::string filename) {
+    profiler::dump_sampled_chrome_timeline(filename, collect());
+}
+
+namespace {
+void on_dump_signal(int) {
+    SamplingProfiler::request_dump();
+}
+}  // namespace
+
+void SamplingProfiler::dump_on_signal(int signum, std::string basename) {
+    {
+        MGB_LOCK_GUARD(sm_mutex);
+        sm_signal_basename = std::move(basename);
+    }
+    std::signal(signum, on_dump_signal);
+}
+
+void SamplingProfiler::init_from_env() {
+    auto sample_rate = MGB_GETENV("MEGENGINE_SAMPLING_PROFILE");
+    if (!sample_rate) {
+        return;
+    }
+    Config config;
+    config.sample_rate = std::stoul(sample_rate);
+    start(config);
+#ifdef SIGUSR2
+    if (auto basename = MGB_GETENV("MEGENGINE_SAMPLING_PROFILE_DUMP")) {
+        dump_on_signal(SIGUSR2, basename);
+    }
+#endif
+}
+
 }  // namespace imperative
 
 }  // namespace mgb
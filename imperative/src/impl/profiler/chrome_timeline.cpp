@@ -429,4 +429,60 @@ void dump_chrome_timeline(std::string filename, Profiler::bundle_t result) {
     mgb::debug::write_to_file(filename.c_str(), json_repr);
 }
 
+void dump_sampled_chrome_timeline(
+        std::string filename, SamplingProfiler::Bundle result) {
+    ChromeTraceEvents trace_events;
+    auto pid = getpid();
+    std::unordered_map<std::thread::id, uint64_t> tids;
+    for (auto&& [tid, name] : result.thread_dict) {
+        tids.insert({tid, tids.size()});
+        trace_events.new_event()
+                .name("thread_name")
+                .pid('M')
+                .tid(tids.at(tid))
+                .arg("name", name);
+    }
+    for (auto&& [tid, sample] : result.samples) {
+        auto dur = std::chrono::duration_cast<std::chrono::microseconds>(
+                sample.duration);
+        auto& event = trace_events.new_event()
+                              .name(sample.name ? sample.name : "unknown")
+                              .ph('X')
+                              .pid(pid)
+                              .tid(tids.at(tid))
+                              .ts(sample.start - result.start_at)
+                              .dur(dur.count());
+        if (sample.device.valid()) {
+            auto device_name = sample.device.to_string();
+            event.arg("device", device_name);
+            trace_events.new_event()
+                    .name(ssprintf("%s_used_mem", device_name.c_str()))
+                    .ph('C')
+                    .pid(pid)
+                    .tid(tids.at(tid))
+                    .ts(sample.start - result.start_at)
+                    .arg("value", sample.used_memory);
+        }
+    }
+    nlohmann::json histograms;
+    for (auto&& [name, histogram] : result.histograms) {
+        auto to_us = [](profiler::Duration duration) {
+            using us_t = std::chrono::duration<double, std::micro>;
+            return std::chrono::duration_cast<us_t>(duration).count();
+        };
+        histograms[name] = {
+                {"count", histogram.count},
+                {"mean_us", to_us(histogram.total) / histogram.count},
+                {"max_us", to_us(histogram.max)},
+                {"log2_us_buckets", histogram.buckets},
+        };
+    }
+    trace_events.metadata("localTime") =
+            std::to_string(result.start_at.time_since_epoch().count());
+    trace_events.metadata("latencyHistograms") = nlohmann::to_string(histograms);
+    trace_events.metadata("memoryHighWater") =
+            nlohmann::to_string(nlohmann::json(result.memory_high_water));
+    mgb::debug::write_to_file(filename.c_str(), trace_events.to_string());
+}
+
 }  // namespace mgb::imperative::profiler
@@ -146,6 +146,13 @@ DEF_DUR_EVENT(SampleDevice, {
 
 DEF_EVENT(WorkerException, {});
 
+//! \p nr_command ops were pushed to the worker queue as one command, taking
+//! \p duration_ns on the channel thread
+DEF_EVENT(CommandSubmit, {
+    size_t nr_command;
+    uint64_t duration_ns;
+});
+
 DEF_EVENT(ShapeInfer, { bool success; });
 
 DEF_DUR_EVENT(Scope, { std::string name; });
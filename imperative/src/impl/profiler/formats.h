@@ -23,4 +23,7 @@ void dump_chrome_timeline(std::string filename, Profiler::bundle_t result);
 
 void dump_memory_flow(std::string filename, Profiler::bundle_t result);
 
+void dump_sampled_chrome_timeline(
+        std::string filename, SamplingProfiler::Bundle result);
+
 }  // namespace mgb::imperative::profiler
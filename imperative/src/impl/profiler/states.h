@@ -272,7 +272,7 @@ public:
                 TensorCommandEvent, TensorCommandFinishEvent, AutoEvictEvent,
                 AutoEvictFinishEvent, CustomEvent, CustomFinishEvent, RecordDeviceEvent,
                 ScopeEvent, ScopeFinishEvent, HostToDeviceEvent,
-                HostToDeviceFinishEvent>
+                HostToDeviceFinishEvent, CommandSubmitEvent>
                 converter;
 
         auto for_each_entry = [&](auto&& handler) {
@@ -392,6 +392,10 @@ public:
                 }
             } else if constexpr (std::is_same_v<T, WorkerExceptionEvent>) {
                 inc_counter("nr_exception", 1);
+            } else if constexpr (std::is_same_v<T, CommandSubmitEvent>) {
+                inc_counter("nr_command_submitted", event.nr_command);
+                inc_counter("nr_command_batch", 1);
+                inc_counter("command_submit_ns", event.duration_ns);
             } else if constexpr (std::is_same_v<T, KernelLaunchFinishEvent>) {
                 auto& execution = current_op->executions.back();
                 if (execution.reason == "dtr") {
@@ -72,7 +72,14 @@ public:
 
     static SymbolVar make(ComputingGraph& graph, Tensor& tensor) {
         auto opr = graph.insert_opr(std::make_unique<InputPlaceholder>(graph, &tensor));
-        auto var = opr->output(0);
+        return opr->cast_final<InputPlaceholder>().bind(tensor);
+    }
+
+    //! bind to \p tensor, so that the placeholder could be reused
+    VarNode* bind(Tensor& tensor) {
+        m_tensor = &tensor;
+        m_static_infer_value = {};
+        auto var = output(0);
         auto&& dev_tensor = tensor.dev_tensor();
         var->m_comp_node = dev_tensor.comp_node();
         var->m_shape = dev_tensor.shape();
@@ -98,6 +105,9 @@ public:
         return var;
     }
 
+    //! whether input value has been read by static inference since bind()
+    bool static_infer_value_used() const { return !m_static_infer_value.empty(); }
+
     const DeviceTensorND* get_static_infer_value(bool may_sync) {
         if (!m_static_infer_value.empty()) {
             return &m_static_infer_value;
@@ -226,6 +236,13 @@ public:
         inferred_outputs.clear();
     }
 
+    //! drop inferred shapes and values but keep infer descs of cur_opr
+    void reset_results() {
+        for (auto&& i : inferred_outputs) {
+            i = {};
+        }
+    }
+
     template <bool is_shape>
     auto do_infer(Tag dest, bool may_sync)
             -> const std::conditional_t<is_shape, TensorShape, DeviceTensorND>* {
@@ -464,6 +481,8 @@ public:
     }
     size_t get_device_memory_size(CompNode cn) override { mgb_assert(0); }
     size_t clear_device_memory() override { mgb_assert(0); }
+    MemFragmentation get_mem_fragmentation(CompNode) override { mgb_assert(0); }
+    size_t compact_dynamic_memory() override { mgb_assert(0); }
     void set_as_subgraph(ComputingGraph& par_graph) override { mgb_assert(0); }
 };
 
@@ -477,6 +496,8 @@ ProxyGraph::ProxyGraph()
 
 void ProxyGraph::reset() {
     mgb_assert(!m_cur_opr);
+    m_opr_cache.clear();
+    m_static_infer_manager->clear();
     m_graph = ProxyGraphImpl::make(this);
 }
 
@@ -512,7 +533,7 @@ SmallVector<LogicalTensorDesc> ProxyGraph::infer_output_attrs(
     CUR_OPR_GUARD(get_proxy_opr(opdef, inputs));
     ::mgb::opr::intl::WorkspaceLimitHook::set_impl(
             m_graph.get(), ProxyGraph::get_workspace_limit);
-    do_shape_infer(true);
+    infer_cur_opr_shape(0);
     for (auto&& i : m_cur_opr->usable_output()) {
         mgb_assert(i->dtype().valid() && i->comp_node().valid());
         mgb_assert(i->shape().ndim || i->contain_flag(VarNode::Flag::NO_SYS_MEM_ALLOC));
@@ -540,9 +561,15 @@ void ProxyGraph::cleanup() {
         for (auto&& i : m_cur_opr->output()) {
             i->m_dev_tensor.storage({});
         }
-        m_static_infer_manager->clear();
+        if (m_cur_cached_opr) {
+            // keep infer descs of the cached opr, only drop inferred results
+            m_static_infer_manager->reset_results();
+        } else {
+            m_static_infer_manager->clear();
+        }
     }
     m_cur_opr = nullptr;
+    m_cur_cached_opr = nullptr;
 }
 
 void ProxyGraph::init_output_tensor(
@@ -558,7 +585,11 @@ void ProxyGraph::init_output_tensor(
         return limit;
     };
     ::mgb::opr::intl::WorkspaceLimitHook::set_impl(m_graph.get(), get_workspace_size);
-    do_shape_infer(true);
+    if (workspaces.empty()) {
+        infer_cur_opr_shape(1);
+    } else {
+        do_shape_infer(true);
+    }
 
     size_t j = 0;
     size_t k = 0;
@@ -612,6 +643,49 @@ void ProxyGraph::init_output_tensor(
 
 cg::OperatorNodeBase* ProxyGraph::get_proxy_opr(
         const OpDef& opdef, const SmallVector<Tensor*>& inputs) {
+    size_t buf_size = 1 + 2 * inputs.size();
+    for (auto&& i : inputs) {
+        buf_size += 2 * i->layout().ndim;
+    }
+    SmallVector<size_t> buf(buf_size);
+    size_t pos = 0;
+    buf[pos++] = opdef.hash();
+    for (auto&& i : inputs) {
+        auto&& layout = i->layout();
+        buf[pos++] = mgb::hash(layout.dtype.handle());
+        buf[pos++] = mgb::hash(i->comp_node());
+        for (size_t j = 0; j < layout.ndim; ++j) {
+            buf[pos++] = layout.shape[j];
+            buf[pos++] = layout.stride[j];
+        }
+    }
+    mgb_assert(pos == buf_size);
+    auto key = XXHash{}.update(buf.data(), buf_size * sizeof(size_t)).digest();
+
+    auto match = [&](const CachedOpr& entry) {
+        if (!entry.op->is_same(opdef) || entry.layouts.size() != inputs.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (entry.comp_nodes[i] != inputs[i]->comp_node() ||
+                !entry.layouts[i].eq_layout(inputs[i]->layout())) {
+                return false;
+            }
+        }
+        return true;
+    };
+    auto range = m_opr_cache.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (match(it->second)) {
+            auto&& entry = it->second;
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                entry.placeholders[i]->bind(*inputs[i]);
+            }
+            m_cur_cached_opr = &entry;
+            return entry.opr;
+        }
+    }
+
     VarNodeArray vinputs(inputs.size());
     for (size_t i = 0; i < inputs.size(); ++i) {
         vinputs[i] = InputPlaceholder::make(*m_graph, *inputs[i]).node();
@@ -621,9 +695,49 @@ cg::OperatorNodeBase* ProxyGraph::get_proxy_opr(
     for (auto&& i : opr->input()) {
         mgb_assert(i->owner_opr()->same_type<InputPlaceholder>());
     }
+
+    CachedOpr entry;
+    entry.op = const_cast<OpDef&>(opdef).shared_from_this();
+    entry.opr = opr;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        entry.layouts.push_back(inputs[i]->layout());
+        entry.comp_nodes.push_back(inputs[i]->comp_node());
+        entry.placeholders.push_back(
+                &vinputs[i]->owner_opr()->cast_final<InputPlaceholder>());
+    }
+    m_cur_cached_opr = &m_opr_cache.emplace(key, std::move(entry))->second;
     return opr;
 }
 
+void ProxyGraph::infer_cur_opr_shape(size_t phase) {
+    auto&& outputs = m_cur_opr->output();
+    auto* entry = m_cur_cached_opr;
+    if (entry && entry->output_shapes[phase]) {
+        // infer descs are still needed by oprs calling static infer in execute
+        m_static_infer_manager->update();
+        auto&& shapes = *entry->output_shapes[phase];
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            outputs[i]->shape(shapes[i]);
+        }
+        return;
+    }
+    do_shape_infer(true);
+    if (!entry || entry->value_dependent) {
+        return;
+    }
+    for (auto* i : entry->placeholders) {
+        if (i->static_infer_value_used()) {
+            // shapes depend on input values, e.g. target shape of Reshape
+            entry->value_dependent = true;
+            return;
+        }
+    }
+    auto&& shapes = entry->output_shapes[phase].emplace();
+    for (auto* i : outputs) {
+        shapes.push_back(i->shape());
+    }
+}
+
 /*********************** Logical Tensor Impl ***********************/
 
 std::tuple<SmallVector<LogicalTensorDesc>, bool> ProxyGraph::
@@ -18,6 +18,9 @@
 
 #include "megbrain/imperative/ops/backward_graph.h"
 
+#include <optional>
+#include <unordered_map>
+
 namespace mgb {
 namespace imperative {
 
@@ -67,6 +70,26 @@ private:
     struct GradGraph;
     class CurOprGuard;
 
+    /*!
+     * \brief a proxy opr reused by all invocations of the same op on inputs
+     *      with the same layouts and comp nodes
+     *
+     * Reusing the opr keeps its megdnn operator and the algorithm chosen for
+     * it; output and workspace shapes are memoized as well unless shape
+     * inference depends on input values.
+     */
+    struct CachedOpr {
+        std::shared_ptr<OpDef> op;
+        SmallVector<TensorLayout> layouts;
+        SmallVector<CompNode> comp_nodes;
+        cg::OperatorNodeBase* opr;
+        SmallVector<InputPlaceholder*> placeholders;
+        bool value_dependent = false;
+        //! shapes of all outputs, inferred for infer_output_attrs (0) and
+        //! for invoke_op without user given workspaces (1)
+        std::optional<TensorShapeArray> output_shapes[2];
+    };
+
     void reset();
 
     /********************** Physical Tensor Helper **********************/
@@ -79,6 +102,9 @@ private:
     cg::OperatorNodeBase* get_proxy_opr(
             const OpDef& opdef, const SmallVector<Tensor*>& inputs);
 
+    //! infer output shapes of m_cur_opr, or take them from its cache entry
+    void infer_cur_opr_shape(size_t phase);
+
     /********************** Logical Tensor Helper **********************/
 
     cg::VarNodeArray make_input_place_holders(
@@ -91,8 +117,15 @@ private:
     TensorPtr as_tensor(cg::OperatorNodeBase* opr, bool share = true);
 
     cg::OperatorNodeBase* m_cur_opr = nullptr;
+    //! cache entry of m_cur_opr, or nullptr if it is not cached
+    CachedOpr* m_cur_cached_opr = nullptr;
+    //! cached proxy oprs keyed by hash of op and input layouts; they live in
+    //! m_graph and are dropped with it
+    std::unordered_multimap<size_t, CachedOpr> m_opr_cache;
     std::unique_ptr<ProxyGraphImpl> m_graph;
-    size_t m_max_op_cnt = 100;
+    //! cached oprs stay in the graph, so the limit must be well above the
+    //! number of distinct ops in a training step
+    size_t m_max_op_cnt = 1000;
     std::unique_ptr<ExecEnv> m_env;
     std::unique_ptr<StaticInferManager> m_static_infer_manager;
     std::unique_ptr<SeqCompNodeOptimizer> m_seq_comp_node_optimizer;
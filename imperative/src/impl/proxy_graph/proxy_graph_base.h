@@ -107,6 +107,8 @@ protected:
     }
     size_t get_device_memory_size(CompNode) override { mgb_assert(0); }
     size_t clear_device_memory() override { mgb_assert(0); }
+    MemFragmentation get_mem_fragmentation(CompNode) override { mgb_assert(0); }
+    size_t compact_dynamic_memory() override { mgb_assert(0); }
     void set_as_subgraph(ComputingGraph&) override { mgb_assert(0); }
     void record_async_error(std::unique_ptr<MegBrainError>) override { mgb_assert(0); }
 };
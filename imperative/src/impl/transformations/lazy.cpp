@@ -13,7 +13,9 @@
 #include "megbrain/imperative/opr_utility.h"
 #include "megbrain/imperative/ops/autogen.h"
 
+#include "megbrain/opr/basic_arith.h"
 #include "megbrain/opr/utility.h"
+#include "megbrain/utils/hash.h"
 
 #include "../async_releaser.h"
 #include "../mgb_cg_impl.h"
@@ -21,6 +23,28 @@
 namespace mgb {
 namespace imperative {
 
+namespace {
+//! tags of the records in the key of a window
+enum WindowKeyTag : size_t {
+    WINDOW_INPUT = 1,
+    WINDOW_CONST,
+    WINDOW_OP,
+    WINDOW_OUTPUTS,
+};
+
+void set_priority_to_id(const ComputingGraph::OutputSpec& output_specs) {
+    auto on_opr = [](mgb::cg::OperatorNodeBase* opr) {
+        if (opr->node_prop().attribute().priority == 0) {
+            opr->node_prop().attribute().priority = opr->id();
+        }
+    };
+    mgb::cg::DepOprIter dep_iter{on_opr};
+    for (auto&& output_spec : output_specs) {
+        dep_iter.add(output_spec.first);
+    }
+}
+}  // anonymous namespace
+
 ValueRefList LazyEvalTransformation::apply_transformation(
         const Operator& op, Span<ValueRef> inputs) {
     if (auto* op_val = op.as<ApplyOp>()) {
@@ -34,6 +58,8 @@ ValueRefList LazyEvalTransformation::apply_transformation(
         for (auto&& input : inputs) {
             if (auto* input_node = input.as(m_value_type)) {
                 input_nodes.push_back(input_node->node());
+            } else if (m_window) {
+                input_nodes.push_back(make_window_input(input.dev_tensor()->as_nd()));
             } else {
                 // ImmutableTensor has empty shape issues
                 auto dev_val = input.dev_tensor()->as_nd();
@@ -48,6 +74,21 @@ ValueRefList LazyEvalTransformation::apply_transformation(
                 input_nodes.push_back(node);
             }
         }
+        if (m_window) {
+            auto&& opdef = op_val->op();
+            m_window_ops.push_back(const_cast<OpDef&>(opdef).shared_from_this());
+            if (opdef.dyn_typeinfo() == Elemwise::typeinfo()) {
+                ++m_nr_window_elemwise_ops;
+            }
+            m_window_key.push_back(WINDOW_OP);
+            m_window_key.push_back(opdef.hash());
+            m_window_key.push_back(input_nodes.size());
+            for (auto* node : input_nodes) {
+                auto iter = m_window_node_ids.find(node);
+                mgb_assert(iter != m_window_node_ids.end());
+                m_window_key.push_back(iter->second);
+            }
+        }
         if (require_link && m_io_link.node()) {
             mgb_assert(!input_nodes.empty());
             auto comp_node = m_io_link.node()->comp_node();
@@ -64,6 +105,15 @@ ValueRefList LazyEvalTransformation::apply_transformation(
         for (size_t i = 0; i < output_nodes.size(); ++i) {
             outputs[i] = record_var(output_nodes[i]);
         }
+        if (m_window) {
+            for (auto* node : output_nodes) {
+                record_window_node(node);
+            }
+            if (++m_nr_window_ops >= m_window) {
+                // outputs are replaced by concrete values in place
+                flush();
+            }
+        }
         return outputs;
     } else if (auto* create_tensor = op.as<CreateTensor>()) {
         auto&& args = create_tensor->parse(inputs);
@@ -77,6 +127,27 @@ ValueRefList LazyEvalTransformation::apply_transformation(
             }
             return *args.device;
         };
+        if (m_window) {
+            if (args.kind == CreateTensor::Const && args.host) {
+                // keep constants in graph for value inference and folding
+                auto&& host = *args.host;
+                auto* node = opr::ImmutableTensor::make(*m_graph, host).node();
+                auto value_hash = XXHash{}
+                                          .update(host.raw_ptr(),
+                                                  host.layout().span().dist_byte())
+                                          .digest();
+                m_window_key.push_back(WINDOW_CONST);
+                m_window_key.push_back(value_hash);
+                m_window_key.push_back(mgb::hash(host.comp_node()));
+                m_window_key.push_back(static_cast<size_t>(host.dtype().enumv()));
+                for (size_t i = 0; i < host.layout().ndim; ++i) {
+                    m_window_key.push_back(host.layout()[i]);
+                }
+                record_window_node(node);
+                return {record_var(node)};
+            }
+            return {record_var(make_window_input(get_dev_val()))};
+        }
         if (args.kind == CreateTensor::Const) {
             VarNode* node;
             if (args.host) {
@@ -120,6 +191,10 @@ ValueRefList LazyEvalTransformation::apply_transformation(
                     return {CompNodeValue::make(lazy_val->node()->comp_node())};
                 case GetAttr::Shape: {
                     if (!cg::is_static_var_shape(lazy_val->node())) {
+                        if (m_window) {
+                            flush();
+                            return imperative::apply(op, inputs);
+                        }
                         mgb_log_debug("LazyEval: get_shape_failed");
                         return {ValueRef()};
                     }
@@ -129,6 +204,10 @@ ValueRefList LazyEvalTransformation::apply_transformation(
                 }
                 case GetAttr::Value: {
                     if (!cg::is_static_var_value(lazy_val->node())) {
+                        if (m_window) {
+                            flush();
+                            return imperative::apply(op, inputs);
+                        }
                         mgb_log_debug("LazyEval: get_value failed");
                         return {ValueRef()};
                     }
@@ -143,6 +222,10 @@ ValueRefList LazyEvalTransformation::apply_transformation(
                 }
                 case GetAttr::Data: {
                     if (!cg::is_static_var_value(lazy_val->node())) {
+                        if (m_window) {
+                            flush();
+                            return imperative::apply(op, inputs);
+                        }
                         mgb_log_debug("LazyEval get_data failed");
                         return {ValueRef()};
                     }
@@ -189,7 +272,136 @@ ValueRefList LazyEvalTransformation::apply_transformation(
     }
 }
 
+VarNode* LazyEvalTransformation::make_window_input(const DeviceTensorND& value) {
+    size_t idx = m_window_inputs->size();
+    m_window_inputs->push_back(value);
+    auto provider = [inputs = m_window_inputs, idx]() { return inputs->at(idx); };
+    auto* node = opr::InputCallback::make(
+                         *m_graph, provider, value.comp_node(), value.dtype(),
+                         value.shape(), {}, true)[0]
+                         .node();
+    m_window_key.push_back(WINDOW_INPUT);
+    m_window_key.push_back(mgb::hash(value.comp_node()));
+    m_window_key.push_back(static_cast<size_t>(value.dtype().enumv()));
+    m_window_key.push_back(value.shape().ndim);
+    for (size_t i = 0; i < value.shape().ndim; ++i) {
+        m_window_key.push_back(value.shape()[i]);
+    }
+    record_window_node(node);
+    return node;
+}
+
+void LazyEvalTransformation::record_window_node(VarNode* node) {
+    m_window_node_ids.emplace(node, m_window_node_ids.size());
+}
+
+void LazyEvalTransformation::reset_window() {
+    auto graph = ComputingGraph::make();
+    auto&& options = graph->options();
+    options.graph_opt_level = m_graph->options().graph_opt_level;
+    options.graph_opt = m_graph->options().graph_opt;
+    options.no_force_inplace = m_graph->options().no_force_inplace;
+    m_graph = std::move(graph);
+    m_weak_vars.clear();
+    m_io_link = nullptr;
+    m_nr_window_ops = 0;
+    m_nr_window_elemwise_ops = 0;
+    m_window_key.clear();
+    m_window_ops.clear();
+    m_window_node_ids.clear();
+    m_window_inputs = std::make_shared<SmallVector<DeviceTensorND>>();
+}
+
+void LazyEvalTransformation::flush() {
+    mgb_assert(m_window, "flush is only supported by windowed lazy eval");
+    std::vector<LazyEvalValue::ref_t> lazy_vals;
+    auto key = m_window_key;
+    key.push_back(WINDOW_OUTPUTS);
+    for (size_t i = 0; i < m_weak_vars.size(); ++i) {
+        if (auto lazy_val = m_weak_vars[i].lock()) {
+            lazy_vals.push_back(lazy_val);
+            key.push_back(i);
+        }
+    }
+    // windows compiled with different options must not be mixed up in a shared
+    // cache
+    auto&& options = m_graph->options();
+    key.push_back(static_cast<size_t>(options.graph_opt_level));
+    key.push_back(static_cast<size_t>(options.graph_opt.jit));
+    auto inputs = m_window_inputs;
+    auto ops = std::move(m_window_ops);
+    size_t nr_elemwise_ops = m_nr_window_elemwise_ops;
+    CleanupGuard _{[this] { reset_window(); }};
+    if (lazy_vals.empty()) {
+        return;
+    }
+    auto digest = XXHash{}.update(key.data(), key.size() * sizeof(size_t)).digest();
+    auto window = m_window_cache->take(digest, key, ops);
+    bool compiled = !window;
+    try {
+        if (window) {
+            *window->inputs = std::move(*inputs);
+        } else {
+            window = std::make_unique<WindowCache::Entry>();
+            window->key = std::move(key);
+            window->ops = std::move(ops);
+            window->graph = m_graph;
+            window->inputs = inputs;
+            window->outputs =
+                    std::make_shared<SmallVector<DeviceTensorND>>(lazy_vals.size());
+            ComputingGraph::OutputSpec output_specs;
+            for (size_t i = 0; i < lazy_vals.size(); ++i) {
+                auto callback = [outputs = window->outputs, i](DeviceTensorND data) {
+                    (*outputs)[i] = data;
+                };
+                auto* output =
+                        opr::OutputCallback::make({callback}, lazy_vals[i]->node())
+                                .node();
+                output_specs.push_back({output, {}});
+            }
+            if (m_io_link.node()) {
+                output_specs.push_back({m_io_link, {}});
+            }
+            set_priority_to_id(output_specs);
+            window->executable = m_graph->compile(output_specs);
+        }
+        window->executable->execute();
+        window->executable->wait();
+    } catch (...) {
+        // the window may be left in a bad state, so it is not put back
+        for (auto&& lazy_val : lazy_vals) {
+            lazy_val.reset(ErrorValue::make("lazy eval failed"));
+        }
+        throw;
+    }
+    for (size_t i = 0; i < lazy_vals.size(); ++i) {
+        auto data = std::move((*window->outputs)[i]);
+        lazy_vals[i].reset(imperative::apply(
+                CreateTensor(CreateTensor::Common, data.comp_node(), data.layout()),
+                DeviceStorage::make(data.storage()))[0]);
+    }
+    // release values held by the window
+    window->inputs->clear();
+    for (auto&& output : *window->outputs) {
+        output = {};
+    }
+    if (compiled) {
+        m_window_cache->add(digest, std::move(window), nr_elemwise_ops);
+    } else {
+        m_window_cache->put(digest, std::move(window));
+    }
+}
+
 void LazyEvalTransformation::on_unregister() noexcept {
+    if (m_window) {
+        try {
+            flush();
+        } catch (...) {
+            m_graph_exc = std::current_exception();
+        }
+        m_graph.reset();
+        return;
+    }
     std::vector<LazyEvalValue::ref_t> lazy_vals;
     for (auto&& weak_var : m_weak_vars) {
         if (auto lazy_val = weak_var.lock()) {
@@ -230,18 +442,7 @@ void LazyEvalTransformation::on_unregister() noexcept {
     if (output_specs.empty()) {
         return;
     }
-    {
-        // set_priority_to_id
-        auto on_opr = [](mgb::cg::OperatorNodeBase* opr) {
-            if (opr->node_prop().attribute().priority == 0) {
-                opr->node_prop().attribute().priority = opr->id();
-            }
-        };
-        mgb::cg::DepOprIter dep_iter{on_opr};
-        for (auto&& output_spec : output_specs) {
-            dep_iter.add(output_spec.first);
-        }
-    }
+    set_priority_to_id(output_specs);
     try {
         auto exectuble = m_graph->compile(output_specs);
         exectuble->execute();
@@ -264,6 +465,73 @@ void LazyEvalTransformation::on_unregister() noexcept {
     }
 }
 
+std::unique_ptr<LazyEvalTransformation::WindowCache::Entry> LazyEvalTransformation::
+        WindowCache::take(
+                size_t digest, const std::vector<size_t>& key,
+                const std::vector<std::shared_ptr<OpDef>>& ops) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto range = m_entries.equal_range(digest);
+    for (auto it = range.first; it != range.second; ++it) {
+        auto&& entry = *it->second;
+        if (entry.key != key || entry.ops.size() != ops.size()) {
+            continue;
+        }
+        bool same = true;
+        for (size_t i = 0; i < ops.size() && same; ++i) {
+            same = entry.ops[i]->is_same(*ops[i]);
+        }
+        if (same) {
+            auto ret = std::move(it->second);
+            m_entries.erase(it);
+            ++m_stats.nr_hits;
+            return ret;
+        }
+    }
+    return nullptr;
+}
+
+void LazyEvalTransformation::WindowCache::put(
+        size_t digest, std::unique_ptr<Entry> entry) {
+    MGB_LOCK_GUARD(m_mtx);
+    if (m_entries.size() >= MAX_ENTRIES) {
+        m_entries.clear();
+    }
+    m_entries.emplace(digest, std::move(entry));
+}
+
+void LazyEvalTransformation::WindowCache::add(
+        size_t digest, std::unique_ptr<Entry> entry, size_t nr_elemwise_ops) {
+    size_t nr_elemwise_oprs = 0;
+    entry->executable->iter_opr_seq([&](cg::OperatorNodeBase* opr) {
+        if (opr->same_type<opr::Elemwise>()) {
+            ++nr_elemwise_oprs;
+        }
+        return true;
+    });
+    {
+        MGB_LOCK_GUARD(m_mtx);
+        ++m_stats.nr_compiles;
+        m_stats.last_nr_elemwise_ops = nr_elemwise_ops;
+        m_stats.last_nr_elemwise_oprs = nr_elemwise_oprs;
+    }
+    put(digest, std::move(entry));
+}
+
+LazyEvalTransformation::WindowCache::Stats LazyEvalTransformation::WindowCache::
+        stats() {
+    MGB_LOCK_GUARD(m_mtx);
+    return m_stats;
+}
+
+void LazyEvalTransformation::WindowCache::clear() {
+    decltype(m_entries) entries;
+    {
+        MGB_LOCK_GUARD(m_mtx);
+        entries.swap(m_entries);
+        m_stats = {};
+    }
+}
+
 void LazyEvalTransformation::check_exception() {
     if (m_graph_exc) {
         std::rethrow_exception(m_graph_exc);
@@ -287,10 +287,65 @@ void TracingTransformation::on_unregister() noexcept {
 }
 
 void CompiledTransformation::compile() {
+    mgb_assert(!m_dynamic_graph.executable, "already compiled");
+    m_const_values.resize(m_vars.size());
+    for (size_t id = 0; id < m_vars.size(); ++id) {
+        if (m_vars[id].kind == VarKind::Constant) {
+            m_const_values[id] = m_vars[id].bound_data.numpy()->as_nd();
+        }
+    }
+    compile_graph(m_dynamic_graph, {});
+    m_nr_external = 0;
+    for (auto&& item : m_seq) {
+        for (auto&& input : item.inputs) {
+            m_nr_external += m_vars[input].kind == VarKind::External;
+        }
+    }
+    // accessors of traced values, which forward to the graph selected at launch
+    m_var_accessors.resize(m_vars.size());
+    for (size_t id = 0; id < m_vars.size(); ++id) {
+        auto& src = m_dynamic_graph.var_accessors[id];
+        auto& dst = m_var_accessors[id];
+        if (m_vars[id].kind != VarKind::External && m_vars[id].bound_data) {
+            // bound data is readable without executing graph
+            dst = src;
+            continue;
+        }
+        dst.node = src.node;
+        dst.exc_setter = src.exc_setter;
+        if (src.shape_getter) {
+            dst.shape_getter = [this, id] {
+                return current_graph().var_accessors[id].shape_getter();
+            };
+        }
+        if (src.data_getter) {
+            dst.data_getter = [this, id] {
+                return current_graph().var_accessors[id].data_getter();
+            };
+        }
+        if (src.value_getter) {
+            dst.value_getter = [this, id] {
+                return current_graph().var_accessors[id].value_getter();
+            };
+        }
+        if (src.data_setter) {
+            dst.data_setter = [this, id](DeviceTensorND data) {
+                if (m_launched) {
+                    m_current_graph->var_accessors[id].data_setter(data);
+                } else {
+                    m_pending_inputs.push_back({id, data});
+                }
+            };
+        }
+    }
+}
+
+void CompiledTransformation::compile_graph(
+        CompiledGraph& dest, const std::vector<TensorShape>& input_shapes) {
     // these ops require seq order, so we link them to an mm_io_link to ensure order
     static std::unordered_set<Typeinfo*> mm_io_ops = {
             CollectiveComm::typeinfo(), RemoteSend::typeinfo(), RemoteRecv::typeinfo()};
-    mgb_assert(!m_executable, "already compiled");
+    auto& graph = *dest.graph;
     // FIXME: mm_io_link and io_links should be merged
     SymbolVarArray io_links;
     SymbolVar mm_io_link;
@@ -298,11 +353,17 @@ void CompiledTransformation::compile() {
         mgb_assert(
                 var_info->kind == VarKind::External, "input node should be external");
         VarAccessor accessor;
-        auto box = make_box<DeviceTensorND>();
+        auto box = make_box<DeviceTensorND>(dest);
+        auto shape = var_info->shape;
+        bool use_static_shape = m_input_shape_static;
+        if (!input_shapes.empty()) {
+            shape = input_shapes[var_info - m_vars.data()];
+            use_static_shape = true;
+        }
         // TODO: attach ref count, release early
         auto outputs = opr::InputCallback::make(
-                *m_graph, [box] { return box->take_value(); }, *var_info->device,
-                *var_info->dtype, var_info->shape, io_links, m_input_shape_static);
+                graph, [box] { return box->take_value(); }, *var_info->device,
+                *var_info->dtype, shape, io_links, use_static_shape);
         // attach input_callback to io_links
         accessor.node = outputs[0].node();
         io_links = {outputs[1]};
@@ -331,7 +392,7 @@ void CompiledTransformation::compile() {
         }
         if (var_info->shape_required) {
             // TODO: use static infer manager for some vars?
-            auto box = make_box<TensorShape>();
+            auto box = make_box<TensorShape>(dest);
             auto callback = [box](DeviceTensorND data) {
                 box->try_set_value(data.shape());
             };
@@ -342,7 +403,7 @@ void CompiledTransformation::compile() {
             accessor.shape_getter = [box]() -> TensorShape { return box->get_value(); };
         }
         if (var_info->data_required) {
-            auto box = make_box<DeviceTensorND>();
+            auto box = make_box<DeviceTensorND>(dest);
             auto callback = [box](DeviceTensorND data) { box->try_set_value(data); };
             SymbolVarArray inputs = io_links;
             inputs.insert(inputs.begin(), node);
@@ -363,7 +424,7 @@ void CompiledTransformation::compile() {
                 HostTensorND value;
                 CompNode::Event* event = nullptr;
             };
-            auto box = make_box<ValueWithEvent>();
+            auto box = make_box<ValueWithEvent>(dest);
             auto event = EventPool::without_timer().alloc_shared(*var_info->device);
             auto callback = [box, event](DeviceTensorND data) {
                 HostTensorND host_val;
@@ -394,8 +455,8 @@ void CompiledTransformation::compile() {
         VarAccessor accessor;
         mgb_assert(
                 var_info->kind == VarKind::Constant, "const node should be constant");
-        HostTensorND host_val = var_info->bound_data.numpy()->as_nd();
-        accessor.node = opr::ImmutableTensor::make(*m_graph, host_val).node();
+        auto&& host_val = m_const_values[var_info - m_vars.data()];
+        accessor.node = opr::ImmutableTensor::make(graph, host_val).node();
         return accessor;
     };
     std::vector<VarAccessor> var_accessors(m_vars.size());
@@ -479,14 +540,111 @@ void CompiledTransformation::compile() {
             dep_iter.add(output_spec.first);
         }
     }
-    m_executable = m_graph->compile(output_specs);
-    m_var_accessors = var_accessors;
-    m_output_spec = output_specs;
+    dest.executable = graph.compile(output_specs);
+    dest.var_accessors = var_accessors;
+    dest.output_spec = output_specs;
+}
+
+auto CompiledTransformation::specialized_graph() -> CompiledGraph* {
+    std::string key;
+    for (auto&& [id, data] : m_pending_inputs) {
+        auto&& shape = data.shape();
+        key.append(reinterpret_cast<const char*>(&id), sizeof(id));
+        key.append(reinterpret_cast<const char*>(&shape.ndim), sizeof(shape.ndim));
+        key.append(
+                reinterpret_cast<const char*>(shape.shape),
+                sizeof(shape.shape[0]) * shape.ndim);
+    }
+    collect_specialized_graph(false);
+    auto iter = m_specialized_index.find(key);
+    if (iter != m_specialized_index.end()) {
+        m_specialized_graphs.splice(
+                m_specialized_graphs.begin(), m_specialized_graphs, iter->second);
+        ++m_nr_specialized_hit;
+        return iter->second->second.get();
+    }
+    // shapes seen only once are served by the dynamic graph to avoid compile stalls,
+    // and only one graph is compiled at a time
+    if (++m_shape_hits[key] < SPECIALIZE_THRESHOLD || m_compiling.valid()) {
+        if (m_shape_hits.size() > m_shape_cache_size * 4) {
+            m_shape_hits.clear();
+        }
+        return &m_dynamic_graph;
+    }
+    m_shape_hits.erase(key);
+    std::vector<TensorShape> input_shapes(m_vars.size());
+    for (auto&& [id, data] : m_pending_inputs) {
+        input_shapes[id] = data.shape();
+    }
+    auto specialized = std::make_unique<CompiledGraph>();
+    // options visitor may call into python, so the graph is made in this thread
+    specialized->graph = make_graph();
+    // graphs of a trace are executed one at a time, so they can share static memory
+    specialized->graph->share_device_memory_with(*m_dynamic_graph.graph);
+    m_compiling_key = std::move(key);
+    m_compiling = std::async(
+            std::launch::async,
+            [this, specialized = std::move(specialized),
+             input_shapes = std::move(input_shapes)]() mutable {
+                compile_graph(*specialized, input_shapes);
+                return std::move(specialized);
+            });
+    return &m_dynamic_graph;
+}
+
+void CompiledTransformation::collect_specialized_graph(bool wait) {
+    if (!m_compiling.valid() ||
+        (!wait && m_compiling.wait_for(std::chrono::seconds(0)) !=
+                          std::future_status::ready)) {
+        return;
+    }
+    std::unique_ptr<CompiledGraph> specialized;
+    try {
+        specialized = m_compiling.get();
+    } catch (std::exception& exc) {
+        mgb_log_warn(
+                "failed to specialize traced graph for input shapes, fallback to "
+                "dynamic shapes: %s",
+                exc.what());
+        return;
+    }
+    ++m_nr_specialized;
+    m_specialized_graphs.emplace_front(
+            std::move(m_compiling_key), std::move(specialized));
+    m_specialized_index[m_specialized_graphs.front().first] =
+            m_specialized_graphs.begin();
+    while (m_specialized_graphs.size() > m_shape_cache_size) {
+        m_specialized_index.erase(m_specialized_graphs.back().first);
+        m_specialized_graphs.pop_back();
+    }
+}
+
+void CompiledTransformation::launch() {
+    if (m_launched) {
+        return;
+    }
+    CompiledGraph* target = &m_dynamic_graph;
+    if (m_shape_cache_size && m_pending_inputs.size() == m_nr_external &&
+        !m_graph_exc) {
+        target = specialized_graph();
+    }
+    {
+        MGB_LOCK_GUARD(m_mutex);
+        m_current_graph = target;
+        m_launched = true;
+        m_graph_status = 1;
+    }
+    m_cv.notify_all();
+    for (auto&& [id, data] : m_pending_inputs) {
+        target->var_accessors[id].data_setter(data);
+    }
+    m_pending_inputs.clear();
 }
 
 void CompiledTransformation::recompile() {
-    mgb_assert(m_executable);
-    m_executable = m_graph->compile(m_output_spec);
+    auto& graph = *m_current_graph;
+    mgb_assert(graph.executable);
+    graph.executable = graph.graph->compile(graph.output_spec);
 }
 
 void CompiledTransformation::assert_tensor_equal(ValueRef lhs, ValueRef rhs) {
@@ -703,12 +861,14 @@ void CompiledTransformation::on_unregister() noexcept {
 }
 
 void CompiledTransformation::execute() {
-    mgb_assert(m_executable != nullptr);
+    mgb_assert(m_dynamic_graph.executable != nullptr);
     {
         MGB_LOCK_GUARD(m_mutex);
-        m_graph_status = 1;
+        m_current_graph = &m_dynamic_graph;
+    }
+    if (!m_shape_cache_size) {
+        launch();
     }
-    m_cv.notify_all();
 }
 
 void CompiledTransformation::wait() {
@@ -716,14 +876,17 @@ void CompiledTransformation::wait() {
         trace_assert(m_pc == m_seq.size(), "mismature end");
     } catch (...) {
     }
-    mgb_assert(m_executable != nullptr);
+    mgb_assert(m_dynamic_graph.executable != nullptr);
+    // launch graph if no traced value has been read
+    launch();
     std::unique_lock lock{m_mutex};
     m_cv.wait(lock, [&] { return m_graph_status == 0; });
     lock.unlock();
-    for (auto&& box : m_boxes) {
+    for (auto&& box : m_current_graph->boxes) {
         box->reset();
     }
     m_pc = 0;
+    m_launched = false;
     std::exception_ptr graph_exc;
     std::swap(m_graph_exc, graph_exc);
     if (graph_exc) {
@@ -739,7 +902,7 @@ std::exception_ptr CompiledTransformation::set_exception(
     if (m_graph_exc) {
         return m_graph_exc;
     }
-    for (auto&& box : m_boxes) {
+    for (auto&& box : m_current_graph->boxes) {
         box->try_set_exception(exc);
     }
     m_graph_exc = exc;
@@ -18,6 +18,14 @@ namespace imperative {
 
 class BlobManager : public NonCopyableObj {
 public:
+    //! statistics of the blob cache on a CPU comp node
+    struct CacheStats {
+        size_t nr_alloc = 0;      //!< number of allocations
+        size_t nr_hit = 0;        //!< allocations served by cached blocks
+        size_t cached_bytes = 0;  //!< bytes held in the free lists
+        size_t limit = 0;         //!< max bytes held in the free lists
+    };
+
     virtual ~BlobManager() = default;
 
     static BlobManager* inst();
@@ -34,6 +42,12 @@ public:
     virtual void unregister_blob(Blob* blob) = 0;
 
     virtual void defrag(const CompNode& cn) = 0;
+
+    virtual CacheStats get_cache_stats(CompNode cn) = 0;
+
+    //! set max bytes of freed storage kept for reuse on each CPU comp node;
+    //! 0 disables the cache
+    virtual void set_cache_limit(size_t limit) = 0;
 };
 
 }  // namespace imperative
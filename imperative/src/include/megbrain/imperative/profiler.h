@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <bitset>
 #include <chrono>
 #include <deque>
@@ -210,6 +212,106 @@ public:
     static void dump_profile(std::string basename, std::string format, bundle_t result);
 };
 
+/**
+ * \brief always-on profiler which only times sampled ops
+ *
+ * Unlike Profiler, which records every event, SamplingProfiler times 1 in N ops or
+ * ops in periodic time windows. Samples are written into per-thread ring buffers
+ * without locking, and are aggregated into per-op latency histograms and high-water
+ * marks of memory allocated on each comp node. Results could be dumped in chrome
+ * timeline format at any time, including on signal.
+ */
+class SamplingProfiler {
+public:
+    struct Config {
+        //! sample 1 in sample_rate ops; 0 means sampling by time window only
+        size_t sample_rate = 0;
+        //! sample all ops in the first window_us of every period_us
+        uint64_t window_us = 0;
+        uint64_t period_us = 0;
+        //! sync device after sampled ops, so that latency includes kernels
+        bool sync_device = false;
+        //! number of samples kept by each thread
+        size_t capacity = 4096;
+    };
+
+    struct Sample {
+        const char* name;
+        profiler::HostTime start;
+        profiler::Duration duration;
+        CompNode device;
+        size_t used_memory;
+    };
+
+    //! number of log2 buckets of latency in microseconds
+    static constexpr size_t NR_BUCKETS = 32;
+
+    struct Histogram {
+        uint64_t count = 0;
+        profiler::Duration total = profiler::Duration::zero();
+        profiler::Duration max = profiler::Duration::zero();
+        std::array<uint64_t, NR_BUCKETS> buckets = {};
+    };
+
+    struct Bundle {
+        profiler::HostTime start_at;
+        Profiler::thread_dict_t thread_dict;
+        std::vector<std::pair<std::thread::id, Sample>> samples;
+        std::map<std::string, Histogram> histograms;
+        std::map<std::string, size_t> memory_high_water;
+    };
+
+private:
+    struct ThreadBuffer;
+
+    static std::atomic_bool sm_enabled;
+    static std::atomic_bool sm_dump_requested;
+    static std::atomic_size_t sm_generation;
+    static std::mutex sm_mutex;
+    static Config sm_config;
+    static profiler::HostTime sm_start_at;
+    static std::string sm_signal_basename;
+    static std::vector<std::unique_ptr<ThreadBuffer>> sm_buffers;
+
+    static ThreadBuffer& get_buffer();
+
+public:
+    static bool is_enabled() { return sm_enabled.load(std::memory_order_acquire); }
+
+    //! whether the op about to execute on current thread should be timed
+    static bool should_sample();
+
+    //! record a sampled op which starts at start and ends now
+    static void record(const char* name, profiler::HostTime start, CompNode device);
+
+    //! start sampling; samples of previous runs are discarded
+    static void start(Config config);
+
+    static void stop();
+
+    static Bundle collect();
+
+    static void dump(std::string filename);
+
+    //! ask the next sampled thread to dump, which is async-signal-safe
+    static void request_dump() { sm_dump_requested.store(true); }
+
+    /**
+     * \brief dump to basename.<pid>.chrome_timeline.json when signum is received
+     *
+     * The dump takes place on the next sampled thread, not in the signal handler.
+     */
+    static void dump_on_signal(int signum, std::string basename);
+
+    /**
+     * \brief start sampling if MEGENGINE_SAMPLING_PROFILE is set to a sample rate
+     *
+     * If MEGENGINE_SAMPLING_PROFILE_DUMP is also set, results are dumped with it as
+     * basename on SIGUSR2.
+     */
+    static void init_from_env();
+};
+
 #define MGB_RECORD_EVENT(type, ...)                                 \
     if (mgb::imperative::Profiler::is_profiling()) {                \
         mgb::imperative::Profiler::record<type>(type{__VA_ARGS__}); \
@@ -12,6 +12,7 @@
 #pragma once
 
 #include <future>
+#include <mutex>
 #include <variant>
 
 #include "megbrain/imperative/dispatch.h"
@@ -54,19 +55,104 @@ public:
  * 3. Try infer value/shape when handling GetAttr;
  * 4. Compile and execute graph, get values and replace LazyEvalValues by concrete
  * values.
+ *
+ * With a positive window, the graph is also flushed (i.e. step 4) every \p window
+ * ops and when a shape or value can not be inferred, so that eager code gets graph
+ * optimizations such as elemwise fusion; compiled windows are kept in a WindowCache,
+ * which may be shared by several transformations.
  */
 class LazyEvalTransformation final : public Transformation {
+public:
+    /*!
+     * \brief compiled windows keyed by their ops, input layouts and live outputs
+     *
+     * An entry is taken out of the cache while it executes, so a cache can be
+     * shared by transformations on different threads.
+     */
+    class WindowCache {
+    public:
+        struct Entry {
+            std::vector<size_t> key;
+            //! ops in the window, compared by is_same since key only has hashes
+            std::vector<std::shared_ptr<OpDef>> ops;
+            std::shared_ptr<ComputingGraph> graph;
+            std::unique_ptr<cg::AsyncExecutable> executable;
+            //! values read by InputCallback and written by OutputCallback
+            std::shared_ptr<SmallVector<DeviceTensorND>> inputs, outputs;
+        };
+
+        struct Stats {
+            size_t nr_hits = 0, nr_compiles = 0;
+            //! elemwise ops recorded in the last compiled window and elemwise
+            //! oprs left in its compiled sequence after fusion
+            size_t last_nr_elemwise_ops = 0, last_nr_elemwise_oprs = 0;
+        };
+
+        static constexpr size_t MAX_ENTRIES = 64;
+
+        //! take out the entry with the same key and ops, or return nullptr
+        std::unique_ptr<Entry> take(
+                size_t digest, const std::vector<size_t>& key,
+                const std::vector<std::shared_ptr<OpDef>>& ops);
+
+        //! put back a taken entry
+        void put(size_t digest, std::unique_ptr<Entry> entry);
+
+        //! add a newly compiled entry
+        void add(size_t digest, std::unique_ptr<Entry> entry, size_t nr_elemwise_ops);
+
+        Stats stats();
+
+        void clear();
+
+    private:
+        std::mutex m_mtx;
+        std::unordered_multimap<size_t, std::unique_ptr<Entry>> m_entries;
+        Stats m_stats;
+    };
+
 private:
     bool m_no_exec;
+    size_t m_window;
     std::shared_ptr<ComputingGraph> m_graph;
     std::vector<LazyEvalValue::weak_ref_t> m_weak_vars;
     SymbolVar m_io_link = nullptr;
     std::exception_ptr m_graph_exc;
     ObjectType<LazyEvalValue> m_value_type{"LazyEvalValue"};
 
+    // states of the current window, only used with a positive window
+    size_t m_nr_window_ops = 0, m_nr_window_elemwise_ops = 0;
+    std::vector<size_t> m_window_key;
+    std::vector<std::shared_ptr<OpDef>> m_window_ops;
+    std::unordered_map<VarNode*, size_t> m_window_node_ids;
+    std::shared_ptr<SmallVector<DeviceTensorND>> m_window_inputs;
+    std::shared_ptr<WindowCache> m_window_cache;
+
+    //! add an external value to the current window
+    VarNode* make_window_input(const DeviceTensorND& value);
+
+    //! record \p node in the key of the current window
+    void record_window_node(VarNode* node);
+
+    //! start a new window on a new graph
+    void reset_window();
+
 public:
-    LazyEvalTransformation(bool no_exec) : m_no_exec(no_exec) {
+    /*!
+     * \param window_cache cache of compiled windows, a private one is created if
+     *      it is not given
+     */
+    LazyEvalTransformation(
+            bool no_exec, size_t window = 0,
+            std::shared_ptr<WindowCache> window_cache = {})
+            : m_no_exec(no_exec),
+              m_window(no_exec ? 0 : window),
+              m_window_cache(std::move(window_cache)) {
         m_graph = ComputingGraph::make();
+        m_window_inputs = std::make_shared<SmallVector<DeviceTensorND>>();
+        if (m_window && !m_window_cache) {
+            m_window_cache = std::make_shared<WindowCache>();
+        }
     }
 
     LazyEvalValue::ref_t record_var(
@@ -76,6 +162,12 @@ public:
         return lazy_eval_val;
     }
 
+    /*!
+     * \brief execute the current window and replace its LazyEvalValues by
+     *      concrete values; only valid with a positive window
+     */
+    void flush();
+
     ComputingGraph::Options& options() { return m_graph->options(); }
 
     ValueRefList apply_transformation(
@@ -13,6 +13,8 @@
 
 #include <chrono>
 #include <future>
+#include <list>
+#include <unordered_map>
 #include <variant>
 
 #include "megbrain/gopt/inference.h"
@@ -215,6 +217,18 @@ public:
  * CompiledTransformation is built with an operation sequence. It compiles a megbrain
  * graph with the sequence and handle operation requests with this graph. Besides that,
  * it also checks that if current operation is same as previous one in seq.
+ *
+ * The graph compiled by compile() allocates shape-dependent vars dynamically, so it
+ * serves any input shapes. When shape cache is enabled, graph execution is deferred
+ * until a traced value is read, and if all inputs have been fed by then, a graph
+ * specialized for their shapes (with static memory allocation) is executed instead.
+ * Deferring the launch means the graph no longer runs while the rest of the traced
+ * function is replayed in python.
+ *
+ * Specialized graphs are compiled in background for input shapes that have been seen
+ * before, and the graph with dynamic shapes is used until the compilation finishes.
+ * They are kept in a LRU cache and share static device memory with the graph with
+ * dynamic shapes.
  */
 class CompiledTransformation final : public Transformation {
 public:
@@ -260,32 +274,94 @@ public:
     };
 
 private:
+    //! a compiled graph with accessors of traced vars in it
+    struct CompiledGraph {
+        std::shared_ptr<ComputingGraph> graph;
+        std::unique_ptr<cg::AsyncExecutable> executable;
+        std::vector<VarAccessor> var_accessors;
+        std::vector<std::shared_ptr<BoxBase>> boxes;
+        ComputingGraph::OutputSpec output_spec;
+    };
+
+    //! number of times input shapes should be seen before specializing for them
+    static constexpr size_t SPECIALIZE_THRESHOLD = 2;
+
     std::vector<TraceResult::SeqItem> m_seq;
     std::vector<TraceResult::VarInfo> m_vars;
+    //! forward to accessors of current graph
     std::vector<VarAccessor> m_var_accessors;
     size_t m_pc = 0;
-    std::shared_ptr<ComputingGraph> m_graph;
-    std::unique_ptr<cg::AsyncExecutable> m_executable;
+    CompiledGraph m_dynamic_graph;
+    //! specialized graphs keyed by input shapes, in LRU order (most recent first)
+    using SpecializedItem = std::pair<std::string, std::unique_ptr<CompiledGraph>>;
+    std::list<SpecializedItem> m_specialized_graphs;
+    std::unordered_map<std::string, std::list<SpecializedItem>::iterator>
+            m_specialized_index;
+    std::unordered_map<std::string, size_t> m_shape_hits;
+    size_t m_shape_cache_size = 0;
+    //! graph being specialized in background, and its key
+    std::future<std::unique_ptr<CompiledGraph>> m_compiling;
+    std::string m_compiling_key;
+    size_t m_nr_specialized = 0, m_nr_specialized_hit = 0;
+    //! values of constant vars indexed by var id, which are read before compiling
+    //! so that graphs can be compiled in background
+    std::vector<HostTensorND> m_const_values;
+    size_t m_nr_external = 0;
+    //! inputs fed before graph launched
+    std::vector<std::pair<size_t, DeviceTensorND>> m_pending_inputs;
+    bool m_launched = false;
+    CompiledGraph* m_current_graph = &m_dynamic_graph;
     std::vector<TracedValue::weak_ref_t> m_weak_values;
     std::thread m_graph_executor;
     std::function<bool(ValueRef, ValueRef)> m_value_comparator;
+    std::function<void(ComputingGraph::Options&)> m_options_visitor;
     bool m_input_shape_static;
     std::mutex m_mutex;
     std::condition_variable m_cv;
     std::exception_ptr m_graph_exc;
     int m_graph_status = 0;  // 0 = stop, 1 = running, 2 = finalizing
-    std::vector<std::shared_ptr<BoxBase>> m_boxes;
-    ComputingGraph::OutputSpec m_output_spec;
     ObjectType<TracedValue> m_value_type{"TracedValue"};
 
+    /**
+     * \brief compile the traced sequence into dest
+     *
+     * \param input_shapes static shapes of external vars indexed by var id; if empty,
+     * use recorded shapes as hint unless input shape is static
+     */
+    void compile_graph(
+            CompiledGraph& dest, const std::vector<TensorShape>& input_shapes);
+
+    //! find a graph specialized for shapes of pending inputs, or start compiling one
+    //! and return the graph with dynamic shapes
+    CompiledGraph* specialized_graph();
+
+    //! add the graph compiled in background to cache if it is ready or \p wait
+    void collect_specialized_graph(bool wait);
+
+    //! select a graph and start executing it, no-op if already launched
+    void launch();
+
+    std::shared_ptr<ComputingGraph> make_graph() {
+        auto graph = ComputingGraph::make();
+        graph->options().no_force_inplace = true;
+        graph->options().async_exec_level = 0b100;
+        if (m_options_visitor) {
+            m_options_visitor(graph->options());
+        }
+        return graph;
+    }
+
+    CompiledGraph& current_graph() {
+        launch();
+        return *m_current_graph;
+    }
+
 public:
     CompiledTransformation(TraceResult result, bool input_shape_static)
             : m_seq(result.seq),
               m_vars(result.vars),
               m_input_shape_static(input_shape_static) {
-        m_graph = ComputingGraph::make();
-        options().no_force_inplace = true;
-        options().async_exec_level = 0b100;
+        m_dynamic_graph.graph = make_graph();
         m_graph_executor = std::thread([&] {
             while (true) {
                 std::unique_lock lock{m_mutex};
@@ -295,8 +371,8 @@ public:
                     break;
                 }
                 try {
-                    m_executable->execute();
-                    m_executable->wait();
+                    m_current_graph->executable->execute();
+                    m_current_graph->executable->wait();
                 } catch (...) {
                     auto exc = std::current_exception();
                     set_exception(exc);
@@ -309,9 +385,31 @@ public:
         });
     }
 
-    ComputingGraph& graph() { return *m_graph; }
+    //! the graph with dynamic shapes
+    ComputingGraph& graph() { return *m_dynamic_graph.graph; }
+
+    ComputingGraph::Options& options() { return m_dynamic_graph.graph->options(); }
 
-    ComputingGraph::Options& options() { return m_graph->options(); }
+    /**
+     * \brief Set the options visitor, which is applied to options of graphs
+     * specialized for input shapes
+     */
+    void set_options_visitor(std::function<void(ComputingGraph::Options&)> visitor) {
+        m_options_visitor = visitor;
+    }
+
+    /**
+     * \brief set max number of graphs specialized for input shapes
+     *
+     * 0 means always executing the graph with dynamic shapes, which is launched as
+     * soon as execute() is called.
+     */
+    void set_shape_cache_size(size_t size) { m_shape_cache_size = size; }
+
+    //! number of specialized graphs compiled, and number of executions on them
+    std::pair<size_t, size_t> shape_cache_stats() const {
+        return {m_nr_specialized, m_nr_specialized_hit};
+    }
 
     /**
      * \brief Set the value comparator object (usually from python)
@@ -378,13 +476,14 @@ public:
     std::exception_ptr set_exception(std::exception_ptr exc) noexcept;
 
     template <typename T>
-    std::shared_ptr<Box<T>> make_box() {
+    static std::shared_ptr<Box<T>> make_box(CompiledGraph& dest) {
         auto box = Box<T>::make();
-        m_boxes.push_back(box);
+        dest.boxes.push_back(box);
         return box;
     }
 
     ~CompiledTransformation() {
+        collect_specialized_graph(true);
         {
             MGB_LOCK_GUARD(m_mutex);
             m_graph_status = 2;
@@ -93,6 +93,33 @@ TEST(TestImperative, Split) {
     OprChecker(op).run({TensorShape{100}, s1, s2});
 }
 
+TEST(TestImperative, ReuseProxyOpr) {
+    OprAttr::Param param;
+    param.write_pod(megdnn::param::Axis(0));
+    auto op = OprAttr::make("Split", param, OperatorNodeConfig{});
+    auto cn = CompNode::load("xpu0");
+    HostTensorGenerator<> gen;
+    auto host_x = gen({100}, cn);
+    auto make_size = [&](int size) {
+        HostTensorND hv{cn, {{1}, dtype::Int32()}};
+        hv.ptr<int>()[0] = size;
+        return Tensor::make(hv);
+    };
+    // same op and input layouts, but output shapes depend on input values
+    for (int size : {20, 30, 20}) {
+        auto x = Tensor::make(*host_x);
+        auto outputs = OpDef::apply_on_physical_tensor(
+                *op, {x, make_size(size), make_size(100 - size)});
+        ASSERT_EQ(2u, outputs.size());
+        ASSERT_EQ(TensorShape{size_t(size)}, outputs[0]->shape());
+        ASSERT_EQ(TensorShape{size_t(100 - size)}, outputs[1]->shape());
+        auto&& hv = outputs[1]->get_value();
+        for (int i = 0; i < 100 - size; ++i) {
+            ASSERT_EQ(host_x->ptr<float>()[size + i], hv.ptr<float>()[i]);
+        }
+    }
+}
+
 #if MGB_CUDA && MGB_ENABLE_EXCEPTION
 void run_graph(size_t mem_reserved) {
     CompNode::try_coalesce_all_free_memory();
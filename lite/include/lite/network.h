@@ -163,6 +163,20 @@ struct LITE_API NetworkIO {
     std::vector<IO> outputs = {};
 };
 
+/*!
+ * \brief fragmentation status of the runtime memory of a network
+ *
+ * free memory is the memory cached by the allocator and not returned to the
+ * device; movable is the live dynamic memory that can be moved together by
+ * Runtime::compact_memory()
+ */
+struct LITE_API MemoryFragmentation {
+    size_t free = 0;
+    size_t largest_free_block = 0;
+    size_t nr_free_block = 0;
+    size_t movable = 0;
+};
+
 /*!
  * \brief A user-implemented allocator interface
  */
@@ -374,6 +388,16 @@ public:
     static void dump_layout_transform_model(
             std::shared_ptr<Network> network, std::string optimized_model_path);
 
+    //! get fragmentation status of the runtime memory of the network, summed
+    //! over all the devices used by the network
+    static MemoryFragmentation get_memory_fragmentation(
+            std::shared_ptr<Network> network);
+
+    //! compact the runtime memory of the network after forwarding is
+    //! finished, so it can be called between requests of a long-running
+    //! network; return total size of the moved memory
+    static size_t compact_memory(std::shared_ptr<Network> network);
+
     //! get the model io information before model loaded by model path.
     static NetworkIO get_model_io_info(
             const std::string& model_path, const Config& config = {});
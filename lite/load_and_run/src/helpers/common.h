@@ -57,6 +57,8 @@ struct RuntimeParam {
     size_t threads = FLAGS_thread;  //! thread number for running model (NOTE:it's
                                     //! different from multithread device )
     size_t testcase_num = 1;        //! testcase number for model with testcase
+    size_t load_bench_iter = 0;     //! iteration number for benchmarking load
+    size_t instance_id = 0;         //! id of the model instance run by --thread
 };
 /*!
  * \brief:layout type  for running model optimization
@@ -19,6 +19,7 @@ ModelLite::ModelLite(const std::string& path) : model_path(path) {
 };
 void ModelLite::load_model() {
     m_network = std::make_shared<lite::Network>(config, IO);
+    m_network->set_stream_id(m_stream_id);
     if (share_model_mem) {
         //! WARNNING:maybe not right to share param memmory for this
         LITE_WARN("enable share model memory");
@@ -41,6 +42,13 @@ void ModelLite::load_model() {
     }
 }
 
+void ModelLite::load_model_with_shared_weight(
+        const std::shared_ptr<lite::Network>& src) {
+    m_network = std::make_shared<lite::Network>(config, IO);
+    m_network->set_stream_id(m_stream_id);
+    lite::Runtime::shared_weight_with_network(m_network, src);
+}
+
 void ModelLite::run_model() {
     m_network->forward();
 }
@@ -33,6 +33,9 @@ public:
     //! load model from dump file
     void load_model() override;
 
+    //! load model by sharing weights with the network of a loaded model
+    void load_model_with_shared_weight(const std::shared_ptr<lite::Network>& src);
+
     //! run model with given runtime parameter
     void run_model() override;
 
@@ -57,6 +60,9 @@ public:
     //! get algo strategy
     Strategy& get_lite_strategy() { return m_strategy; }
 
+    //! set the stream of the network before load model
+    void set_stream_id(int stream_id) { m_stream_id = stream_id; }
+
 private:
     bool share_model_mem;
     std::string model_path;
@@ -68,6 +74,8 @@ private:
     std::shared_ptr<lite::Network> m_network;
 
     Strategy m_strategy;
+
+    int m_stream_id = 0;
 };
 }  // namespace lar
 // vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -37,6 +37,15 @@ void XPUDeviceOption::config_model_internel<ModelLite>(
             model->get_config().device_type = LiteDeviceType::LITE_CUDA;
         }
 #endif
+        //! partition after the device type is final: each instance runs on its
+        //! own cpu comp node, or on its own stream of the same cuda device
+        if (enable_partition_cores) {
+            if (model->get_config().device_type == LiteDeviceType::LITE_CUDA) {
+                model->set_stream_id(runtime_param.instance_id);
+            } else if (model->get_config().device_type == LiteDeviceType::LITE_CPU) {
+                model->get_config().device_id = runtime_param.instance_id;
+            }
+        }
     } else if (runtime_param.stage == RunStage::AFTER_MODEL_LOAD) {
         auto&& network = model->get_lite_network();
         if (enable_cpu_default) {
@@ -52,14 +61,15 @@ void XPUDeviceOption::config_model_internel<ModelLite>(
             lite::Runtime::set_cpu_inplace_mode(network);
             lite::Runtime::set_cpu_threads_number(network, thread_num);
         }
-        if (enable_set_core_ids) {
+        auto ids = get_core_ids(runtime_param.instance_id);
+        if (!ids.empty()) {
             std::string core_str;
-            for (auto id : core_ids) {
+            for (auto id : ids) {
                 core_str += std::to_string(id) + ",";
             }
             LITE_WARN("multi thread core ids: %s\n", core_str.c_str());
-            lite::ThreadAffinityCallback affinity_callback = [&](size_t thread_id) {
-                mgb::sys::set_cpu_affinity({core_ids[thread_id]});
+            lite::ThreadAffinityCallback affinity_callback = [ids](size_t thread_id) {
+                mgb::sys::set_cpu_affinity({ids[thread_id]});
             };
             lite::Runtime::set_runtime_thread_affinity(network, affinity_callback);
         }
@@ -110,14 +120,36 @@ void XPUDeviceOption::config_model_internel<ModelMdl>(
                         loc.stream = thread_num;
                     };
         }
-        if (enable_set_core_ids) {
+        if (enable_partition_cores) {
+            //! each instance runs on its own comp node
+            auto mapper = model->get_mdl_config().comp_node_mapper;
+            if (!mapper) {
+                mgb_log_warn(
+                        "--partition_cores without a device option only applies to "
+                        "comp nodes with explicit device in the model\n");
+            }
+            int instance_id = runtime_param.instance_id;
+            model->get_mdl_config().comp_node_mapper =
+                    [mapper, instance_id](mgb::CompNode::Locator& loc) {
+                        if (mapper) {
+                            mapper(loc);
+                        }
+                        if (loc.type == mgb::CompNode::DeviceType::CUDA) {
+                            loc.stream = instance_id;
+                        } else if (loc.device >= 0) {
+                            loc.device = instance_id;
+                        }
+                    };
+        }
+        auto ids = get_core_ids(runtime_param.instance_id);
+        if (!ids.empty()) {
             std::string core_str;
-            for (auto id : core_ids) {
+            for (auto id : ids) {
                 core_str += std::to_string(id) + ",";
             }
             mgb_log_warn("set multi thread core ids:%s\n", core_str.c_str());
-            auto affinity_callback = [&](size_t thread_id) {
-                mgb::sys::set_cpu_affinity({core_ids[thread_id]});
+            auto affinity_callback = [ids](size_t thread_id) {
+                mgb::sys::set_cpu_affinity({ids[thread_id]});
             };
             mgb::CompNode::Locator loc;
             model->get_mdl_config().comp_node_mapper(loc);
@@ -161,6 +193,32 @@ XPUDeviceOption::XPUDeviceOption() {
                 "core ids number should be same with thread number set before");
         enable_set_core_ids = true;
     }
+
+    enable_partition_cores = FLAGS_partition_cores;
+    mgb_assert(
+            !(enable_partition_cores && enable_set_core_ids),
+            "--partition_cores can not be used with --multi_thread_core_ids");
+}
+
+std::vector<int> XPUDeviceOption::get_core_ids(size_t instance_id) const {
+    if (enable_set_core_ids) {
+        return core_ids;
+    }
+    std::vector<int> ids;
+    if (enable_partition_cores && (enable_multithread || enable_multithread_default)) {
+        //! instances bind to disjoint cores in order of instance id
+        size_t nr_core = mgb::sys::get_cpu_count();
+        mgb_assert(
+                (instance_id + 1) * thread_num <= nr_core,
+                "--partition_cores binds instance %zu to cores [%zu, %zu), but only "
+                "%zu cores are available",
+                instance_id, instance_id * thread_num, (instance_id + 1) * thread_num,
+                nr_core);
+        for (size_t i = 0; i < thread_num; ++i) {
+            ids.push_back(instance_id * thread_num + i);
+        }
+    }
+    return ids;
 }
 
 bool XPUDeviceOption::is_valid() {
@@ -171,6 +229,7 @@ bool XPUDeviceOption::is_valid() {
     ret = ret || FLAGS_multithread >= 0;
     ret = ret || FLAGS_multithread_default >= 0;
     ret = ret || !FLAGS_multi_thread_core_ids.empty();
+    ret = ret || FLAGS_partition_cores;
 
     return ret;
 }
@@ -199,4 +258,10 @@ DEFINE_int32(
         multithread_default, -1,
         "set multithread device as running device with inplace mode");
 DEFINE_string(multi_thread_core_ids, "", "set multithread core id");
+DEFINE_bool(
+        partition_cores, false,
+        "when running multiple instances by --thread, run each instance on its own "
+        "cpu comp node or cuda stream, and bind the worker threads of instance k "
+        "to cores "
+        "[k * n, (k + 1) * n) with --multithread=n");
 REGIST_OPTION_CREATOR(xpu_device, lar::XPUDeviceOption::create_option);
\ No newline at end of file
@@ -19,6 +19,7 @@ DECLARE_bool(cpu_default);
 DECLARE_int32(multithread);
 DECLARE_int32(multithread_default);
 DECLARE_string(multi_thread_core_ids);
+DECLARE_bool(partition_cores);
 namespace lar {
 
 class XPUDeviceOption final : public OptionBase {
@@ -33,6 +34,8 @@ private:
     XPUDeviceOption();
     template <typename ModelImpl>
     void config_model_internel(RuntimeParam&, std::shared_ptr<ModelImpl>){};
+    //! get the core ids which the worker threads of given instance bind to
+    std::vector<int> get_core_ids(size_t instance_id) const;
     bool enable_cpu;
 #if MGB_CUDA || LITE_WITH_CUDA
     bool enable_cuda;
@@ -41,6 +44,7 @@ private:
     bool enable_multithread;
     bool enable_multithread_default;
     bool enable_set_core_ids;
+    bool enable_partition_cores;
     size_t thread_num;
     std::vector<int> core_ids;
     std::string m_option_name;
@@ -19,6 +19,8 @@ StrategyOption::StrategyOption() {
     warmup_iter = FLAGS_warmup_iter;
     run_iter = FLAGS_iter;
     threads = FLAGS_thread;
+    load_threads = FLAGS_load_thread;
+    load_bench_iter = FLAGS_load_bench_iter;
 }
 
 std::shared_ptr<OptionBase> StrategyOption::create_option() {
@@ -34,6 +36,11 @@ void StrategyOption::config_model(
         runtime_param.run_iter = run_iter;
         runtime_param.threads = threads;
         runtime_param.testcase_num = 1;
+        runtime_param.load_bench_iter = load_bench_iter;
+        if (model->type() == ModelType::MEGDL_MODEL) {
+            auto model_ptr = std::static_pointer_cast<ModelMdl>(model);
+            model_ptr->get_mdl_config().nr_load_thread = load_threads;
+        }
     } else if (runtime_param.stage == RunStage::BEFORE_OUTSPEC_SET) {
         if (model->type() == ModelType::MEGDL_MODEL) {
             auto model_ptr = std::static_pointer_cast<ModelMdl>(model);
@@ -91,6 +98,16 @@ DEFINE_int32(
 
 DEFINE_bool(share_param_mem, false, "load model from shared memeory");
 
+DEFINE_int32(
+        load_thread, 0,
+        "thread number for decoding tensor values while loading model, only "
+        "used for mge model");
+
+DEFINE_int32(
+        load_bench_iter, 0,
+        "if positive, load the model for given times before running it and "
+        "report the loading time");
+
 REGIST_OPTION_CREATOR(run_strategy, lar::StrategyOption::create_option);
 
 REGIST_OPTION_CREATOR(run_testcase, lar::TestcaseOption::create_option);
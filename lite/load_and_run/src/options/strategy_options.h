@@ -14,6 +14,8 @@ DECLARE_int32(iter);
 DECLARE_int32(warmup_iter);
 DECLARE_int32(thread);
 DECLARE_bool(share_param_mem);
+DECLARE_int32(load_thread);
+DECLARE_int32(load_bench_iter);
 
 namespace lar {
 /*!
@@ -43,6 +45,8 @@ private:
     size_t run_iter;     //! iteration number for running model
     size_t threads;      //! thread number for running model (NOTE:it's different
                          //! from multithread device )
+    size_t load_threads;     //! thread number for decoding tensor values
+    size_t load_bench_iter;  //! iteration number for benchmarking model loading
 };
 
 class TestcaseOption final : public OptionBase {
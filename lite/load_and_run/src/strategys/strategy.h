@@ -9,9 +9,14 @@
 
 #pragma once
 #include <gflags/gflags.h>
+#include <condition_variable>
+#include <map>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "helpers/common.h"
+#include "megbrain/utils/timer.h"
 #include "models/model.h"
 #include "options/option_base.h"
 
@@ -44,10 +49,44 @@ public:
     void run() override;
 
 private:
-    //! run model subline for multiple thread
-    void run_subline();
+    //! run model subline of one instance for multiple thread
+    void run_subline(size_t instance_id);
+
+    //! print the throughput, latency and memory of all instances
+    void summary_instances();
+
+    //! total iterations of all instances divided by the time they run
+    double aggregate_throughput() const;
+
+    //! dump the latency of all testcases into json file given by --json_dump
+    void dump_json();
 
     std::string m_model_path;
+
+    //! latency(ms) of each iteration and throughput of one testcase, begin
+    //! and end(ms) are measured since all instances start running
+    struct TestcaseResult {
+        size_t instance;
+        size_t testcase;
+        std::vector<double> latency;
+        double throughput;
+        double begin, end;
+    };
+    std::vector<TestcaseResult> m_results;
+    std::mutex m_result_mtx;
+
+    //! instances are loaded one by one in order of instance id, and start
+    //! running together after all of them are loaded
+    std::condition_variable m_instance_cv;
+    size_t m_nr_loaded = 0;
+    //! set if any instance failed to load, so that others stop waiting
+    bool m_load_failed = false;
+    mgb::RealTimer m_run_clock;
+    //! resident memory(bytes) increased by loading each instance and warming
+    //! up its first testcase
+    std::vector<size_t> m_load_memory;
+    //! the first instance whose weights are shared by --share_weight
+    std::shared_ptr<ModelBase> m_weight_model;
 };
 
 /*!
@@ -56,7 +95,28 @@ private:
 class FittingStrategy : public StrategyBase {
 public:
     FittingStrategy(std::string model_path);
+
+    //! search the best option set and dump it as a flag file
     void run() override;
+
+private:
+    //! flags of one candidate option set, indexed by gflags name
+    using FlagSet = std::map<std::string, std::string>;
+
+    //! profile the model with given flags in a child load_and_run process,
+    //! return the average time(ms) of one iteration or a negative value if
+    //! the candidate failed to run
+    double profile(const FlagSet& flags, int iter);
+
+    //! dump the best option set into a file which can be used by --flagfile,
+    //! with the evaluated candidates recorded as comments
+    void dump_flags(
+            const FlagSet& flags, double time, const std::vector<std::string>& history);
+
+    std::string m_model_path;
+
+    //! flags given by user which are shared by all candidates
+    FlagSet m_base_flags;
 };
 }  // namespace lar
 
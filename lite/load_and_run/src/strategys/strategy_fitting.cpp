@@ -7,18 +7,448 @@
  * \copyright Copyright (c) 2020-2021 Megvii Inc. All rights reserved.
  */
 
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <thread>
+#include "helpers/text_table.h"
+#include "megbrain/common.h"
+#include "megbrain/utils/timer.h"
+#include "misc.h"
 #include "strategy.h"
+
+#if defined(_WIN32)
+#define popen _popen
+#define pclose _pclose
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
 using namespace lar;
 
-FittingStrategy::FittingStrategy(std::string) {
-    mgb_assert("this version don't support Fitting Strategy");
-};
+DECLARE_int32(iter);
+DECLARE_double(fitting_time_budget);
+DECLARE_int32(fitting_max_candidates);
+DECLARE_int32(fitting_screen_iter);
+DECLARE_double(fitting_prune_ratio);
+DECLARE_string(fitting_dump);
+
+namespace {
+//! flags which only take effect in the fitting process itself
+bool is_fitting_flag(const std::string& name) {
+    static const std::set<std::string> gflags_builtin{
+            "flagfile", "fromenv", "tryfromenv", "undefok"};
+    return gflags_builtin.count(name) || name.compare(0, 7, "fitting") == 0;
+}
+
+/*!
+ * \brief run a program with given arguments and feed its output to on_line
+ *
+ * stdout and stderr of the child are both captured. The arguments are passed to
+ * the child as is without a shell on posix systems.
+ *
+ * \return whether the child exits normally with status 0
+ */
+bool run_child(
+        const std::vector<std::string>& args,
+        const std::function<void(const char*)>& on_line) {
+    char line[4096];
+#if defined(_WIN32)
+    std::string cmd;
+    for (auto&& arg : args) {
+        //! cmd.exe has no reliable escaping, so quotes are not allowed
+        if (arg.find('"') != std::string::npos) {
+            mgb_log_warn("argument with quotes is not supported: %s", arg.c_str());
+            return false;
+        }
+        cmd += (cmd.empty() ? "\"" : " \"") + arg + "\"";
+    }
+    cmd += " 2>&1";
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (!pipe) {
+        return false;
+    }
+    while (fgets(line, sizeof(line), pipe)) {
+        on_line(line);
+    }
+    return pclose(pipe) == 0;
+#else
+    std::vector<char*> argv;
+    for (auto&& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    int fds[2];
+    if (pipe(fds)) {
+        return false;
+    }
+    //! posix_spawn does not run fork handlers, unlike fork()
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDERR_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+    pid_t pid;
+    int err = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (err) {
+        close(fds[0]);
+        return false;
+    }
+    FILE* pipe = fdopen(fds[0], "r");
+    if (pipe) {
+        while (fgets(line, sizeof(line), pipe)) {
+            on_line(line);
+        }
+        fclose(pipe);
+    } else {
+        close(fds[0]);
+    }
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return pipe && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+}
+
+std::string format_ms(double time) {
+    if (time < 0) {
+        return "-";
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.3f", time);
+    return buf;
+}
+}  // namespace
+
+FittingStrategy::FittingStrategy(std::string model_path) {
+    mgb::set_log_level(mgb::LogLevel::WARN);
+    lite::set_log_level(LiteLogLevel::WARN);
+    m_model_path = model_path;
+
+    //! options given by user are kept in all candidates, and the options
+    //! set explicitly are not searched by fitting
+    std::vector<gflags::CommandLineFlagInfo> all_flags;
+    gflags::GetAllFlags(&all_flags);
+    for (auto&& info : all_flags) {
+        if (!info.is_default && !is_fitting_flag(info.name)) {
+            m_base_flags[info.name] = info.current_value;
+        }
+    }
+}
+
+double FittingStrategy::profile(const FlagSet& flags, int iter) {
+    FlagSet all_flags = m_base_flags;
+    for (auto&& i : flags) {
+        all_flags[i.first] = i.second;
+    }
+    all_flags["iter"] = std::to_string(iter);
+
+    std::vector<std::string> args{gflags::ProgramInvocationName(), m_model_path};
+    for (auto&& i : all_flags) {
+        args.push_back("--" + i.first + "=" + i.second);
+    }
+    std::string cmd;
+    for (auto&& arg : args) {
+        cmd += (cmd.empty() ? "" : " ") + arg;
+    }
+    mgb_log_debug("fitting run: %s", cmd.c_str());
+
+    //! parse the summary printed by NormalStrategy for each testcase
+    double time_sum = 0;
+    size_t nr_testcase = 0;
+    bool succeeded = run_child(args, [&](const char* line) {
+        double time, avg_time;
+        if (sscanf(line, "=== finished test #%*u: time=%lfms avg_time=%lfms", &time,
+                   &avg_time) == 2) {
+            time_sum += avg_time;
+            ++nr_testcase;
+        }
+    });
+    if (!succeeded || !nr_testcase) {
+        return -1;
+    }
+    return time_sum / nr_testcase;
+}
+
+void FittingStrategy::dump_flags(
+        const FlagSet& flags, double time, const std::vector<std::string>& history) {
+    FlagSet all_flags = m_base_flags;
+    for (auto&& i : flags) {
+        all_flags[i.first] = i.second;
+    }
+    std::ofstream out(FLAGS_fitting_dump);
+    mgb_assert(out.good(), "can not open %s to dump", FLAGS_fitting_dump.c_str());
+    out << "# option set of " << m_model_path << " searched by --fitting\n";
+    out << "# avg_time=" << format_ms(time) << "ms\n";
+    out << "# evaluated candidates (stage, candidate, screen(ms), time(ms), result):\n";
+    for (auto&& i : history) {
+        out << "#   " << i << "\n";
+    }
+    for (auto&& i : all_flags) {
+        out << "--" << i.first << "=" << i.second << "\n";
+    }
+    printf("=== dump best option set to %s, use it by --flagfile=%s\n",
+           FLAGS_fitting_dump.c_str(), FLAGS_fitting_dump.c_str());
+}
 
 void FittingStrategy::run() {
-    mgb_assert("this version don't support Fitting Strategy");
+    auto to_string = [](const FlagSet& flags) {
+        std::string str;
+        for (auto&& i : flags) {
+            //! empty value means the flag is removed, all such flags are bool
+            str += (str.empty() ? "--" : " --") + i.first + "=" +
+                   (i.second.empty() ? std::string("false") : i.second);
+        }
+        return str.empty() ? std::string("<given options>") : str;
+    };
+    auto table = mgb::TextTable("fitting candidates");
+    table.padding(1);
+    table.align(mgb::TextTable::Align::Mid)
+            .add("stage")
+            .add("candidate")
+            .add("screen(ms)")
+            .add("time(ms)")
+            .add("result")
+            .eor();
+    //! evaluated candidates in order, which are also recorded in the dumped file
+    std::vector<std::string> history;
+    auto add_row = [&](const char* stage, const std::string& candidate,
+                       double screen, double time, const char* result) {
+        table.align(mgb::TextTable::Align::Mid)
+                .add(stage)
+                .add(candidate)
+                .add(format_ms(screen))
+                .add(format_ms(time))
+                .add(result)
+                .eor();
+        history.push_back(
+                std::string(stage) + ", " + candidate + ", " + format_ms(screen) +
+                ", " + format_ms(time) + ", " + result);
+    };
+
+    mgb::RealTimer timer;
+    FlagSet best;
+    double best_time = profile(best, FLAGS_iter);
+    mgb_assert(
+            best_time > 0, "failed to run %s with the given options",
+            m_model_path.c_str());
+    double origin_time = best_time;
+    add_row("origin", to_string(best), -1, best_time, "best");
+
+    size_t nr_candidate = 1, nr_pruned = 0;
+    //! which budget stopped the search, nullptr if none
+    const char* out_of_budget = nullptr;
+    //! profile best option set of the stage updated by delta, a candidate is
+    //! screened with a few iterations at first and pruned if it is obviously
+    //! slower than the best one; return false if the candidate is pruned
+    auto try_candidate = [&](const char* stage, const FlagSet& stage_base,
+                             const FlagSet& delta) -> bool {
+        //! the candidate budget gives a reproducible search; the time budget
+        //! does not interrupt the running candidate, so the result only depends
+        //! on the number of candidates finished in budget
+        if (!out_of_budget && FLAGS_fitting_max_candidates > 0 &&
+            nr_candidate > static_cast<size_t>(FLAGS_fitting_max_candidates)) {
+            out_of_budget = "candidate budget";
+        }
+        if (!out_of_budget && FLAGS_fitting_time_budget > 0 &&
+            timer.get_secs() > FLAGS_fitting_time_budget) {
+            out_of_budget = "time budget";
+        }
+        if (out_of_budget) {
+            add_row(stage, to_string(delta), -1, -1, "skipped");
+            return false;
+        }
+        FlagSet flags = stage_base;
+        for (auto&& i : delta) {
+            //! empty value means removing the flag from the option set
+            if (i.second.empty()) {
+                flags.erase(i.first);
+            } else {
+                flags[i.first] = i.second;
+            }
+        }
+        ++nr_candidate;
+        double screen = profile(flags, FLAGS_fitting_screen_iter);
+        if (screen < 0) {
+            ++nr_pruned;
+            add_row(stage, to_string(delta), screen, -1, "failed");
+            return false;
+        }
+        if (screen > best_time * FLAGS_fitting_prune_ratio) {
+            ++nr_pruned;
+            add_row(stage, to_string(delta), screen, -1, "pruned");
+            return false;
+        }
+        double time = profile(flags, FLAGS_iter);
+        if (time < 0) {
+            ++nr_pruned;
+            add_row(stage, to_string(delta), screen, time, "failed");
+            return false;
+        }
+        bool is_best = time < best_time;
+        add_row(stage, to_string(delta), screen, time, is_best ? "best" : "slower");
+        if (is_best) {
+            best = flags;
+            best_time = time;
+        }
+        return true;
+    };
+    //! options set explicitly by user are not searched
+    auto searchable = [&](const char* stage, const std::vector<std::string>& names) {
+        if (out_of_budget) {
+            add_row(stage, "-", -1, -1, "skipped");
+            return false;
+        }
+        for (auto&& name : names) {
+            if (m_base_flags.count(name)) {
+                mgb_log_warn(
+                        "skip fitting stage %s since --%s is given", stage,
+                        name.c_str());
+                return false;
+            }
+        }
+        return true;
+    };
+
+    std::string cuda;
+    bool use_cuda = gflags::GetCommandLineOption("cuda", &cuda) && cuda == "true";
+
+    //! the options are searched stage by stage in a fixed order, each stage
+    //! starts from the best option set of previous stages
+    if (!use_cuda && searchable(
+                             "thread", {"cpu", "cpu_default", "multithread",
+                                        "multithread_default",
+                                        "multi_thread_core_ids"})) {
+        size_t nr_core = std::max(std::thread::hardware_concurrency(), 1u);
+        std::vector<size_t> nr_threads;
+        for (size_t n = 2; n < nr_core; n *= 2) {
+            nr_threads.push_back(n);
+        }
+        if (nr_core > 1) {
+            nr_threads.push_back(nr_core);
+        }
+        auto stage_base = best;
+        for (auto n : nr_threads) {
+            //! latency is usually unimodal on thread number
+            if (!try_candidate(
+                        "thread", stage_base, {{"multithread", std::to_string(n)}})) {
+                break;
+            }
+        }
+        auto iter = best.find("multithread");
+        size_t nr_thread = iter == best.end() ? 1 : std::stoul(iter->second);
+        if (nr_thread > 1 && nr_thread < nr_core) {
+            //! big cores usually have larger ids on big.LITTLE platforms
+            std::string big_cores, little_cores;
+            for (size_t i = 0; i < nr_thread; ++i) {
+                big_cores += (i ? "," : "") + std::to_string(nr_core - nr_thread + i);
+                little_cores += (i ? "," : "") + std::to_string(i);
+            }
+            stage_base = best;
+            for (auto&& ids : {big_cores, little_cores}) {
+                try_candidate("core_ids", stage_base, {{"multi_thread_core_ids", ids}});
+            }
+        }
+    }
+
+    std::vector<std::string> layouts;
+    if (use_cuda) {
+        layouts = {"nchw4", "chwn4", "nchw32", "nchw64"};
+    } else {
+        layouts = {"nchw44", "nchw88", "nchw44_dot"};
+    }
+    std::vector<std::string> layout_flags;
+    for (auto&& layout : layouts) {
+        layout_flags.push_back("enable_" + layout);
+    }
+    if (searchable("layout", layout_flags)) {
+        auto stage_base = best;
+        for (auto&& flag : layout_flags) {
+            try_candidate("layout", stage_base, {{flag, "true"}});
+        }
+    }
+
+    if (searchable("fast_run", {"fast_run", "full_run"})) {
+        try_candidate("fast_run", best, {{"fast_run", "true"}});
+    }
+
+    if (searchable("weight_preprocess", {"weight_preprocess"})) {
+        try_candidate("weight_preprocess", best, {{"weight_preprocess", "true"}});
+    }
+
+    if (searchable("record", {"record_comp_seq", "record_comp_seq2"})) {
+        auto stage_base = best;
+        //! level 2 record is only tried when level 1 works
+        if (try_candidate("record", stage_base, {{"record_comp_seq", "true"}})) {
+            try_candidate(
+                    "record", stage_base,
+                    {{"record_comp_seq2", "true"}, {"no_sanity_check", "true"}});
+        }
+    }
+
+    if (searchable("layout_transform", {"layout_transform"})) {
+        //! global layout transform decides the layout itself, so it replaces
+        //! the layout option found before
+        FlagSet delta{{"layout_transform", use_cuda ? "cuda" : "cpu"}};
+        for (auto&& flag : layout_flags) {
+            if (best.count(flag)) {
+                delta[flag] = "";
+            }
+        }
+        try_candidate("layout_transform", best, delta);
+    }
+
+    std::cout << table;
+    printf("\n=== fitting finished: %zu candidates (%zu failed or pruned) in "
+           "%.3fs%s%s\n",
+           nr_candidate, nr_pruned, timer.get_secs(),
+           out_of_budget ? ", stopped by " : "", out_of_budget ? out_of_budget : "");
+    printf("=== best option set: %s\n", to_string(best).c_str());
+    printf("=== avg_time=%.3fms throughput=%.3f/s speedup=%.3f\n", best_time,
+           1000 / best_time, origin_time / best_time);
+    if (!FLAGS_fitting_dump.empty()) {
+        dump_flags(best, best_time, history);
+    }
 };
 
 DEFINE_bool(
         fitting, false,
         "whether to use the fitting model, which will auto profile and get "
-        "the best option set!");
\ No newline at end of file
+        "the best option set!");
+
+DEFINE_double(
+        fitting_time_budget, 0,
+        "time budget(in seconds) for fitting, no more candidates are profiled "
+        "after the budget is exhausted, 0 means no limit");
+
+DEFINE_int32(
+        fitting_max_candidates, 0,
+        "max number of candidates profiled by fitting besides the given option "
+        "set, 0 means no limit");
+
+DEFINE_int32(
+        fitting_screen_iter, 3,
+        "iteration number for screening a fitting candidate before it is "
+        "fully profiled");
+
+DEFINE_double(
+        fitting_prune_ratio, 1.1,
+        "fitting candidates whose screening time is slower than the best one "
+        "by this ratio are pruned");
+
+DEFINE_string(
+        fitting_dump, "",
+        "dump the best option set found by fitting into the given file, which "
+        "can be used by --flagfile");
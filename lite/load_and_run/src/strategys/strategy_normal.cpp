@@ -6,18 +6,88 @@
  *
  * \copyright Copyright (c) 2020-2021 Megvii Inc. All rights reserved.
  */
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <iostream>
+#include <random>
 #include <thread>
+#include "helpers/text_table.h"
 #include "megbrain/common.h"
+#include "megbrain/utils/json.h"
 #include "megbrain/utils/timer.h"
 #include "megbrain/version.h"
 #include "megdnn/version.h"
 #include "misc.h"
+#include "models/model_lite.h"
 #include "strategy.h"
 
+#if defined(__linux__) || defined(ANDROID)
+#include <unistd.h>
+#endif
+
 using namespace lar;
 
+DECLARE_double(qps);
+DECLARE_string(arrival);
+DECLARE_int32(arrival_seed);
+DECLARE_string(json_dump);
+DECLARE_bool(share_weight);
+
+namespace {
+//! statistics of the latency of all iterations in a testcase
+struct LatencyStat {
+    double p50, p90, p99, p999;
+    //! mean difference of latency between adjacent iterations
+    double jitter;
+};
+
+LatencyStat get_latency_stat(const std::vector<double>& latency) {
+    //! no iteration is run with --iter=0
+    if (latency.empty()) {
+        return {0, 0, 0, 0, 0};
+    }
+    auto sorted = latency;
+    std::sort(sorted.begin(), sorted.end());
+    //! nearest-rank percentile
+    auto percentile = [&](double p) {
+        size_t rank = std::ceil(p / 100 * sorted.size());
+        return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+    };
+    double jitter = 0;
+    for (size_t i = 1; i < latency.size(); ++i) {
+        jitter += std::abs(latency[i] - latency[i - 1]);
+    }
+    if (latency.size() > 1) {
+        jitter /= latency.size() - 1;
+    }
+    return {percentile(50), percentile(90), percentile(99), percentile(99.9), jitter};
+}
+
+//! resident memory(bytes) of the process, 0 if it is not supported
+size_t get_resident_memory() {
+#if defined(__linux__) || defined(ANDROID)
+    FILE* fin = fopen("/proc/self/statm", "r");
+    if (!fin) {
+        return 0;
+    }
+    size_t size, resident;
+    if (fscanf(fin, "%zu %zu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(fin);
+    return resident * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+}  // namespace
+
 NormalStrategy::NormalStrategy(std::string model_path) {
+    mgb_assert(
+            FLAGS_arrival == "fixed" || FLAGS_arrival == "poisson",
+            "unsupported arrival pattern: %s", FLAGS_arrival.c_str());
+    mgb_assert(FLAGS_qps >= 0, "--qps should not be negative");
     mgb::set_log_level(mgb::LogLevel::WARN);
     lite::set_log_level(LiteLogLevel::WARN);
     m_model_path = model_path;
@@ -39,45 +109,53 @@ NormalStrategy::NormalStrategy(std::string model_path) {
     }
 }
 
-void NormalStrategy::run_subline() {
+void NormalStrategy::run_subline(size_t instance_id) {
+    //! each instance has its own runtime param as they run concurrently
+    RuntimeParam runtime_param = m_runtime_param;
+    runtime_param.instance_id = instance_id;
     auto model = ModelBase::create_model(m_model_path);
     mgb_assert(model != nullptr, "create model failed!!");
 
     auto stage_config_model = [&]() {
         for (auto& option : m_options) {
-            option.second->config_model(m_runtime_param, model);
+            option.second->config_model(runtime_param, model);
         }
     };
     //! execute before load config
-    m_runtime_param.stage = RunStage::BEFORE_MODEL_LOAD;
+    runtime_param.stage = RunStage::BEFORE_MODEL_LOAD;
     stage_config_model();
 
     mgb::RealTimer timer;
-    model->load_model();
-    printf("load model: %.3fms\n", timer.get_msecs_reset());
-
-    //! after load configure
-    m_runtime_param.stage = RunStage::AFTER_MODEL_LOAD;
-    stage_config_model();
-
-    m_runtime_param.stage = RunStage::GLOBAL_OPTIMIZATION;
-    stage_config_model();
-
-    m_runtime_param.stage = RunStage::BEFORE_OUTSPEC_SET;
-    stage_config_model();
-
-    // for get static memmory information options
-    m_runtime_param.stage = RunStage::AFTER_OUTSPEC_SET;
-    stage_config_model();
-
+    if (runtime_param.load_bench_iter) {
+        //! load fresh models so that nothing is cached by the previous load
+        auto load_num = runtime_param.load_bench_iter;
+        double time_sum = 0, min_time = std::numeric_limits<double>::max(),
+               max_time = 0;
+        for (size_t i = 0; i < load_num; i++) {
+            auto bench_model = ModelBase::create_model(m_model_path);
+            for (auto& option : m_options) {
+                option.second->config_model(runtime_param, bench_model);
+            }
+            timer.reset();
+            bench_model->load_model();
+            auto cur = timer.get_msecs();
+            printf("load iter %zu/%zu: %.3fms\n", i, load_num, cur);
+            time_sum += cur;
+            min_time = std::min(min_time, cur);
+            max_time = std::max(max_time, cur);
+        }
+        printf("=== load model: avg_time=%.3fms min=%.3fms max=%.3fms\n\n",
+               time_sum / load_num, min_time, max_time);
+        timer.reset();
+    }
     auto warm_up = [&]() {
-        auto warmup_num = m_runtime_param.warmup_iter;
+        auto warmup_num = runtime_param.warmup_iter;
         for (size_t i = 0; i < warmup_num; i++) {
             printf("=== prepare: %.3fms; going to warmup\n\n", timer.get_msecs_reset());
             model->run_model();
             model->wait();
             printf("warm up %lu  %.3fms\n", i, timer.get_msecs_reset());
-            m_runtime_param.stage = RunStage::AFTER_RUNNING_WAIT;
+            runtime_param.stage = RunStage::AFTER_RUNNING_WAIT;
             stage_config_model();
         }
     };
@@ -85,57 +163,273 @@ void NormalStrategy::run_subline() {
     auto run_iter = [&](int idx) {
         double time_sqrsum = 0, time_sum = 0,
                min_time = std::numeric_limits<double>::max(), max_time = 0;
-        auto run_num = m_runtime_param.run_iter;
+        auto run_num = runtime_param.run_iter;
+        //! with positive qps requests arrive at a given rate regardless of the
+        //! previous one finished or not, and the latency of a request
+        //! includes the time waiting for previous requests
+        bool open_loop = FLAGS_qps > 0;
+        //! interval(ms) between adjacent requests in open loop
+        std::function<double()> next_interval;
+        if (open_loop && FLAGS_arrival == "poisson") {
+            next_interval = [rng = std::mt19937(FLAGS_arrival_seed + idx),
+                             dist = std::exponential_distribution<double>(
+                                     FLAGS_qps / 1e3)]() mutable { return dist(rng); };
+        } else if (open_loop) {
+            next_interval = [] { return 1e3 / FLAGS_qps; };
+        }
+        double arrival = 0, next_arrival = 0;
+        std::vector<double> latency;
+        mgb::RealTimer clock;
+        double begin = m_run_clock.get_msecs();
         for (size_t i = 0; i < run_num; i++) {
+            if (open_loop) {
+                arrival = next_arrival;
+                next_arrival += next_interval();
+                auto now = clock.get_msecs();
+                if (now < arrival) {
+                    std::this_thread::sleep_for(
+                            std::chrono::duration<double, std::milli>(arrival - now));
+                }
+            }
             timer.reset();
             model->run_model();
             auto exec_time = timer.get_msecs();
             model->wait();
-            m_runtime_param.stage = RunStage::AFTER_RUNNING_WAIT;
+            runtime_param.stage = RunStage::AFTER_RUNNING_WAIT;
             stage_config_model();
             auto cur = timer.get_msecs();
-            printf("iter %lu/%lu: %.3fms (exec=%.3fms)\n", i, run_num, cur, exec_time);
+            if (open_loop) {
+                latency.push_back(clock.get_msecs() - arrival);
+                printf("iter %lu/%lu: %.3fms (exec=%.3fms latency=%.3fms)\n", i,
+                       run_num, cur, exec_time, latency.back());
+            } else {
+                latency.push_back(cur);
+                printf("iter %lu/%lu: %.3fms (exec=%.3fms)\n", i, run_num, cur,
+                       exec_time);
+            }
             time_sum += cur;
             time_sqrsum += cur * cur;
             fflush(stdout);
             min_time = std::min(min_time, cur);
             max_time = std::max(max_time, cur);
         }
+        double throughput = run_num * 1e3 / clock.get_msecs();
+        double end = m_run_clock.get_msecs();
         printf("\n=== finished test #%u: time=%.3fms avg_time=%.3fms "
-               "sexec=%.3fms min=%.3fms max=%.3fms\n\n",
+               "sexec=%.3fms min=%.3fms max=%.3fms\n",
                idx, time_sum, time_sum / run_num,
                std::sqrt(
                        (time_sqrsum * run_num - time_sum * time_sum) /
                        (run_num * (run_num - 1))),
                min_time, max_time);
+        auto stat = get_latency_stat(latency);
+        printf("=== latency of test #%u: p50=%.3fms p90=%.3fms p99=%.3fms "
+               "p99.9=%.3fms jitter=%.3fms throughput=%.3f/s\n\n",
+               idx, stat.p50, stat.p90, stat.p99, stat.p999, stat.jitter, throughput);
+        {
+            MGB_LOCK_GUARD(m_result_mtx);
+            m_results.push_back(
+                    {instance_id, static_cast<size_t>(idx), latency, throughput, begin,
+                     end});
+        }
         return time_sum;
     };
 
-    //! model with testcase
-    size_t iter_num = m_runtime_param.testcase_num;
+#if MGB_HAVE_THREAD
+    //! instances are loaded one by one, so that the memory of each instance
+    //! can be measured and the weights of the first one can be shared
+    std::unique_lock<std::mutex> lock(m_result_mtx);
+    m_instance_cv.wait(
+            lock, [&]() { return m_nr_loaded == instance_id || m_load_failed; });
+#endif
+    //! the error is thrown by the failed instance
+    if (m_load_failed) {
+        return;
+    }
+    auto nr_instance = m_load_memory.size();
+    try {
+        auto memory = get_resident_memory();
+        timer.reset();
+        if (FLAGS_share_weight && instance_id &&
+            model->type() == ModelType::LITE_MODEL) {
+            auto&& network = std::static_pointer_cast<ModelLite>(m_weight_model)
+                                     ->get_lite_network();
+            std::static_pointer_cast<ModelLite>(model)->load_model_with_shared_weight(
+                    network);
+        } else {
+            if (FLAGS_share_weight && instance_id) {
+                mgb_log_warn(
+                        "--share_weight only supports lite model, load weights again");
+            }
+            model->load_model();
+        }
+        printf("load model: %.3fms\n", timer.get_msecs_reset());
 
-    double tot_time = 0;
-    for (size_t idx = 0; idx < iter_num; idx++) {
-        //! config when running model
-        mgb_log_warn("run testcase: %zu ", idx);
-        m_runtime_param.stage = RunStage::MODEL_RUNNING;
+        //! after load configure
+        runtime_param.stage = RunStage::AFTER_MODEL_LOAD;
+        stage_config_model();
+
+        runtime_param.stage = RunStage::GLOBAL_OPTIMIZATION;
         stage_config_model();
 
-        if (!idx) {
+        runtime_param.stage = RunStage::BEFORE_OUTSPEC_SET;
+        stage_config_model();
+
+        // for get static memmory information options
+        runtime_param.stage = RunStage::AFTER_OUTSPEC_SET;
+        stage_config_model();
+
+        //! the first testcase is warmed up before the next instance is loaded, so
+        //! that the static and workspace memory allocated by the first run is
+        //! counted in the load memory
+        if (runtime_param.testcase_num) {
+            mgb_log_warn("run testcase: 0 ");
+            runtime_param.stage = RunStage::MODEL_RUNNING;
+            stage_config_model();
             warm_up();
         }
+        m_load_memory[instance_id] = std::max(get_resident_memory(), memory) - memory;
+    } catch (...) {
+        m_load_failed = true;
+#if MGB_HAVE_THREAD
+        m_instance_cv.notify_all();
+#endif
+        throw;
+    }
+    if (!instance_id) {
+        m_weight_model = model;
+    }
+    if (++m_nr_loaded == nr_instance) {
+        m_run_clock.reset();
+    }
+#if MGB_HAVE_THREAD
+    m_instance_cv.notify_all();
+    m_instance_cv.wait(
+            lock, [&]() { return m_nr_loaded == nr_instance || m_load_failed; });
+    if (m_load_failed) {
+        return;
+    }
+    lock.unlock();
+#endif
+
+    //! model with testcase
+    size_t iter_num = runtime_param.testcase_num;
+
+    double tot_time = 0;
+    for (size_t idx = 0; idx < iter_num; idx++) {
+        //! config when running model, the first testcase is configured when loading
+        if (idx) {
+            mgb_log_warn("run testcase: %zu ", idx);
+            runtime_param.stage = RunStage::MODEL_RUNNING;
+            stage_config_model();
+        }
         tot_time += run_iter(idx);
 
-        m_runtime_param.stage = RunStage::AFTER_RUNNING_ITER;
+        runtime_param.stage = RunStage::AFTER_RUNNING_ITER;
         stage_config_model();
     }
 
     printf("=== total time: %.3fms\n", tot_time);
     //! execute after run
-    m_runtime_param.stage = RunStage::AFTER_MODEL_RUNNING;
+    runtime_param.stage = RunStage::AFTER_MODEL_RUNNING;
     stage_config_model();
 };
 
+double NormalStrategy::aggregate_throughput() const {
+    size_t nr_iter = 0;
+    double begin = std::numeric_limits<double>::max(), end = 0;
+    for (auto&& result : m_results) {
+        nr_iter += result.latency.size();
+        begin = std::min(begin, result.begin);
+        end = std::max(end, result.end);
+    }
+    return end > begin ? nr_iter * 1e3 / (end - begin) : 0;
+}
+
+void NormalStrategy::summary_instances() {
+    auto table = mgb::TextTable("instances");
+    table.padding(1);
+    table.align(mgb::TextTable::Align::Mid)
+            .add("instance")
+            .add("p50(ms)")
+            .add("p99(ms)")
+            .add("throughput(/s)")
+            .add("load memory(MB)")
+            .eor();
+    auto format = [](double value) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.3f", value);
+        return std::string(buf);
+    };
+    for (size_t i = 0; i < m_load_memory.size(); ++i) {
+        std::vector<double> latency;
+        double time = 0;
+        for (auto&& result : m_results) {
+            if (result.instance == i) {
+                latency.insert(
+                        latency.end(), result.latency.begin(), result.latency.end());
+                time += result.latency.size() / result.throughput;
+            }
+        }
+        if (latency.empty()) {
+            continue;
+        }
+        auto stat = get_latency_stat(latency);
+        table.align(mgb::TextTable::Align::Mid)
+                .add(std::to_string(i))
+                .add(format(stat.p50))
+                .add(format(stat.p99))
+                .add(format(latency.size() / time))
+                .add(format(m_load_memory[i] / 1024.0 / 1024.0))
+                .eor();
+    }
+    std::cout << table;
+    printf("=== %zu instances: aggregate throughput=%.3f/s resident memory=%.3fMB\n\n",
+           m_load_memory.size(), aggregate_throughput(),
+           get_resident_memory() / 1024.0 / 1024.0);
+}
+
+void NormalStrategy::dump_json() {
+#if MGB_ENABLE_JSON
+    using namespace mgb::json;
+    auto testcases = Array::make();
+    for (auto&& result : m_results) {
+        auto stat = get_latency_stat(result.latency);
+        auto latency = Array::make();
+        for (auto i : result.latency) {
+            latency->add(Number::make(i));
+        }
+        testcases->add(Object::make(
+                {{"instance", NumberInt::make(result.instance)},
+                 {"testcase", NumberInt::make(result.testcase)},
+                 {"iter", NumberInt::make(result.latency.size())},
+                 {"p50", Number::make(stat.p50)},
+                 {"p90", Number::make(stat.p90)},
+                 {"p99", Number::make(stat.p99)},
+                 {"p99.9", Number::make(stat.p999)},
+                 {"jitter", Number::make(stat.jitter)},
+                 {"throughput", Number::make(result.throughput)},
+                 {"latency", latency}}));
+    }
+    auto load_memory = Array::make();
+    for (auto i : m_load_memory) {
+        load_memory->add(NumberInt::make(i));
+    }
+    auto root = Object::make(
+            {{"model", String::make(m_model_path)},
+             {"arrival", String::make(FLAGS_qps > 0 ? FLAGS_arrival : "closed")},
+             {"qps", Number::make(FLAGS_qps)},
+             {"threads", NumberInt::make(m_runtime_param.threads)},
+             {"aggregate_throughput", Number::make(aggregate_throughput())},
+             {"load_memory", load_memory},
+             {"testcases", testcases}});
+    root->writeto_fpath(FLAGS_json_dump);
+    printf("=== dump latency to %s\n", FLAGS_json_dump.c_str());
+#else
+    mgb_log_warn("json is disabled, --json_dump is ignored");
+#endif
+}
+
 void NormalStrategy::run() {
     auto v0 = mgb::get_version();
     auto v1 = megdnn::get_version();
@@ -144,19 +438,31 @@ void NormalStrategy::run() {
            v0.major, v0.minor, v0.patch, v0.is_dev, v1.major, v1.minor, v1.patch);
 
     size_t thread_num = m_runtime_param.threads;
-    auto run_sub = [&]() { run_subline(); };
+    m_load_memory.resize(thread_num);
     if (thread_num == 1) {
-        run_sub();
+        run_subline(0);
     } else if (thread_num > 1) {
 #if MGB_HAVE_THREAD
         std::vector<std::thread> threads;
-
+        std::vector<std::exception_ptr> errors(thread_num);
         for (size_t i = 0; i < thread_num; ++i) {
-            threads.emplace_back(run_sub);
+            threads.emplace_back([this, i, &errors]() {
+                try {
+                    run_subline(i);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
         }
         for (auto&& i : threads) {
             i.join();
         }
+        for (auto&& i : errors) {
+            if (i) {
+                std::rethrow_exception(i);
+            }
+        }
+        summary_instances();
 #else
         mgb_log_error(
                 "%d threads requested, but load_and_run was compiled "
@@ -166,5 +472,30 @@ void NormalStrategy::run() {
     } else {
         mgb_assert(false, "--thread must input a positive number!!");
     }
+    if (!FLAGS_json_dump.empty()) {
+        dump_json();
+    }
     //! execute before run
 }
+
+DEFINE_double(
+        qps, 0,
+        "if positive, requests arrive at the given rate instead of running back "
+        "to back, and the latency includes the time waiting for previous requests");
+
+DEFINE_string(
+        arrival, "fixed",
+        "arrival pattern of requests when --qps is given, fixed: requests arrive "
+        "at fixed interval; poisson: requests arrive as a poisson process");
+
+DEFINE_int32(arrival_seed, 0, "random seed of the poisson arrival pattern");
+
+DEFINE_string(
+        json_dump, "",
+        "dump the latency of each iteration and its percentiles, jitter and "
+        "throughput into the given json file");
+
+DEFINE_bool(
+        share_weight, false,
+        "when running multiple instances by --thread, the instances share weights "
+        "with the first one, only lite model is supported");
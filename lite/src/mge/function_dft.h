@@ -133,6 +133,17 @@ inline size_t call_func<NetworkImplDft, size_t>(
         std::string func_name, Network::NetworkImplBase* network_impl) {
     if (func_name == "get_cpu_threads_number") {
         return CALL_FUNC(get_cpu_threads_number);
+    } else if (func_name == "compact_memory") {
+        return CALL_FUNC(compact_memory);
+    }
+    THROW_FUNC_ERROR(func_name);
+}
+
+template <>
+inline MemoryFragmentation call_func<NetworkImplDft, MemoryFragmentation>(
+        std::string func_name, Network::NetworkImplBase* network_impl) {
+    if (func_name == "get_memory_fragmentation") {
+        return CALL_FUNC(get_memory_fragmentation);
     }
     THROW_FUNC_ERROR(func_name);
 }
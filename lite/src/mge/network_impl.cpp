@@ -894,6 +894,27 @@ void NetworkImplDft::get_static_memory_alloc_info(const std::string& log_dir) co
     LITE_MARK_USED_VAR(log_dir);
 }
 
+MemoryFragmentation NetworkImplDft::get_memory_fragmentation() const {
+    MemoryFragmentation ret;
+    mgb::CompNode::UnorderedSet comp_nodes;
+    for (auto&& var : m_load_result.output_var_list) {
+        comp_nodes.insert(var.node()->comp_node());
+    }
+    for (auto cn : comp_nodes) {
+        auto frag = m_load_config.comp_graph->get_mem_fragmentation(cn);
+        ret.free += frag.free;
+        ret.largest_free_block =
+                std::max(ret.largest_free_block, frag.largest_free_block);
+        ret.nr_free_block += frag.nr_free_block;
+        ret.movable += frag.movable_dynamic;
+    }
+    return ret;
+}
+
+size_t NetworkImplDft::compact_memory() {
+    return m_load_config.comp_graph->compact_dynamic_memory();
+}
+
 void NetworkImplDft::enable_global_layout_transform() {
     m_layout_transform_target = mgb::gopt::GraphTuningOptions::Target::UNSPEC;
 
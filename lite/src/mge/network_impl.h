@@ -170,6 +170,12 @@ public:
     void get_static_memory_alloc_info(
             const std::string& log_dir = "logs/test") const override;
 
+    //! get fragmentation status of the runtime memory
+    MemoryFragmentation get_memory_fragmentation() const;
+
+    //! compact the runtime memory, return total size of moved memory
+    size_t compact_memory();
+
     //! set global layout transform optimization for network
     void enable_global_layout_transform();
 
@@ -535,6 +535,34 @@ void Runtime::dump_layout_transform_model(
     LITE_ERROR_HANDLER_END
 }
 
+MemoryFragmentation Runtime::get_memory_fragmentation(
+        std::shared_ptr<Network> network) {
+    LITE_ERROR_HANDLER_BEGIN
+    auto network_impl = NetworkHelper::implement(network);
+    if (network_impl->get_backend_type() == LiteBackend::LITE_DEFAULT) {
+        LITE_ASSERT(
+                NetworkHelper::loaded(network),
+                "get_memory_fragmentation should be used after model loaded.");
+        return call_func<NetworkImplDft, MemoryFragmentation>(
+                "get_memory_fragmentation", network_impl);
+    }
+    LITE_THROW("get_memory_fragmentation is not aviliable in the backend.");
+    LITE_ERROR_HANDLER_END
+}
+
+size_t Runtime::compact_memory(std::shared_ptr<Network> network) {
+    LITE_ERROR_HANDLER_BEGIN
+    auto network_impl = NetworkHelper::implement(network);
+    if (network_impl->get_backend_type() == LiteBackend::LITE_DEFAULT) {
+        LITE_ASSERT(
+                NetworkHelper::loaded(network),
+                "compact_memory should be used after model loaded.");
+        return call_func<NetworkImplDft, size_t>("compact_memory", network_impl);
+    }
+    LITE_THROW("compact_memory is not aviliable in the backend.");
+    LITE_ERROR_HANDLER_END
+}
+
 NetworkIO Runtime::get_model_io_info(
         const std::string& model_path, const Config& config) {
     LITE_ERROR_HANDLER_BEGIN
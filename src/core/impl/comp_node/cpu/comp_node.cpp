@@ -13,6 +13,7 @@
 
 #include "megbrain/common.h"
 #include "megbrain/comp_node_env.h"
+#include "megbrain/graph/cg.h"
 #include "megbrain/system.h"
 #include "megbrain/utils/arith_helper.h"
 #include "megbrain/utils/thread.h"
@@ -23,6 +24,7 @@
 #include <condition_variable>
 #include <cstdint>
 #include <cstring>
+#include <unordered_map>
 
 #include <stdlib.h>
 #ifndef __APPLE__
@@ -42,6 +44,60 @@ struct TaskElem {
     //! number of the parallelism
     size_t nr_parallelism;
 };
+
+//! header put before each memory block allocated by CPU comp nodes
+struct BlockHeader {
+    void* base;
+    uint64_t stamp;
+};
+
+/*!
+ * \brief track release of memory blocks allocated by CPU comp nodes
+ *
+ * Each block is stamped by a global clock when allocated. A stopped
+ * SeqRecorderImpl registers a flag with current clock value, which would be
+ * set once a block allocated before that is freed, since the recorded kernels
+ * may access the block.
+ */
+class MemReleaseTracker {
+    std::atomic<uint64_t> m_clock{0};
+    std::atomic_size_t m_nr_watcher{0};
+    MGB_MUTEX m_mtx;
+    std::unordered_map<std::atomic_bool*, uint64_t> m_watcher;
+
+public:
+    static MemReleaseTracker& inst() {
+        // never destructed because blocks may be freed after global finalize
+        static auto ptr = new MemReleaseTracker;
+        return *ptr;
+    }
+
+    uint64_t next_stamp() { return m_clock.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+    void add_watcher(std::atomic_bool* released) {
+        MGB_LOCK_GUARD(m_mtx);
+        m_watcher[released] = next_stamp();
+        m_nr_watcher.store(m_watcher.size());
+    }
+
+    void remove_watcher(std::atomic_bool* released) {
+        MGB_LOCK_GUARD(m_mtx);
+        m_watcher.erase(released);
+        m_nr_watcher.store(m_watcher.size());
+    }
+
+    void on_free(uint64_t stamp) {
+        if (!m_nr_watcher.load(std::memory_order_relaxed)) {
+            return;
+        }
+        MGB_LOCK_GUARD(m_mtx);
+        for (auto&& i : m_watcher) {
+            if (stamp < i.second) {
+                i.first->store(true);
+            }
+        }
+    }
+};
 }  // anonymous namespace
 
 void CpuCompNode::CpuDispatchableBase::add_callback(Task&& task) {
@@ -99,9 +155,16 @@ public:
 class CpuCompNode::SeqRecorderImpl final : public CompNodeSeqRecorder {
     using CpuEnv = CompNodeEnv::CpuEnv;
     bool m_fake_exec = false, m_synchronized = false, m_stopped = false,
-         m_first_replay = true;
+         m_first_replay = true, m_watch_release = false;
+    //! whether the sequence may be kept for reuse after other sequences run,
+    //! in which case releasing of recorded memory needs to be tracked
+    const bool m_keep_for_reuse;
     SeqRecorderImpl** const m_self_pointer;
 
+    //! set by MemReleaseTracker if memory allocated before recording stops
+    //! has been released
+    std::atomic_bool m_mem_released{false};
+
     std::vector<TaskElem> m_tasks;
     std::shared_ptr<ThreadPool> m_thread_pool = nullptr;
     const CompNode m_record_compnode;
@@ -122,8 +185,9 @@ class CpuCompNode::SeqRecorderImpl final : public CompNodeSeqRecorder {
 public:
     SeqRecorderImpl(
             SeqRecorderImpl** self_pointer, std::shared_ptr<ThreadPool> thread_pool,
-            const CompNode& comp_node)
-            : m_self_pointer{self_pointer},
+            const CompNode& comp_node, bool keep_for_reuse)
+            : m_keep_for_reuse{keep_for_reuse},
+              m_self_pointer{self_pointer},
               m_thread_pool{thread_pool},
               m_record_compnode{comp_node} {
         mgb_assert(!*m_self_pointer);
@@ -131,9 +195,12 @@ public:
     }
 
     ~SeqRecorderImpl() {
-        if (*m_self_pointer) {
+        if (*m_self_pointer == this) {
             stop();
         }
+        if (m_watch_release) {
+            MemReleaseTracker::inst().remove_watcher(&m_mem_released);
+        }
     }
 
     void enter_fake_exec(const CompNode& comp_node) override {
@@ -156,6 +223,19 @@ public:
         mgb_assert(!m_fake_exec);
         *m_self_pointer = nullptr;
         m_stopped = true;
+        if (m_keep_for_reuse && !m_watch_release) {
+            MemReleaseTracker::inst().add_watcher(&m_mem_released);
+            m_watch_release = true;
+        }
+    }
+
+    bool reusable() const override {
+        return m_keep_for_reuse && m_stopped && !m_first_replay &&
+               !m_mem_released.load();
+    }
+
+    size_t recorded_bytes() const override {
+        return sizeof(*this) + m_tasks.capacity() * sizeof(TaskElem);
     }
 
     void replay() override {
@@ -266,19 +346,36 @@ public:
 
     void* mgb_aligned_alloc(size_t size) {
         auto alignment = get_mem_addr_alignment();
+        // a BlockHeader is put before the returned pointer for
+        // MemReleaseTracker
+        auto header_size = std::max(alignment, sizeof(BlockHeader));
+        size += header_size;
 #ifdef WIN32
-        return _aligned_malloc(size, alignment);
+        void* base = _aligned_malloc(size, alignment);
 #elif defined(__ANDROID__) || defined(ANDROID)
-        return memalign(alignment, size);
+        void* base = memalign(alignment, size);
 #else
-        void* ptr = nullptr;
-        auto err = posix_memalign(&ptr, alignment, size);
+        void* base = nullptr;
+        auto err = posix_memalign(&base, alignment, size);
         mgb_assert(!err, "failed to malloc %zubytes with align %zu", size, alignment);
-        return ptr;
 #endif
+        if (!base) {
+            return nullptr;
+        }
+        auto ptr = static_cast<uint8_t*>(base) + header_size;
+        auto header = reinterpret_cast<BlockHeader*>(ptr) - 1;
+        header->base = base;
+        header->stamp = MemReleaseTracker::inst().next_stamp();
+        return ptr;
     }
 
     static void mgb_aligned_free(void* ptr) {
+        if (!ptr) {
+            return;
+        }
+        auto header = static_cast<BlockHeader*>(ptr) - 1;
+        MemReleaseTracker::inst().on_free(header->stamp);
+        ptr = header->base;
 #ifdef WIN32
         _aligned_free(ptr);
 #else
@@ -883,8 +980,13 @@ public:
     }
 
     std::unique_ptr<CompNodeSeqRecorder> create_seq_recorder(
-            cg::ComputingGraph*) override {
-        return std::make_unique<SeqRecorderImpl>(&sm_cur_recorder, m_thread_pool, this);
+            cg::ComputingGraph* cg) override {
+        // only sequences cached by the graph are replayed after others, see
+        // ComputingGraph::Options::comp_node_seq_record_cache_bytes
+        bool keep_for_reuse = cg && cg->options().comp_node_seq_record_level == 1 &&
+                              cg->options().comp_node_seq_record_cache_bytes;
+        return std::make_unique<SeqRecorderImpl>(
+                &sm_cur_recorder, m_thread_pool, this, keep_for_reuse);
     }
 
     SeqRecorderImpl* cur_recorder() const override { return sm_cur_recorder; }
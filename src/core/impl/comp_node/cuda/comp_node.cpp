@@ -261,6 +261,12 @@ public:
         return m_mem_alloc->get_max_block_size_available();
     }
 
+    CachedFreeMem get_cached_free_mem() override {
+        activate();
+        auto stat = m_mem_alloc->get_free_memory_dev();
+        return {stat.tot, stat.max, stat.nr_blk};
+    }
+
     size_t get_free_mem() override {
         m_env.cuda_env().activate();
         size_t tot, free;
@@ -846,6 +846,26 @@ size_t ComputingGraphImpl::clear_device_memory() {
     return var_node_mem_manager().clear_static_device_memory();
 }
 
+ComputingGraph::MemFragmentation ComputingGraphImpl::get_mem_fragmentation(
+        CompNode cn) {
+    MemFragmentation ret;
+#if !MGB_BUILD_SLIM_SERVING
+    auto stat = cn.get_cached_free_mem();
+    ret.free = stat.tot;
+    ret.largest_free_block = stat.largest;
+    ret.nr_free_block = stat.nr_blk;
+#endif
+    ret.movable_dynamic = var_node_mem_manager().dynamic_movable_size(cn);
+    return ret;
+}
+
+size_t ComputingGraphImpl::compact_dynamic_memory() {
+    if (m_current_comp_seq) {
+        static_cast<ComputingSequence*>(m_current_comp_seq)->wait();
+    }
+    return var_node_mem_manager().compact_dynamic_memory();
+}
+
 void ComputingGraphImpl::set_as_subgraph(ComputingGraph& par_graph) {
     m_parent_graph = ComputingGraphImpl::downcast(&par_graph);
     m_parent_graph->m_subgraphs.emplace_back(this);
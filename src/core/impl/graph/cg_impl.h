@@ -233,6 +233,10 @@ public:
 
     size_t clear_device_memory() override;
 
+    MemFragmentation get_mem_fragmentation(CompNode cn) override;
+
+    size_t compact_dynamic_memory() override;
+
     void set_as_subgraph(ComputingGraph& par_graph) override;
 
     void record_async_error(std::unique_ptr<MegBrainError> async_exc) override;
@@ -720,6 +720,7 @@ void ComputingGraphImpl::MultiPartCompiler::assign_graph_opt(
     S(var_sanity_check_first_run);
     S(allocate_static_mem_after_graph_compile);
     S(enable_var_mem_defragment);
+    S(dynamic_mem_compact_threshold);
 #undef S
     mgb_assert(!src.fake_next_exec && !src.comp_node_seq_record_level);
     dst.graph_opt_level = 0;
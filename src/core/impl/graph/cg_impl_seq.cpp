@@ -57,10 +57,22 @@ class ComputingGraphImpl::ComputingSequence::ExecContext {
 #endif
     }
 
+    bool use_recorder_cache() const {
+        auto&& opt = m_owner_graph->options();
+        return opt.comp_node_seq_record_level == 1 &&
+               opt.comp_node_seq_record_cache_bytes;
+    }
+
     void try_reset_recorder() {
         if (m_mem_reallocated) {
-            // clear recorded sequence because memory has been reallocated
-            m_comp_seq->m_comp_node_seq_recorder.reset();
+            if (use_recorder_cache()) {
+                // keep the sequence for previous shapes and try to reuse the
+                // one recorded on current memory layout
+                m_comp_seq->switch_comp_node_seq_recorder();
+            } else {
+                // clear recorded sequence because memory has been reallocated
+                m_comp_seq->m_comp_node_seq_recorder.reset();
+            }
         }
         if (m_comp_seq->m_comp_node_seq_recorder) {
             return;
@@ -102,6 +114,9 @@ class ComputingGraphImpl::ComputingSequence::ExecContext {
         }
         // only move to m_comp_node_seq_recorder after all oprs succeeds
         m_comp_seq->m_comp_node_seq_recorder = std::move(m_recorder);
+        if (use_recorder_cache()) {
+            m_comp_seq->m_comp_node_seq_recorder_key = m_comp_seq->make_recorder_key();
+        }
     }
 
     void after_fake_exec() {
@@ -291,6 +306,68 @@ std::unique_ptr<CompNodeSeqRecorder> ComputingGraphImpl::ComputingSequence::
     return rec;
 }
 
+std::vector<size_t> ComputingGraphImpl::ComputingSequence::make_recorder_key() const {
+    std::vector<size_t> key;
+    for (auto opr : *m_opr_seq) {
+        for (auto var : opr->output()) {
+            if (!is_static_var_storage(var) || !var->dev_tensor_valid()) {
+                continue;
+            }
+            auto&& dv = var->dev_tensor();
+            auto&& layout = dv.layout();
+            auto ptr = dv.storage().has_no_real_storage() ? nullptr : dv.raw_ptr();
+            key.push_back(reinterpret_cast<size_t>(ptr));
+            key.push_back(layout.ndim);
+            for (size_t i = 0; i < layout.ndim; ++i) {
+                key.push_back(layout.shape[i]);
+                key.push_back(layout.stride[i]);
+            }
+        }
+    }
+    return key;
+}
+
+void ComputingGraphImpl::ComputingSequence::switch_comp_node_seq_recorder() {
+    auto&& cache = m_recorder_cache;
+    if (m_comp_node_seq_recorder) {
+        auto bytes = m_comp_node_seq_recorder->recorded_bytes() +
+                     m_comp_node_seq_recorder_key.size() * sizeof(size_t);
+        cache.push_front(
+                {std::move(m_comp_node_seq_recorder_key),
+                 std::move(m_comp_node_seq_recorder), bytes});
+        m_recorder_cache_bytes += bytes;
+        auto budget = m_owner_graph->options().comp_node_seq_record_cache_bytes;
+        while (!cache.empty() && m_recorder_cache_bytes > budget) {
+            m_recorder_cache_bytes -= cache.back().bytes;
+            cache.pop_back();
+        }
+    }
+    m_comp_node_seq_recorder_key.clear();
+
+    auto key = make_recorder_key();
+    for (auto iter = cache.begin(); iter != cache.end(); ++iter) {
+        if (iter->key != key) {
+            continue;
+        }
+        if (iter->recorder->reusable()) {
+            m_comp_node_seq_recorder = std::move(iter->recorder);
+            m_comp_node_seq_recorder_key = std::move(key);
+        }
+        m_recorder_cache_bytes -= iter->bytes;
+        cache.erase(iter);
+        break;
+    }
+    // drop recorders whose memory has been released
+    for (auto iter = cache.begin(); iter != cache.end();) {
+        if (iter->recorder->reusable()) {
+            ++iter;
+        } else {
+            m_recorder_cache_bytes -= iter->bytes;
+            iter = cache.erase(iter);
+        }
+    }
+}
+
 void ComputingGraphImpl::ComputingSequence::do_execute(MegDNNDtorCheck* dtor_check) {
     ExecContext exec_ctx{this};
 
@@ -336,6 +413,8 @@ std::shared_ptr<void> ComputingGraphImpl::ComputingSequence::on_comp_node_finali
     cleanup();
     m_exec_env.clear();
     m_comp_node_seq_recorder.reset();
+    m_recorder_cache.clear();
+    m_recorder_cache_bytes = 0;
     m_opr2stepnum.clear();
     return {};
 }
@@ -421,6 +500,28 @@ void ComputingGraphImpl::ComputingSequence::do_wait(bool explicit_user_wait) {
         auto tmp_async_exc = std::move(m_async_exc);
         mgb_throw_raw(*tmp_async_exc);
     }
+
+    if (explicit_user_wait && sync_device) {
+        try_compact_dynamic_memory();
+    }
+}
+
+void ComputingGraphImpl::ComputingSequence::try_compact_dynamic_memory() {
+    auto thresh = m_owner_graph->options().dynamic_mem_compact_threshold;
+    if (thresh <= 0 || m_have_parent_graph) {
+        return;
+    }
+    for (auto cn : m_used_comp_node) {
+        auto frag = m_owner_graph->get_mem_fragmentation(cn);
+        if (frag.ratio() > thresh) {
+            auto moved = m_owner_graph->var_node_mem_manager().compact_dynamic_memory();
+            mgb_log_debug(
+                    "compact dynamic memory: fragmentation on %s is %.3f; "
+                    "moved=%.3fMiB",
+                    cn.to_string().c_str(), frag.ratio(), moved / 1024.0 / 1024);
+            return;
+        }
+    }
 }
 
 void ComputingGraphImpl::ComputingSequence::cleanup() {
@@ -609,6 +710,32 @@ const CompNode::UnorderedMap<size_t>& ComputingGraphImpl::ComputingSequence::
     return mgr.get_static_alloc_size();
 }
 
+AsyncExecutable::StaticMemPlanCacheStat ComputingGraphImpl::ComputingSequence::
+        get_static_mem_plan_cache_stat() const {
+    if (m_owner_graph->current_comp_seq() != this) {
+        // the cache belongs to the most recently compiled sequence
+        return {};
+    }
+    return m_owner_graph->var_node_mem_manager().static_mem_plan_cache_stat();
+}
+
+std::string ComputingGraphImpl::ComputingSequence::dump_static_mem_plan() const {
+    mgb_throw_if(
+            m_owner_graph->current_comp_seq() != this, GraphError,
+            "static memory plans can only be dumped from the most recently "
+            "compiled function");
+    return m_owner_graph->var_node_mem_manager().dump_static_mem_plan();
+}
+
+void ComputingGraphImpl::ComputingSequence::load_static_mem_plan(
+        const std::string& buf) {
+    mgb_throw_if(
+            m_owner_graph->current_comp_seq() != this, GraphError,
+            "static memory plans can only be loaded into the most recently "
+            "compiled function");
+    m_owner_graph->var_node_mem_manager().load_static_mem_plan(buf);
+}
+
 #if MGB_ENABLE_JSON
 std::shared_ptr<json::Value> ComputingGraphImpl::ComputingSequence::to_json() const {
     ThinHashSet<MemAllocPlan::Chunk*> all_mem_chunk;
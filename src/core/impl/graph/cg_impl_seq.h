@@ -18,6 +18,8 @@
 #include "megbrain/plugin/var_sanity_check.h"
 #include "megbrain/utils/arith_helper.h"
 
+#include <list>
+
 namespace mgb {
 namespace cg {
 
@@ -35,6 +37,20 @@ class ComputingGraphImpl::ComputingSequence final : public AsyncExecutable {
 #endif
     std::unique_ptr<CompNodeSeqRecorder> m_comp_node_seq_recorder;
 
+    //! var memory layout (see make_recorder_key()) on which
+    //! m_comp_node_seq_recorder is recorded
+    std::vector<size_t> m_comp_node_seq_recorder_key;
+
+    struct CachedRecorder {
+        std::vector<size_t> key;
+        std::unique_ptr<CompNodeSeqRecorder> recorder;
+        size_t bytes;
+    };
+    //! recorders for other var memory layouts, most recently used first;
+    //! see Options::comp_node_seq_record_cache_bytes
+    std::list<CachedRecorder> m_recorder_cache;
+    size_t m_recorder_cache_bytes = 0;
+
     NormalExecEnv m_exec_env;
 
     const OprNodeArray* m_opr_seq = nullptr;
@@ -60,6 +76,18 @@ class ComputingGraphImpl::ComputingSequence final : public AsyncExecutable {
      */
     std::unique_ptr<CompNodeSeqRecorder> check_enable_comp_node_seq_recorder();
 
+    //! addresses and layouts of all statically allocated vars
+    std::vector<size_t> make_recorder_key() const;
+
+    /*!
+     * \brief move m_comp_node_seq_recorder into the recorder cache and
+     *      restore the one recorded on current var memory layout if it can
+     *      be reused
+     *
+     * This is called when static memory is reallocated
+     */
+    void switch_comp_node_seq_recorder();
+
     void record_all_event(const EventArray& arr) {
         for (auto&& i : arr) {
             auto runner = [ev = i.second.get()]() { ev->record(); };
@@ -78,6 +106,10 @@ class ComputingGraphImpl::ComputingSequence final : public AsyncExecutable {
      */
     void do_wait(bool explicit_user_wait);
 
+    //! compact dynamic memory if fragmentation on a used comp node exceeds
+    //! Options::dynamic_mem_compact_threshold; called after user wait
+    void try_compact_dynamic_memory();
+
     void cleanup();
 
     /*!
@@ -160,6 +192,12 @@ public:
 
     void clear_device_memory() override;
 
+    StaticMemPlanCacheStat get_static_mem_plan_cache_stat() const override;
+
+    std::string dump_static_mem_plan() const override;
+
+    void load_static_mem_plan(const std::string& buf) override;
+
     void set_async_error(std::unique_ptr<MegBrainError> async_exc) {
         // all computing graphs executed concurrently can call this function
         // to set async error, so this function should be thread safe
@@ -23,6 +23,7 @@ MGB_TYPEINFO_OBJ_IMPL(OprExecFinished);
 MGB_TYPEINFO_OBJ_IMPL(BeforeKernel);
 MGB_TYPEINFO_OBJ_IMPL(AfterKernel);
 MGB_TYPEINFO_OBJ_IMPL(StaticMemAlloc);
+MGB_TYPEINFO_OBJ_IMPL(StaticInferUpdated);
 MGB_TYPEINFO_OBJ_IMPL(CompSeqOrderDetermined);
 MGB_TYPEINFO_OBJ_IMPL(CompSeqExecBeforeStart);
 MGB_TYPEINFO_OBJ_IMPL(CompSeqExecFinished);
@@ -30,7 +30,7 @@ class SeqModifierForDTR::ModifyActionPlanner : public ModifyActionPlannerBase {
 public:
     ModifyActionPlanner(SeqModifierBase* par) : ModifyActionPlannerBase{par} {}
 
-    void prepare(const OprNodeArray& opr_seq);
+    void prepare(const OprNodeArray& opr_seq, Config* config);
 
     SeqModifyAction perform_dtr(
             CompNode comp_node, const OprNodeArray& seq, Config* config);
@@ -77,11 +77,16 @@ void SeqModifierForDTR::modify_endpoint_vars(VarNodeArray& endpoints) {
     }
 }
 
-void SeqModifierForDTR::ModifyActionPlanner::prepare(const OprNodeArray& opr_seq) {
+void SeqModifierForDTR::ModifyActionPlanner::prepare(
+        const OprNodeArray& opr_seq, Config* config) {
     init_seq(opr_seq, false);
 
     for (size_t i = 0; i < seq().size(); ++i) {
         auto opr = seq()[i].get();
+        if (config->opr_cost) {
+            opr->estimate_compute_time = config->opr_cost(opr->orig_opr);
+            continue;
+        }
         size_t est = 0;
         for (auto i : opr->input) {
             est += i->size;
@@ -95,7 +100,7 @@ void SeqModifierForDTR::ModifyActionPlanner::prepare(const OprNodeArray& opr_seq
 
 SeqModifierForDTR::SeqModifyAction SeqModifierForDTR::ModifyActionPlanner::perform_dtr(
         CompNode comp_node, const OprNodeArray& opr_seq, Config* config) {
-    prepare(opr_seq);
+    prepare(opr_seq, config);
     SeqModifyAction action;
 
     if (comp_node.locator().stream < 0) {
@@ -225,10 +230,31 @@ SeqModifierForDTR::SeqModifyAction SeqModifierForDTR::ModifyActionPlanner::perfo
         tim_factor = config->recomp_time_factor;
     }
 
-    static constexpr double MAX_EVAL_VALUE = std::numeric_limits<double>::max();
-    auto find_best = [&]() {
-        Var* best = nullptr;
-        double min_eval_value = MAX_EVAL_VALUE;
+    auto eval = [&](Var* var) {
+        double regen_t = regen_time(var);
+        double regen_m = regen_mem(var);
+        return pow(regen_t, tim_factor) * pow(regen_m, mem_factor) /
+               static_cast<double>(var->size) / next_used(var);
+    };
+
+    /*!
+     * Evicting a var never makes the others cheaper to regenerate, and
+     * nothing else changes during one call of auto_evict(), so scores
+     * computed at its beginning are lower bounds of the later ones. Keep
+     * them in a min-heap and re-evaluate only the top: it is the best var
+     * if its current score is still no larger than the next one.
+     *
+     * The heap is not kept across calls: every var added to alive_vars
+     * between two calls (including outputs of the next opr) stops being
+     * counted in the regen costs of its neighbors, so old scores may be
+     * higher than the current ones. It is built only when an eviction is
+     * actually needed.
+     */
+    using ScoredVar = std::pair<double, Var*>;
+    std::vector<ScoredVar> heap;
+    auto cmp = std::greater<ScoredVar>();
+    auto build_heap = [&]() {
+        heap.clear();
         dfs_back.clear();
         dfs_front.clear();
         dfs_mem.clear();
@@ -237,19 +263,36 @@ SeqModifierForDTR::SeqModifyAction SeqModifierForDTR::ModifyActionPlanner::perfo
                 is_bad_opr(var->owner_opr()->orig_opr)) {
                 continue;
             }
-            double regen_t = regen_time(var);
-            double regen_m = regen_mem(var);
-            double eval_value = pow(regen_t, tim_factor) * pow(regen_m, mem_factor) /
-                                static_cast<double>(var->size) / next_used(var);
-            if (eval_value < min_eval_value) {
-                min_eval_value = eval_value;
-                best = var;
+            heap.emplace_back(eval(var), var);
+        }
+        std::make_heap(heap.begin(), heap.end(), cmp);
+    };
+
+    auto find_best = [&]() -> Var* {
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), cmp);
+            auto var = heap.back().second;
+            heap.pop_back();
+            if (!alive_vars.count(var)) {
+                continue;
+            }
+            double eval_value = eval(var);
+            if (heap.empty() || eval_value <= heap.front().first) {
+                return var;
             }
+            heap.emplace_back(eval_value, var);
+            std::push_heap(heap.begin(), heap.end(), cmp);
         }
-        return best;
+        return nullptr;
     };
 
-    auto do_evict = [&](Var* var) { remove_alive(var); };
+    auto do_evict = [&](Var* var) {
+        remove_alive(var);
+        // regen costs depend on the set of alive vars
+        dfs_back.clear();
+        dfs_front.clear();
+        dfs_mem.clear();
+    };
 
     thin_function<void(Var*)> recursive_free;
     auto auto_evict = [&](size_t needed) {
@@ -263,7 +306,12 @@ SeqModifierForDTR::SeqModifyAction SeqModifierForDTR::ModifyActionPlanner::perfo
         for (auto i : to_free) {
             recursive_free(get_latest(i));
         }
+        bool heap_built = false;
         while (cur_usage + needed >= config->eviction_threshold) {
+            if (!heap_built) {
+                build_heap();
+                heap_built = true;
+            }
             Var* v = find_best();
             if (!v) {
                 break;
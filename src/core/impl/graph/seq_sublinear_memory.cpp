@@ -21,10 +21,13 @@ using namespace cg;
 #include "megbrain/serialization/opr_shallow_copy.h"
 #include "megbrain/system.h"
 #include "megbrain/utils/arith_helper.h"
+#include "megbrain/utils/hash.h"
 #include "megbrain/utils/mempool.h"
+#include "megbrain/utils/persistent_cache.h"
 #include "megbrain/utils/timer.h"
 
 #include <cmath>
+#include <cstring>
 #include <random>
 
 namespace {
@@ -60,6 +63,34 @@ bool is_bad_opr(OperatorNodeBase* opr) {
             F::IMPURE_FUNC | F::NO_AUTOMATIC_DUP | F::FORCE_UPDATE_INPUT_VAR);
 }
 
+//! category in PersistentCache for searched plans
+constexpr const char* PLAN_CACHE_CATEGORY = "sublinear_memory_plan";
+
+//! hash of the opr seq structure that a split point set is searched on
+uint64_t hash_opr_seq(const OprNodeArray& seq) {
+    XXHash hasher;
+    auto update = [&hasher](uint64_t v) { hasher.update(&v, sizeof(v)); };
+    ThinHashMap<OperatorNodeBase*, size_t> opr2idx;
+    for (auto opr : seq) {
+        auto name = opr->dyn_typeinfo()->name;
+        hasher.update(name, strlen(name));
+        update(opr->owner_graph()
+                       ->options()
+                       .opr_attribute.get_sublinear_memory_endpoint(opr));
+        for (auto i : opr->input()) {
+            auto iter = opr2idx.find(i->owner_opr());
+            update(iter == opr2idx.end() ? seq.size() : iter->second);
+            update(i->dtype().size(i->shape().total_nr_elems()));
+        }
+        for (auto i : opr->output()) {
+            update(i->dtype().size(i->shape().total_nr_elems()));
+        }
+        auto idx = opr2idx.size();
+        opr2idx[opr] = idx;
+    }
+    return hasher.digest();
+}
+
 }  // namespace
 /* ======================  ModifyActionPlanner ======================  */
 class SeqModifierForSublinearMemory::ModifyActionPlanner
@@ -94,9 +125,11 @@ class SeqModifierForSublinearMemory::ModifyActionPlanner
 
     size_t calc_bottleneck_from_discard_plan();
 
+    SeqModifierForSublinearMemory* const m_modifier;
+
 public:
     ModifyActionPlanner(SeqModifierForSublinearMemory* par)
-            : ModifyActionPlannerBase{par} {}
+            : ModifyActionPlannerBase{par}, m_modifier{par} {}
 
     //! generate split point set from thresh
     SplitPointSet get_split_point_set(size_t block_size_thresh);
@@ -109,8 +142,22 @@ public:
 
     //! get action for previous get_memory_bottleneck() call
     void get_prev_action(SeqModifyAction& action);
+
+    //! total cost of oprs to be recomputed in previous
+    //! get_memory_bottleneck() call
+    double get_prev_recompute_cost();
 };
 
+double SeqModifierForSublinearMemory::ModifyActionPlanner::get_prev_recompute_cost() {
+    double cost = 0;
+    for (auto&& opr : seq()) {
+        for (auto&& i : opr->oprs_insert_before) {
+            cost += m_modifier->opr_cost(i->orig_opr);
+        }
+    }
+    return cost;
+}
+
 void SeqModifierForSublinearMemory::ModifyActionPlanner::get_prev_action(
         SeqModifyAction& action) {
     action.clear();
@@ -501,6 +548,16 @@ class SeqModifierForSublinearMemory::ActionSearcherSingleCN {
     using Record = std::pair<SplitPointSet, size_t>;
     SplitPointSet m_best_sps;
     std::vector<Record> m_cur_records;
+
+    struct Plan {
+        SplitPointSet sps;
+        PlanCost cost;
+    };
+    //! all plans evaluated in this search
+    std::vector<Plan> m_plans;
+    //! split point set of the plan in m_action
+    SplitPointSet m_selected_sps;
+
     SeqModifyAction m_action;
     std::vector<std::future<void>> m_futures;
     std::mutex m_mtx;
@@ -525,6 +582,21 @@ class SeqModifierForSublinearMemory::ActionSearcherSingleCN {
     void search_genetic();
     void search_refine();
 
+    /*!
+     * \brief compute the Pareto front of searched plans, and select the
+     *      plan within the memory budget if it is set
+     */
+    void search_pareto(CompNode comp_node);
+
+    //! set m_action to the plan of given split point set
+    //! \return memory bottleneck of the plan
+    size_t apply_plan(const SplitPointSet& split_point_set);
+
+    //! key in PersistentCache for plan of current opr seq
+    std::string make_cache_key() const;
+    bool load_cached_plan(CompNode comp_node, const std::string& key);
+    void store_cached_plan(const std::string& key) const;
+
     static inline bool cmp_sps(const SplitPointSet& a, const SplitPointSet& b) {
         if (a->size() != b->size()) {
             return a->size() < b->size();
@@ -558,6 +630,9 @@ public:
         if (auto env = MGB_GETENV("MGB_SUBLINEAR_MEMORY_LOWER_BOUND_MB")) {
             m_config->lb_memory_mb = std::stoi(env);
         }
+        if (auto env = MGB_GETENV("MGB_SUBLINEAR_MEMORY_BUDGET_MB")) {
+            m_config->memory_budget_mb = std::stoi(env);
+        }
     }
 
     const SeqModifyAction& search(CompNode comp_node, const OprNodeArray* seq);
@@ -571,8 +646,10 @@ void SeqModifierForSublinearMemory::ActionSearcherSingleCN::do_search_update_thr
     planner->init_seq(*m_cur_opr_seq);
     SplitPointSet split_point_set = planner->get_split_point_set(thresh);
     auto cur = planner->get_memory_bottleneck(split_point_set);
+    auto cost = planner->get_prev_recompute_cost();
 
     MGB_LOCK_GUARD(m_mtx);
+    m_plans.push_back({split_point_set, {cur, cost}});
     if (cur < m_min_bottleneck || (cur == m_min_bottleneck && m_best_thresh < thresh)) {
         m_best_thresh = thresh;
         m_min_bottleneck = cur;
@@ -590,8 +667,10 @@ void SeqModifierForSublinearMemory::ActionSearcherSingleCN::
 
     planner->init_seq(*m_cur_opr_seq);
     auto cur = planner->get_memory_bottleneck(split_point_set);
+    auto cost = planner->get_prev_recompute_cost();
 
     MGB_LOCK_GUARD(m_mtx);
+    m_plans.push_back({split_point_set, {cur, cost}});
     if (cur < m_min_bottleneck ||
         (cur == m_min_bottleneck && cmp_sps(split_point_set, m_best_sps))) {
         m_min_bottleneck = cur;
@@ -799,10 +878,15 @@ void SeqModifierForSublinearMemory::ActionSearcherSingleCN::search_refine() {
     std::sort(opr_idx.begin(), opr_idx.end(), cmp);
 
     auto split_point_set = make_split_point_set(*m_best_sps);
+    std::sort(split_point_set->begin(), split_point_set->end());
     for (size_t i = 0; i < opr_idx.size(); ++i) {
         bool flag = true;
-        split_point_set->push_back(opr_idx[i]);
-        sort(split_point_set->begin(), split_point_set->end());
+        // keep split points sorted and unique
+        auto pos = std::lower_bound(
+                split_point_set->begin(), split_point_set->end(), opr_idx[i]);
+        if (pos != split_point_set->end() && *pos == opr_idx[i])
+            continue;
+        split_point_set->insert(pos, opr_idx[i]);
         auto f = [&] {
             ModifyActionPlanner* planner =
                     m_par_modifier->m_thread2planner.at(std::this_thread::get_id())
@@ -811,6 +895,7 @@ void SeqModifierForSublinearMemory::ActionSearcherSingleCN::search_refine() {
             auto cur = planner->get_memory_bottleneck(split_point_set);
             if (cur >= lower_bound) {
                 planner->get_prev_action(m_action);
+                m_selected_sps = make_split_point_set(*split_point_set);
                 flag = false;
             }
         };
@@ -833,10 +918,24 @@ const SeqModifierForSublinearMemory::SeqModifyAction& SeqModifierForSublinearMem
     m_futures.clear();
     m_history.clear();
     m_cur_records.clear();
+    m_plans.clear();
+    m_par_modifier->m_prev_pareto_front.at(comp_node).clear();
 
     RealTimer timer;
     m_best_thresh = m_min_bottleneck = std::numeric_limits<size_t>::max();
 
+    std::string cache_key;
+    if (m_par_modifier->m_config->enable_plan_cache) {
+        cache_key = make_cache_key();
+        if (load_cached_plan(comp_node, cache_key)) {
+            mgb_log_debug(
+                    "load sublinear memory plan from cache: comp_node=%s "
+                    "seq_len=%zu time=%.1fms",
+                    comp_node.to_string().c_str(), seq->size(), timer.get_msecs());
+            return m_action;
+        }
+    }
+
     //! init search
     invoke_search(m_best_thresh);
     wait_all();
@@ -845,7 +944,9 @@ const SeqModifierForSublinearMemory::SeqModifyAction& SeqModifierForSublinearMem
     auto t0 = timer.get_msecs_reset();
     search_genetic();
     auto t1 = timer.get_msecs_reset();
+    m_selected_sps = m_best_sps;
     search_refine();
+    search_pareto(comp_node);
     auto t2 = timer.get_msecs_reset();
 
     std::sort(m_history.begin(), m_history.end());
@@ -869,6 +970,11 @@ const SeqModifierForSublinearMemory::SeqModifyAction& SeqModifierForSublinearMem
     }
     msg.push_back('\n');
     msg.append(ssprintf("m_min_bottleneck: %-10.2f\n", m_min_bottleneck * SIZE2MB));
+    msg.append("pareto front (bottleneck recompute_cost):");
+    for (auto&& i : m_par_modifier->m_prev_pareto_front.at(comp_node)) {
+        msg.append(ssprintf(" (%.2f %.4g)", i.bottleneck * SIZE2MB, i.recompute));
+    }
+    msg.push_back('\n');
     if (!m_par_modifier->m_config->genetic_nr_iter) {
         msg.append(
                 ssprintf("\nGenetic algorithm is currently DISABLED, "
@@ -880,9 +986,132 @@ const SeqModifierForSublinearMemory::SeqModifyAction& SeqModifierForSublinearMem
 #else
     MGB_MARK_USED_VAR(t0 + t1 + t2);
 #endif
+    if (m_par_modifier->m_config->enable_plan_cache) {
+        store_cached_plan(cache_key);
+    }
     return m_action;
 }
 
+void SeqModifierForSublinearMemory::ActionSearcherSingleCN::search_pareto(
+        CompNode comp_node) {
+    auto cmp = [](const Plan& a, const Plan& b) {
+        if (a.cost.bottleneck != b.cost.bottleneck)
+            return a.cost.bottleneck < b.cost.bottleneck;
+        return a.cost.recompute < b.cost.recompute;
+    };
+    std::sort(m_plans.begin(), m_plans.end(), cmp);
+
+    // plans on the front have increasing bottleneck and decreasing cost
+    std::vector<const Plan*> front;
+    for (auto&& i : m_plans) {
+        if (front.empty() || i.cost.recompute < front.back()->cost.recompute) {
+            front.push_back(&i);
+        }
+    }
+    auto&& dest = m_par_modifier->m_prev_pareto_front.at(comp_node);
+    for (auto i : front) {
+        dest.push_back(i->cost);
+    }
+
+    auto&& applied = m_par_modifier->m_prev_bottleneck.at(comp_node);
+    applied = m_min_bottleneck;
+    auto budget_mb = m_par_modifier->m_config->memory_budget_mb;
+    if (budget_mb <= 0) {
+        return;
+    }
+    const Plan* best = nullptr;
+    for (auto i : front) {
+        if (i->cost.bottleneck <= static_cast<size_t>(budget_mb) << 20) {
+            best = i;
+        }
+    }
+    if (best) {
+        applied = apply_plan(best->sps);
+    } else {
+        mgb_log_warn(
+                "sublinear memory: no plan on %s fits in the budget of %dMiB; "
+                "use the plan with least memory",
+                comp_node.to_string().c_str(), budget_mb);
+    }
+}
+
+size_t SeqModifierForSublinearMemory::ActionSearcherSingleCN::apply_plan(
+        const SplitPointSet& split_point_set) {
+    size_t bottleneck = 0;
+    auto f = [&]() {
+        ModifyActionPlanner* planner =
+                m_par_modifier->m_thread2planner.at(std::this_thread::get_id()).get();
+        planner->init_seq(*m_cur_opr_seq);
+        bottleneck = planner->get_memory_bottleneck(split_point_set);
+        planner->get_prev_action(m_action);
+    };
+    m_par_modifier->m_planner_thread_pool.launch(f).get();
+    m_selected_sps = split_point_set;
+    return bottleneck;
+}
+
+std::string SeqModifierForSublinearMemory::ActionSearcherSingleCN::make_cache_key()
+        const {
+    auto&& config = *m_par_modifier->m_config;
+    // the plan depends on the recompute cost of each opr rather than on
+    // whether opr_cost is given, so the costs themselves are hashed
+    XXHash cost_hasher;
+    for (auto opr : *m_cur_opr_seq) {
+        double cost = m_par_modifier->opr_cost(opr);
+        cost_hasher.update(&cost, sizeof(cost));
+    }
+    uint64_t fields[] = {
+            hash_opr_seq(*m_cur_opr_seq),
+            cost_hasher.digest(),
+            m_cur_opr_seq->size(),
+            static_cast<uint64_t>(config.thresh_nr_try),
+            static_cast<uint64_t>(config.genetic_nr_iter),
+            static_cast<uint64_t>(config.genetic_pool_size),
+            static_cast<uint64_t>(config.lb_memory_mb),
+            static_cast<uint64_t>(config.memory_budget_mb)};
+    return {reinterpret_cast<const char*>(fields), sizeof(fields)};
+}
+
+bool SeqModifierForSublinearMemory::ActionSearcherSingleCN::load_cached_plan(
+        CompNode comp_node, const std::string& key) {
+    auto buf = PersistentCache::inst().get(
+            PLAN_CACHE_CATEGORY, {key.data(), key.size()});
+    if (!buf.valid()) {
+        return false;
+    }
+    auto split_point_set = make_split_point_set(buf->size / sizeof(uint32_t));
+    for (size_t i = 0; i < split_point_set->size(); ++i) {
+        uint32_t val;
+        memcpy(&val, static_cast<const uint8_t*>(buf->ptr) + i * sizeof(val),
+               sizeof(val));
+        split_point_set->at(i) = val;
+    }
+    auto&& sps = *split_point_set;
+    // split points must be increasing and end at the last opr
+    if (buf->size % sizeof(uint32_t) || sps.empty() ||
+        sps.back() + 1 != m_cur_opr_seq->size() ||
+        std::adjacent_find(sps.begin(), sps.end(), std::greater_equal<size_t>()) !=
+                sps.end()) {
+        mgb_log_warn("ignore corrupted sublinear memory plan in cache");
+        return false;
+    }
+    m_min_bottleneck = apply_plan(split_point_set);
+    m_par_modifier->m_prev_min_bottleneck.at(comp_node) = m_min_bottleneck;
+    m_par_modifier->m_prev_bottleneck.at(comp_node) = m_min_bottleneck;
+    return true;
+}
+
+void SeqModifierForSublinearMemory::ActionSearcherSingleCN::store_cached_plan(
+        const std::string& key) const {
+    // load_cached_plan() only accepts strictly increasing split points
+    std::vector<uint32_t> val(m_selected_sps->begin(), m_selected_sps->end());
+    std::sort(val.begin(), val.end());
+    val.erase(std::unique(val.begin(), val.end()), val.end());
+    PersistentCache::inst().put(
+            PLAN_CACHE_CATEGORY, {key.data(), key.size()},
+            {val.data(), val.size() * sizeof(uint32_t)});
+}
+
 /* ====================  SeqModifierForSublinearMemory ====================  */
 void SeqModifierForSublinearMemory::InternalDeleter::operator()(
         ActionSearcherSingleCN* p) const {
@@ -960,8 +1189,21 @@ SeqModifierForSublinearMemory::SeqModifyAction SeqModifierForSublinearMemory::
     workers.start(cn2oprseq->size());
 
     m_prev_min_bottleneck.clear();
+    m_prev_bottleneck.clear();
+    m_prev_pareto_front.clear();
+    m_opr_cost.clear();
+    OprFootprint footprint;
     for (auto&& i : *cn2oprseq) {
         m_prev_min_bottleneck[i.first] = 0;
+        m_prev_bottleneck[i.first] = 0;
+        m_prev_pareto_front[i.first];
+        for (auto opr : i.second) {
+            if (m_config->opr_cost) {
+                m_opr_cost[opr] = m_config->opr_cost(opr);
+            } else {
+                m_opr_cost[opr] = footprint.get_computation(opr);
+            }
+        }
     }
 
     std::vector<WorkerPool::Future> futures;
@@ -1104,6 +1346,15 @@ const CompNode::UnorderedMap<size_t>& SeqModifierForSublinearMemory::
     return m_prev_min_bottleneck;
 }
 
+const CompNode::UnorderedMap<size_t>& SeqModifierForSublinearMemory::prev_bottleneck() {
+    return m_prev_bottleneck;
+}
+
+const CompNode::UnorderedMap<std::vector<SeqModifierForSublinearMemory::PlanCost>>&
+SeqModifierForSublinearMemory::prev_pareto_front() {
+    return m_prev_pareto_front;
+}
+
 SeqModifierForSublinearMemory::SeqModifierForSublinearMemory(
         ComputingGraphImpl* owner, Config* config_p)
         : SeqModifierBase(owner), m_config(config_p) {}
@@ -40,6 +40,29 @@ public:
 
     const CompNode::UnorderedMap<size_t>& prev_min_bottleneck();
 
+    /*!
+     * \brief memory bottleneck of the plan applied in previous
+     *      modify_endpoint_vars() call
+     *
+     * It differs from prev_min_bottleneck() if a plan with less recompute
+     * cost is picked by SublinearMemConfig::memory_budget_mb.
+     */
+    const CompNode::UnorderedMap<size_t>& prev_bottleneck();
+
+    //! memory bottleneck and recompute cost of a searched plan
+    struct PlanCost {
+        size_t bottleneck;
+        double recompute;
+    };
+
+    /*!
+     * \brief time/memory Pareto front of plans searched in previous
+     *      modify_endpoint_vars() call, ordered by increasing bottleneck
+     *
+     * It is empty for comp nodes whose plan is loaded from the plan cache.
+     */
+    const CompNode::UnorderedMap<std::vector<PlanCost>>& prev_pareto_front();
+
 private:
     using SplitPointSet = std::shared_ptr<std::vector<size_t>>;
 
@@ -70,7 +93,13 @@ private:
     //! thread pool to run ModifyActionPlanner
     FutureThreadPool<void> m_planner_thread_pool;
 
-    CompNode::UnorderedMap<size_t> m_prev_min_bottleneck;
+    CompNode::UnorderedMap<size_t> m_prev_min_bottleneck, m_prev_bottleneck;
+    CompNode::UnorderedMap<std::vector<PlanCost>> m_prev_pareto_front;
+
+    //! recompute cost of each opr; setup by search_action()
+    ThinHashMap<OperatorNodeBase*, double> m_opr_cost;
+
+    double opr_cost(OperatorNodeBase* opr) const { return m_opr_cost.at(opr); }
 
     //! restore computing sequence and modify operator priority
     void reset_opr_seq(const OprNodeArray& oprseq);
@@ -14,11 +14,13 @@
 #include "./static_infer_impl.h"
 #include "./cg_impl.h"
 #include "./impl_common.h"
+#include "megbrain/graph/event.h"
 #include "megbrain/graph/exc_extra_info.h"
 #include "megbrain/graph/helper.h"
 #include "megbrain/graph/operator_node.h"
 #include "megbrain/graph/var_node.h"
 #include "megbrain/utils/shared_set.h"
+#include "megbrain/utils/timer.h"
 
 #if LOG_INFER_RESULT
 #include "megbrain/tensor_iter.h"
@@ -34,7 +36,8 @@ using namespace static_infer;
 namespace {
 
 constexpr size_t INFER_VALUE_SIZE_THRESH_FOR_WARNING = 1024,
-                 INFER_VALUE_CHECK_UNCHANGE_MAX_SIZE = TensorLayout::MAX_NDIM;
+                 INFER_VALUE_CHECK_UNCHANGE_MAX_SIZE = TensorLayout::MAX_NDIM,
+                 INFER_VALUE_CACHE_KEY_MAX_SIZE = 4096;
 
 constexpr bool is_static_infer_type(InferType::Flag t) {
     return t & (InferType::RT_STATIC | InferType::CONST);
@@ -1016,6 +1019,9 @@ public:
      */
     std::pair<bool, bool> update(bool recomp_mutable_srcnode);
 
+    //! force next update() to assign the shape
+    void invalidate() { m_version = 0; }
+
     TagTraitBase* trait() const { return m_trait; }
 };
 
@@ -1112,26 +1118,180 @@ void CompSeqManager::reset_dest(CompSeqExtraInfo& info) {
             info.rt_static_infer_src.push_back({trait->tag(), trait->handler_type()});
         }
     }
+
+    init_receivers();
+    m_shape_cache.clear();
+    m_shape_cache_index.clear();
+}
+
+void CompSeqManager::init_receivers() {
+    ThinHashMap<TagTraitBase*, size_t> trait2id;
+    auto nr_src = m_static_srcnode.size();
+    for (size_t i = 0; i < nr_src; ++i) {
+        trait2id[m_static_srcnode[i].trait()] = i;
+    }
+    for (size_t i = 0; i < m_static_mid.size(); ++i) {
+        trait2id[m_static_mid[i].trait()] = nr_src + i;
+    }
+    m_receivers.clear();
+    m_receivers.resize(nr_src + m_static_mid.size());
+    for (size_t i = 0; i < m_static_mid.size(); ++i) {
+        for (auto dep : m_static_mid[i].trait()->deps()) {
+            auto iter = trait2id.find(dep);
+            if (iter != trait2id.end()) {
+                m_receivers[iter->second].push_back(i);
+            }
+        }
+    }
+    m_visit_stamp.assign(m_static_mid.size(), 0);
+    m_cur_visit_stamp = 0;
+}
+
+bool CompSeqManager::make_shape_cache_key(std::string& key) {
+    auto append = [&key](const void* ptr, size_t size) {
+        key.append(static_cast<const char*>(ptr), size);
+    };
+    auto append_shape = [&append](const TensorShape& shape) {
+        append(&shape.ndim, sizeof(shape.ndim));
+        append(shape.shape, sizeof(shape.shape[0]) * shape.ndim);
+    };
+    key.clear();
+    for (auto&& i : m_static_srcnode) {
+        // sources have just been inferred, so this only fetches the result
+        auto rst = i.trait()->infer(false, true);
+        if (!rst) {
+            return false;
+        }
+        if (i.trait()->handler_type() == TagHandlerType::SHAPE) {
+            append_shape(rst->shape());
+        } else {
+            auto&& val = rst->value();
+            if (!val.layout().is_contiguous() ||
+                val.layout().span().dist_byte() > INFER_VALUE_CACHE_KEY_MAX_SIZE) {
+                return false;
+            }
+            auto dtype = val.dtype().enumv();
+            append(&dtype, sizeof(dtype));
+            append_shape(val.shape());
+            append(val.raw_ptr(), val.layout().span().dist_byte());
+        }
+    }
+    return true;
+}
+
+bool CompSeqManager::update_mid(
+        const std::vector<size_t>& changed_src, size_t& nr_updated) {
+    bool shape_changed = false;
+    if (m_static_first_run) {
+        for (auto&& i : m_static_mid) {
+            shape_changed |= i.update(false).second;
+        }
+        nr_updated = m_static_mid.size();
+        return shape_changed;
+    }
+
+    // only traits in the cone of changed sources could change; others
+    // would be found unchanged by update() anyway
+    auto stamp = ++m_cur_visit_stamp;
+    auto nr_src = m_static_srcnode.size();
+    auto&& queue = m_cone_queue;
+    queue.clear();
+    for (auto i : changed_src) {
+        for (auto j : m_receivers[i]) {
+            if (m_visit_stamp[j] != stamp) {
+                m_visit_stamp[j] = stamp;
+                queue.push_back(j);
+            }
+        }
+    }
+    for (size_t qh = 0; qh < queue.size(); ++qh) {
+        for (auto j : m_receivers[nr_src + queue[qh]]) {
+            if (m_visit_stamp[j] != stamp) {
+                m_visit_stamp[j] = stamp;
+                queue.push_back(j);
+            }
+        }
+    }
+    for (auto i : queue) {
+        shape_changed |= m_static_mid[i].update(false).second;
+    }
+    nr_updated = queue.size();
+    return shape_changed;
 }
 
 bool CompSeqManager::update_static_check_shape_change() {
+    RealTimer timer;
+    size_t nr_updated = 0;
+    bool cache_hit = false;
+    auto signal = [&]() {
+        m_owner_graph->event().signal_inplace<event::StaticInferUpdated>(
+                m_owner_graph, timer.get_secs(), nr_updated, cache_hit);
+    };
+
     if (m_static_first_run) {
         for (auto&& i : m_static_infer_const_needed)
             i.update(false);
     }
-    bool src_changed = false, shape_changed = false;
-    for (auto&& i : m_static_srcnode) {
-        auto cur = i.update(true);
-        src_changed |= cur.first;
+    bool shape_changed = false;
+    auto&& changed_src = m_changed_src;
+    changed_src.clear();
+    for (size_t i = 0; i < m_static_srcnode.size(); ++i) {
+        auto cur = m_static_srcnode[i].update(true);
+        if (cur.first) {
+            changed_src.push_back(i);
+        }
         shape_changed |= cur.second;
     }
-    if (!src_changed && !m_static_first_run)
+    if (changed_src.empty() && !m_static_first_run) {
+        signal();
         return false;
+    }
+
+    auto cache_size = m_owner_graph->options().seq_opt.static_infer_cache_size;
+    std::string key;
+    bool has_key = cache_size && make_shape_cache_key(key);
+    if (has_key) {
+        auto iter = m_shape_cache_index.find(key);
+        if (iter != m_shape_cache_index.end()) {
+            // mid traits are left out of date and would be inferred lazily
+            // if needed; only shapes of vars are assigned
+            m_shape_cache.splice(m_shape_cache.begin(), m_shape_cache, iter->second);
+            auto&& shapes = iter->second->second;
+            for (size_t i = 0; i < m_static_mid.size(); ++i) {
+                auto&& mid = m_static_mid[i];
+                mid.invalidate();
+                if (mid.trait()->handler_type() == TagHandlerType::SHAPE) {
+                    auto var = mid.trait()->tag();
+                    if (!var->shape().eq_shape(shapes[i])) {
+                        var->shape(shapes[i]);
+                        shape_changed = true;
+                    }
+                }
+            }
+            cache_hit = true;
+        }
+    }
 
-    for (auto&& i : m_static_mid) {
-        shape_changed |= i.update(false).second;
+    if (!cache_hit) {
+        shape_changed |= update_mid(changed_src, nr_updated);
+        if (has_key) {
+            std::vector<TensorShape> shapes(m_static_mid.size());
+            for (size_t i = 0; i < m_static_mid.size(); ++i) {
+                auto trait = m_static_mid[i].trait();
+                if (trait->handler_type() == TagHandlerType::SHAPE) {
+                    shapes[i] = trait->tag()->shape();
+                }
+            }
+            m_shape_cache.emplace_front(std::move(key), std::move(shapes));
+            m_shape_cache_index[m_shape_cache.front().first] = m_shape_cache.begin();
+            if (m_shape_cache.size() > cache_size) {
+                m_shape_cache_index.erase(m_shape_cache.back().first);
+                m_shape_cache.pop_back();
+            }
+        }
     }
     m_static_first_run = false;
+    signal();
     return shape_changed;
 }
 
@@ -12,6 +12,8 @@
 #pragma once
 
 #include <deque>
+#include <list>
+#include <unordered_map>
 #include "megbrain/graph/static_infer.h"
 #include "megbrain/utils/mempool.h"
 
@@ -194,8 +196,37 @@ class CompSeqManager {
 
     bool m_static_first_run = false;
 
+    //! indices in m_static_mid of the traits that directly depend on each
+    //! trait; m_static_srcnode are numbered first, followed by m_static_mid
+    std::vector<std::vector<size_t>> m_receivers;
+    std::vector<size_t> m_visit_stamp, m_cone_queue, m_changed_src;
+    size_t m_cur_visit_stamp = 0;
+
+    //! shapes of m_static_mid keyed by values of m_static_srcnode, in LRU
+    //! order (most recent first)
+    using ShapeCacheItem = std::pair<std::string, std::vector<TensorShape>>;
+    std::list<ShapeCacheItem> m_shape_cache;
+    std::unordered_map<std::string, std::list<ShapeCacheItem>::iterator>
+            m_shape_cache_index;
+
     void add_dest(CompSeqExtraInfo& info, TagTraitBase* dest);
 
+    //! build m_receivers after m_static_srcnode and m_static_mid are known
+    void init_receivers();
+
+    /*!
+     * \brief make a key from current values of m_static_srcnode
+     * \return whether the key is made; values too large to be used as keys
+     *      make it fail
+     */
+    bool make_shape_cache_key(std::string& key);
+
+    /*!
+     * \brief update traits in m_static_mid that depend on changed sources
+     * \param changed_src indices of changed m_static_srcnode
+     */
+    bool update_mid(const std::vector<size_t>& changed_src, size_t& nr_updated);
+
 public:
     CompSeqManager(ComputingGraph* graph);
     ~CompSeqManager() noexcept;
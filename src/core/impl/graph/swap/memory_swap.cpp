@@ -19,6 +19,7 @@
 #include "megbrain/serialization/opr_shallow_copy.h"
 #include "megbrain/serialization/serializer.h"
 
+#include <cmath>
 #include <queue>
 
 #if MGB_ENABLE_MEMORY_SWAP
@@ -154,6 +155,11 @@ void MemorySwap::determine_swap_edge(
     auto&& infer_mgr = m_owner_graph->static_infer_manager();
     static_cast<void>(infer_mgr);
 
+    // lossy compression halves the transferred bytes of float32 values
+    bool lossy = m_compression == SwapCompression::FLOAT16 ||
+                 m_compression == SwapCompression::BFLOAT16;
+    double swapped_byte_ratio = lossy ? 0.5 : 1.0;
+
     size_t fin = opr_seq.size() + 10;
     auto segT = new SegmentTree(fin);
 
@@ -393,7 +399,7 @@ void MemorySwap::determine_swap_edge(
                 std::max(m_max_swap_out_var_size, m_segmentToRace[tmp_vec[0]]->m_mem);
         m_swapped_pair.insert(PSS(u, v));
 
-        if (involved / m_cpu_gpu_bandwidth > m_swap_time_limit)
+        if (involved * swapped_byte_ratio / m_cpu_gpu_bandwidth > m_swap_time_limit)
             break;
     }
 
@@ -431,10 +437,19 @@ void MemorySwap::modify_dest_var_inplace(VarNodeArray& vars) {
     tmp->topo_sorter().restore_opr_prop();
 
     auto opr_seq = *opr_seqs;
-    auto nr_gpu = CompNode::get_device_count(CompNode::DeviceType::CUDA);
-    if (!nr_gpu) {
-        mgb_log_debug("No device exists, stop memory swap phase");
-        return;
+    // swapped values are copied on a separate stream of their comp nodes;
+    // on CPU this only saves memory when the values are compressed
+    for (auto opr : opr_seq) {
+        for (auto var : opr->output()) {
+            auto cn = var->comp_node();
+            if (!swap_supported(cn)) {
+                mgb_log_debug(
+                        "memory swap is not supported on %s, stop memory swap "
+                        "phase",
+                        cn.to_string().c_str());
+                return;
+            }
+        }
     }
 
     /*
@@ -461,6 +476,16 @@ void MemorySwap::modify_dest_var_inplace(VarNodeArray& vars) {
         sscanf(env_n_tensors, "%lld", &m_n_tensors);
     }
 
+    auto env_compression = MGB_GETENV("MGB_MEMORY_SWAP_PARAM_COMPRESSION");
+    if (env_compression) {
+        int tmp;
+        sscanf(env_compression, "%d", &tmp);
+        mgb_assert(
+                tmp >= 0 && tmp <= static_cast<int>(SwapCompression::BFLOAT16),
+                "bad swap compression method: %d", tmp);
+        m_compression = static_cast<SwapCompression>(tmp);
+    }
+
     auto env_swap_in_prev = MGB_GETENV("MGB_MEMORY_SWAP_PARAM_SWAP_IN_PREV");
     if (env_swap_in_prev) {
         sscanf(env_swap_in_prev, "%d", &m_swap_in_prev);
@@ -486,8 +511,28 @@ void MemorySwap::modify_dest_var_inplace(VarNodeArray& vars) {
     } else {
         m_lb_for_distance = std::min(m_lb_for_distance, (long long)opr_seq.size() / 20);
     }
-    if (!m_bucket_implement)
+    if (!env_swap_in_prev && m_bucket_implement &&
+        m_compression != SwapCompression::NONE) {
+        // the default lead covers the raw host to device copy; a compressed
+        // value is decoded on the copy thread before that, so scale the lead
+        // by the measured decoding time relative to the copy time
+        auto decode_speed = measure_swap_decode_throughput(m_compression);
+        if (decode_speed > 0) {
+            double scale = 1 + m_cpu_gpu_bandwidth / decode_speed;
+            // swapped vars are at least m_lb_for_distance oprs apart
+            long long lead = std::ceil(m_swap_in_prev * scale);
+            lead = std::min(lead, std::max(m_lb_for_distance / 2, 1ll));
+            m_swap_in_prev =
+                    static_cast<int>(std::max<long long>(m_swap_in_prev, lead));
+            mgb_log_debug(
+                    "memory swap: decode speed %.2fGB/s, swap-in lead %d oprs",
+                    decode_speed / 1e9, m_swap_in_prev);
+        }
+    }
+    if (!m_bucket_implement) {
         m_swap_in_prev = 1;
+        m_compression = SwapCompression::NONE;
+    }
 
     std::queue<OperatorNodeBase*> rst;
     std::queue<VarNode*> lst;
@@ -838,8 +883,8 @@ VarNode* MemorySwap::apply_bucket(VarNode* lhs, VarNode* dep_node, VarNode* wait
         svi.var = lhs;
         std::shared_ptr<SwapVarRecorder> swapVarRecorder;
         if (!m_firstSwapVarRecorderOwner) {
-            swapVarRecorder =
-                    std::make_shared<SwapVarRecorder>(&svi, m_max_swap_out_var_size);
+            swapVarRecorder = std::make_shared<SwapVarRecorder>(
+                    &svi, m_max_swap_out_var_size, m_compression);
             swapVarRecorder->enable(true);
             m_firstSwapVarRecorderOwner = soo;
         } else {
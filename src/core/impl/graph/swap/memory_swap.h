@@ -10,6 +10,8 @@
  */
 #pragma once
 
+#include "./swap_helper.h"
+
 #include "megbrain/graph.h"
 
 #include <set>
@@ -53,7 +55,8 @@ public:
 };
 
 /*!
- * Support large models by swapping some of the vars from GPU to CPU
+ * Support large models by swapping some of the vars from device memory to
+ * host memory; see swap_supported() for the comp nodes that can be used
  * Ideas are mainly copied from :
  * https://github.com/tensorflow/tensorflow/pull/19845 and
  * https://arxiv.org/abs/1807.02037
@@ -115,6 +118,16 @@ class MemorySwap {
      */
     long long m_lb_for_distance = 500;
 
+    /*!
+     * how swapped-out values are compressed on the copy thread; only used in
+     * bucket mode
+     *
+     * lossy methods halve the bytes of float32 activations, and decompression
+     * makes swap-in slower, so m_swap_in_prev is scaled by the decoding time
+     * measured on the host relative to the copy time
+     */
+    SwapCompression m_compression = SwapCompression::NONE;
+
     /*!
      * all the params above are preset for ResNet50 in model zoo, while the
      * opr_seq's length is about 7400; for other cases, the params may need to
@@ -11,12 +11,159 @@
 
 #include "./swap_helper.h"
 #include "megbrain/comp_node_env.h"
+#include "megbrain/utils/tensor_codec.h"
+#include "megbrain/utils/timer.h"
+
+#include <cstring>
 
 #if MGB_ENABLE_MEMORY_SWAP
 
 using namespace mgb;
 using namespace swap;
 
+namespace {
+using CodecMethod = tensor_codec::Method;
+
+//! keep the higher 16 bits of each float32, rounding to nearest even
+bool encode_bfloat16(const HostTensorND& src, std::vector<uint8_t>& dst) {
+    if (src.dtype() != dtype::Float32()) {
+        return false;
+    }
+    auto nr = src.shape().total_nr_elems();
+    auto ptr = src.ptr<float>();
+    dst.resize(nr * sizeof(uint16_t));
+    auto out = reinterpret_cast<uint16_t*>(dst.data());
+    for (size_t i = 0; i < nr; ++i) {
+        uint32_t v;
+        memcpy(&v, ptr + i, sizeof(v));
+        if ((v & 0x7fffffffu) > 0x7f800000u) {
+            // keep NaN a quiet NaN instead of rounding it to inf
+            out[i] = (v >> 16) | 0x40;
+        } else {
+            out[i] = (v + 0x7fffu + ((v >> 16) & 1)) >> 16;
+        }
+    }
+    return true;
+}
+
+void decode_bfloat16(const std::vector<uint8_t>& src, size_t nr, float* dst) {
+    mgb_assert(src.size() == nr * sizeof(uint16_t));
+    auto in = reinterpret_cast<const uint16_t*>(src.data());
+    for (size_t i = 0; i < nr; ++i) {
+        uint32_t v = static_cast<uint32_t>(in[i]) << 16;
+        memcpy(dst + i, &v, sizeof(v));
+    }
+}
+
+CodecMethod codec_method(SwapCompression method) {
+    switch (method) {
+        case SwapCompression::LOSSLESS:
+            return CodecMethod::LOSSLESS;
+        case SwapCompression::FLOAT16:
+            return CodecMethod::FLOAT16;
+        default:
+            mgb_throw(
+                    InternalError, "no tensor codec for swap compression %d",
+                    static_cast<int>(method));
+    }
+}
+}  // anonymous namespace
+
+double swap::measure_swap_decode_throughput(SwapCompression method) {
+    if (method == SwapCompression::NONE) {
+        return 0;
+    }
+    // smooth values, so that the lossless codec also gets a compressed value
+    constexpr size_t NR_ELEM = 1 << 18;
+    HostTensorND src{CompNode::default_cpu(), {NR_ELEM}, dtype::Float32()};
+    auto ptr = src.ptr<float>();
+    for (size_t i = 0; i < NR_ELEM; ++i) {
+        ptr[i] = static_cast<float>(i % 4096) / 4096.f;
+    }
+    std::vector<uint8_t> encoded;
+    bool succ = method == SwapCompression::BFLOAT16
+                      ? encode_bfloat16(src, encoded)
+                      : tensor_codec::encode(codec_method(method), src, encoded);
+    if (!succ) {
+        return 0;
+    }
+    HostTensorND dst{CompNode::default_cpu(), src.layout()};
+    // repeat for at least 10ms to get a stable result
+    RealTimer timer;
+    size_t nr_run = 0;
+    do {
+        if (method == SwapCompression::BFLOAT16) {
+            decode_bfloat16(encoded, NR_ELEM, dst.ptr<float>());
+        } else {
+            tensor_codec::decode(
+                    codec_method(method), encoded.data(), encoded.size(),
+                    src.layout(), dst.raw_ptr());
+        }
+        ++nr_run;
+    } while (timer.get_msecs() < 10);
+    return nr_run * src.layout().span().dist_byte() / timer.get_secs();
+}
+
+bool swap::swap_supported(CompNode cn) {
+    switch (cn.device_type()) {
+        case CompNode::DeviceType::CUDA:
+            return true;
+        case CompNode::DeviceType::CPU:
+            return cn.locator().device >= 0;
+        default:
+            return false;
+    }
+}
+
+/* ===================== SwappedValue ===================== */
+
+void SwappedValue::store(
+        const DeviceTensorND& src, SwapCompression method, HostTensorND& staging) {
+    m_layout = src.layout();
+    m_method = SwapCompression::NONE;
+    m_encoded.clear();
+    if (method == SwapCompression::NONE) {
+        // the value is read later from another stream (or another worker
+        // thread of a CPU comp node), so wait for the copy here
+        m_raw.copy_from(src).sync();
+        return;
+    }
+    staging.copy_from(src).sync();
+    bool succ;
+    if (method == SwapCompression::BFLOAT16) {
+        succ = encode_bfloat16(staging, m_encoded);
+    } else {
+        succ = tensor_codec::encode(
+                codec_method(method), staging, m_encoded);
+    }
+    // lossy methods never enlarge the value, so this only happens for
+    // non-float32 values or incompressible bytes
+    if (!succ || m_encoded.size() >= m_layout.span().dist_byte()) {
+        m_encoded.clear();
+        m_raw.copy_from(staging);
+        return;
+    }
+    m_encoded.shrink_to_fit();
+    m_raw = {};
+    m_method = method;
+}
+
+void SwappedValue::load(const DeviceTensorND& dst, HostTensorND& staging) const {
+    if (!compressed()) {
+        dst.copy_from_fixlayout(m_raw);
+        return;
+    }
+    staging.comp_node(dst.comp_node()).dtype(m_layout.dtype).resize(m_layout);
+    if (m_method == SwapCompression::BFLOAT16) {
+        decode_bfloat16(m_encoded, m_layout.total_nr_elems(), staging.ptr<float>());
+    } else {
+        tensor_codec::decode(
+                codec_method(m_method), m_encoded.data(), m_encoded.size(), m_layout,
+                staging.raw_ptr());
+    }
+    dst.copy_from_fixlayout(staging);
+}
+
 /* ===================== SwapCopyThreadPool ===================== */
 
 SwapCopyThreadPool& SwapCopyThreadPool::inst(CompNode cn) {
@@ -56,7 +203,19 @@ void SwapVarRecorder::copy_host_to_bucket(size_t id, Bucket& dest) {
             id);
     dest.h2d_copy_refhold = (m_saved_buckets[id]);
     auto do_copy = [&dest]() {
-        dest.associate_tensor->copy_from_fixlayout(*(dest.h2d_copy_refhold.get()));
+        auto&& value = *dest.h2d_copy_refhold;
+        auto cn = dest.associate_tensor->comp_node();
+        if (value.compressed() && dest.ev_h2d) {
+            // the staging buffer may still be read by the previous copy
+            dest.ev_h2d->host_wait();
+        }
+        value.load(*dest.associate_tensor, dest.h2d_staging);
+        if (value.compressed()) {
+            if (!dest.ev_h2d || dest.ev_h2d->comp_node() != cn) {
+                dest.ev_h2d = cn.create_event();
+            }
+            dest.ev_h2d->record();
+        }
         auto p = dest.copy_task_running.exchange(false);
         mgb_assert(p);
         dest.associate_tensor = nullptr;
@@ -71,21 +230,17 @@ void SwapVarRecorder::copy_bucket_to_host(size_t id, Bucket& src, CompNode comp_
         auto p = src.copy_task_running.exchange(true);
         mgb_assert(!p);
     }
-    bool flag = false;
-    if (m_saved_buckets.find(id) == m_saved_buckets.end()) {
-        auto ptr = new HostTensorND;
-        m_saved_buckets[id].reset(ptr);
-        flag = true;
+    auto&& saved = m_saved_buckets[id];
+    if (!saved) {
+        saved = std::make_shared<SwappedValue>();
     }
-    auto do_copy = [&src, this, id, flag]() {
+    // compression runs on the copy thread, so that the comp node only waits
+    // for the device-to-host copy
+    auto do_copy = [&src, value = saved, method = m_compression]() {
         src.buf_on_copy_stream.comp_node().device_wait_event(src.ev_comp2copy());
         src.ev_hd().record();
         src.ev_hd().host_wait();
-        if (flag)
-            (m_saved_buckets[id].get())->copy_from(src.buf_on_copy_stream);
-        else {
-            (m_saved_buckets[id].get())->copy_from_fixlayout(src.buf_on_copy_stream);
-        }
+        value->store(src.buf_on_copy_stream, method, src.d2h_staging);
         auto p = src.copy_task_running.exchange(false);
         mgb_assert(p);
     };
@@ -93,10 +248,12 @@ void SwapVarRecorder::copy_bucket_to_host(size_t id, Bucket& src, CompNode comp_
     src.copy_task_need_wait = true;
 }
 
-SwapVarRecorder::SwapVarRecorder(SwapVarInfo* swap_var_info, size_t ensure_size)
+SwapVarRecorder::SwapVarRecorder(
+        SwapVarInfo* swap_var_info, size_t ensure_size, SwapCompression compression)
         : m_copy_threadpool{SwapCopyThreadPool::inst(swap_var_info->var->comp_node())},
           m_swap_var_info{swap_var_info},
-          m_ensure_size{ensure_size} {
+          m_ensure_size{ensure_size},
+          m_compression{compression} {
     m_copy_threadpool.start();
 }
 
@@ -118,8 +275,9 @@ void SwapVarRecorder::on_val_produced(size_t swap_out_id, const DeviceTensorND&
     bucket.wait_copy();
     bucket.init(val.comp_node(), val.dtype(), val.shape(), m_ensure_size);
     bucket.buf.copy_from(val);
-    copy_bucket_to_host(swap_out_id, bucket, val.comp_node());
+    // record before launching the copy task that waits on the event
     bucket.ev_comp2copy().record();
+    copy_bucket_to_host(swap_out_id, bucket, val.comp_node());
 }
 
 void SwapVarRecorder::wait_mission_finish(const DeviceTensorND* waiting_dev_tensor) {
@@ -23,6 +23,73 @@ struct SwapVarInfo {
     VarNode* var = nullptr;
 };
 
+/*!
+ * \brief how a swapped-out value is transformed before being kept on host
+ *
+ * lossy methods only apply to float32 values; other values, and values that
+ * would not get smaller, are kept as raw bytes
+ */
+enum class SwapCompression : int {
+    NONE = 0,
+    //! byte-plane split followed by an LZ-style codec
+    LOSSLESS = 1,
+    FLOAT16 = 2,
+    BFLOAT16 = 3,
+};
+
+/*!
+ * \brief measure the number of bytes of original float32 values that can be
+ *      decompressed per second by \p method on this host
+ *
+ * \return 0 if \p method does not need decompression
+ */
+double measure_swap_decode_throughput(SwapCompression method);
+
+/*!
+ * \brief whether vars on \p cn can be swapped out
+ *
+ * The copy runs on the LOOP_SWAP stream of the comp node, so CUDA comp nodes
+ * and CPU comp nodes with their own worker thread (i.e. not cpu:default) are
+ * supported.
+ */
+bool swap_supported(CompNode cn);
+
+/* ===================== SwappedValue ===================== */
+//! a value kept on host, optionally compressed
+class SwappedValue final : public NonCopyableObj {
+    TensorLayout m_layout;
+    SwapCompression m_method = SwapCompression::NONE;
+    HostTensorND m_raw;
+    std::vector<uint8_t> m_encoded;
+
+public:
+    /*!
+     * \brief store the value of a device tensor
+     *
+     * \param staging host buffer to hold the raw value before compression;
+     *      unused if \p method is NONE
+     */
+    void store(
+            const DeviceTensorND& src, SwapCompression method,
+            HostTensorND& staging);
+
+    /*!
+     * \brief copy the stored value into \p dst
+     *
+     * \param staging host buffer to hold the decompressed value; it must be
+     *      kept alive until the copy finishes on the comp node of \p dst
+     */
+    void load(const DeviceTensorND& dst, HostTensorND& staging) const;
+
+    //! whether the value is kept in compressed form
+    bool compressed() const { return m_method != SwapCompression::NONE; }
+
+    //! number of bytes kept on host
+    size_t nr_bytes() const {
+        return compressed() ? m_encoded.size() : m_layout.span().dist_byte();
+    }
+};
+
 /* ===================== SwapCopyThreadPool ===================== */
 class SwapCopyThreadPool final : public UserDataContainer::UserData {
     MGB_TYPEINFO_OBJ_DECL;
@@ -69,7 +136,11 @@ private:
         EventGroup ev_grp[2];
         int ev_grp_cur = 0;
 
-        std::shared_ptr<HostTensorND> h2d_copy_refhold;
+        std::shared_ptr<SwappedValue> h2d_copy_refhold;
+
+        //! host buffers for compressed values, on the worker thread only
+        HostTensorND d2h_staging, h2d_staging;
+        std::unique_ptr<CompNode::Event> ev_h2d;
 
         FutureThreadPool<void>::Future copy_task;
         bool copy_task_need_wait = false;
@@ -127,8 +198,9 @@ private:
     Bucket m_buckets_out[Bucket::nr_buckets_out];
     int m_cur_bucket_in = 0, m_cur_bucket_out = 0;
     size_t m_ensure_size = 0;
+    const SwapCompression m_compression;
 
-    std::unordered_map<size_t, std::shared_ptr<HostTensorND>> m_saved_buckets;
+    std::unordered_map<size_t, std::shared_ptr<SwappedValue>> m_saved_buckets;
 
     std::mutex m_saved_buckets_mtx;
 
@@ -143,7 +215,9 @@ private:
     void copy_bucket_to_host(size_t id, Bucket& src, CompNode comp_node);
 
 public:
-    SwapVarRecorder(SwapVarInfo* swap_var_info, size_t ensure_size);
+    SwapVarRecorder(
+            SwapVarInfo* swap_var_info, size_t ensure_size,
+            SwapCompression compression = SwapCompression::NONE);
 
     void pop_value(size_t swap_out_id, const DeviceTensorND& od);
 
@@ -161,6 +235,8 @@ public:
     void wait_mission_finish(const DeviceTensorND* waiting_dev_tensor);
 
     SwapVarInfo* swap_var_info() const { return m_swap_var_info; }
+
+    SwapCompression compression() const { return m_compression; }
 };
 
 }  // namespace swap
@@ -196,6 +196,19 @@ public:
         return m_seq_mem_opt.static_mem_usage();
     }
 
+    //! hit/miss statistics of the static memory plan cache
+    AsyncExecutable::StaticMemPlanCacheStat static_mem_plan_cache_stat() const {
+        return m_seq_mem_opt.static_mem_plan_cache_stat();
+    }
+
+    std::string dump_static_mem_plan() const {
+        return m_seq_mem_opt.dump_static_mem_plan();
+    }
+
+    void load_static_mem_plan(const std::string& buf) {
+        m_seq_mem_opt.load_static_mem_plan(buf);
+    }
+
     /*!
      * \brief allocate dynamic output var node memory for operator; should
      * be called before operator execution
@@ -266,6 +279,19 @@ public:
      */
     size_t clear_static_device_memory();
 
+    /*!
+     * \brief move live dynamic vars together and release cached free
+     *      memory; see VarDevMemDefragmenter::compact()
+     *
+     * \return total size of moved memory
+     */
+    size_t compact_dynamic_memory() { return m_var_dev_mem_defragmenter.compact(); }
+
+    //! size of dynamic memory that can be moved by compact_dynamic_memory()
+    size_t dynamic_movable_size(CompNode cn) {
+        return m_var_dev_mem_defragmenter.movable_size(cn);
+    }
+
     //! get the reference to the static device memory
     const SmallVector<DeviceTensorStorage>& static_device_memory_refholder() const {
         return m_static_mem_refholder;
@@ -81,7 +81,6 @@ void VarDevMemDefragmenter::defrag(
 
 void VarDevMemDefragmenter::defrag_impl(
         VarNode* req_var, const CompNodeInfo& cn_info, size_t extra_size) {
-    ThinHashMap<MemAllocPlan::Chunk*, ChunkInfo> chunkinfo;
     VarNodeSet non_movable_vars;
     if (!m_move_safe_oprs.count(req_var->owner_opr())) {
         // input and output vars of current opr can not be moved
@@ -95,15 +94,20 @@ void VarDevMemDefragmenter::defrag_impl(
             non_movable_vars.insert(i);
         }
     }
+    move_vars(req_var->comp_node(), cn_info, extra_size, non_movable_vars);
+}
+
+size_t VarDevMemDefragmenter::move_vars(
+        CompNode cn, const CompNodeInfo& cn_info, size_t extra_size,
+        const VarNodeSet& non_movable) {
+    ThinHashMap<MemAllocPlan::Chunk*, ChunkInfo> chunkinfo;
     for (auto i : cn_info.vars) {
-        if (i->dev_tensor_valid() && !non_movable_vars.count(i)) {
+        if (i->dev_tensor_valid() && !non_movable.count(i)) {
             auto chk = &i->mem_plan().chunk();
             chunkinfo[chk].readers.push_back(i);
         }
     }
 
-    auto cn = req_var->comp_node();
-
     // here we do not need to handle exceptions and restore vars, since
     // allocation failure requires the whole graph to be re-executed and all
     // vars would be re-allocated
@@ -160,6 +164,10 @@ void VarDevMemDefragmenter::defrag_impl(
             nr_var, chunkinfo.size(), tot_size / 1024.0 / 1024, nr_refcnt_mismatch,
             cn.get_mem_status_bytes().second / 1024.0 / 1024);
 
+    if (!tot_size) {
+        return 0;
+    }
+
     auto&& allocator = m_mem_mgr->static_device_memory_manager()->allocator();
     allocator.defrag_prealloc_contig(m_mem_mgr->owner_graph(), cn, tot_size);
 
@@ -186,6 +194,43 @@ void VarDevMemDefragmenter::defrag_impl(
     }
     mgb_assert(offset + extra_size == tot_size);
     cn.sync();  // wait copy finish before destructing host values
+    return offset;
+}
+
+size_t VarDevMemDefragmenter::compact() {
+    size_t moved = 0;
+    if (m_enable) {
+        m_mem_mgr->owner_graph()->event().signal_inplace<event::BeforeMemDefrag>();
+        MGB_LOCK_GUARD(m_mtx);
+        for (auto&& i : m_cninfo_map) {
+            if (enable_compact_for_device(i.first.device_type())) {
+                MGB_LOCK_GUARD(i.second.mtx);
+                moved += move_vars(i.first, i.second, 0, {});
+            }
+        }
+    }
+    // vars on other devices are not moved, but their cached free memory can
+    // still be returned to the device
+    CompNode::try_coalesce_all_free_memory();
+    return moved;
+}
+
+size_t VarDevMemDefragmenter::movable_size(CompNode cn) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto iter = m_cninfo_map.find(cn);
+    if (!m_enable || !enable_compact_for_device(cn.device_type()) ||
+        iter == m_cninfo_map.end()) {
+        return 0;
+    }
+    MGB_LOCK_GUARD(iter->second.mtx);
+    ThinHashSet<MemAllocPlan::Chunk*> chunks;
+    size_t size = 0;
+    for (auto i : iter->second.vars) {
+        if (i->dev_tensor_valid() && chunks.insert(&i->mem_plan().chunk()).second) {
+            size += i->mem_plan().chunk().size();
+        }
+    }
+    return size;
 }
 
 #endif  // MGB_ENABLE_VAR_DEV_MEM_DEFRAGMENTER
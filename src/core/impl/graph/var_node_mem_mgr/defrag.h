@@ -19,7 +19,8 @@ namespace cg {
 /*!
  * \brief defragmenter for device memory used by dynamic variables
  *
- * Currently only enabled for cuda.
+ * Defragmenting on allocation failure is only enabled for cuda; compact()
+ * also works on cpu.
  *
  * alloc_var_storage() is thread-safe.
  */
@@ -28,7 +29,7 @@ public:
     explicit VarDevMemDefragmenter(VarNodeMemManager* mem_mgr) : m_mem_mgr{mem_mgr} {}
 
 private:
-    bool m_enable;
+    bool m_enable = false;
     VarNodeMemManager* const m_mem_mgr;
 
     void alloc_direct(VarNode* var, DeviceTensorStorage& storage, size_t size);
@@ -49,6 +50,12 @@ private:
         return type == CompNode::DeviceType::CUDA;
     }
 
+    //! query whether vars on a device type can be moved by compact()
+    static bool enable_compact_for_device(CompNode::DeviceType type) {
+        return type == CompNode::DeviceType::CUDA ||
+               type == CompNode::DeviceType::CPU;
+    }
+
     //! allocate storage and call defrag() if fails
     void alloc_with_defrag(VarNode* var, DeviceTensorStorage& storage, size_t size);
 
@@ -64,6 +71,20 @@ private:
 
     void defrag_impl(VarNode* req_var, const CompNodeInfo& cn_info, size_t extra_size);
 
+    /*!
+     * \brief move chunks of live vars on a comp node into a contiguous
+     *      region
+     *
+     * Note: lock of \p cn_info must be held and no opr that reads the
+     * moved vars can be running
+     * \param extra_size size to be preallocated after the moved chunks
+     * \param non_movable vars that must be kept in place
+     * \return total size of the moved chunks
+     */
+    size_t move_vars(
+            CompNode cn, const CompNodeInfo& cn_info, size_t extra_size,
+            const VarNodeSet& non_movable);
+
 public:
     /*!
      * \brief allocate storage for a var
@@ -85,6 +106,20 @@ public:
 
     //! clear all registered vars
     void clear_all();
+
+    /*!
+     * \brief compact live dynamic vars on all enabled comp nodes and
+     *      return cached free memory to the device
+     *
+     * This must be called when the graph is not running (e.g. between two
+     * executions).
+     *
+     * \return total size of moved chunks
+     */
+    size_t compact();
+
+    //! total size of chunks that would be moved by compact() on \p cn
+    size_t movable_size(CompNode cn);
 #else  // MGB_ENABLE_VAR_DEV_MEM_DEFRAGMENTER
 public:
     void alloc_var_storage(VarNode* var, DeviceTensorStorage& storage, size_t size) {
@@ -95,6 +130,13 @@ public:
 
     void register_var(VarNode*) {}
 
+    size_t compact() {
+        CompNode::try_coalesce_all_free_memory();
+        return 0;
+    }
+
+    size_t movable_size(CompNode) { return 0; }
+
 #endif  // MGB_ENABLE_VAR_DEV_MEM_DEFRAGMENTER
 
     //! set whether to enable deragmenting
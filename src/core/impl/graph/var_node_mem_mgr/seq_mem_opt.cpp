@@ -17,6 +17,7 @@
 #include "megbrain/graph/exc_extra_info.h"
 #include "megbrain/graph/helper.h"
 #include "megbrain/utils/arith_helper.h"
+#include "megbrain/utils/hash.h"
 #include "megbrain/utils/metahelper.h"
 
 using namespace mgb;
@@ -270,7 +271,11 @@ bool SeqMemOptimizer::run_static_mem_alloc() {
     bool ret = false;
     for (auto&& i : group_by_cn) {
         auto cmp = [](const MemChunkLifeInterval& a, const MemChunkLifeInterval& b) {
-            return a.begin < b.begin || (a.begin == b.begin && a.end < b.end);
+            if (a.begin != b.begin)
+                return a.begin < b.begin;
+            if (a.end != b.end)
+                return a.end < b.end;
+            return a.chunk->owner_var->id() < b.chunk->owner_var->id();
         };
         // sort for stable order
         std::sort(i.second.begin(), i.second.end(), cmp);
@@ -299,41 +304,32 @@ bool SeqMemOptimizer::run_static_mem_alloc_on_comp_node(
         StaticMemAllocLogger& static_mem_alloc_logger) {
     size_t size_ub = 0;
 
-    auto allocator = StaticMemAlloc::make(StaticMemAlloc::AllocatorAlgo::PUSHDOWN);
-    allocator->alignment(comp_node.get_mem_addr_alignment());
-    allocator->padding(comp_node.get_mem_padding());
-#if MGB_ENABLE_DEBUG_UTIL
-    allocator->dbg_key2varnode = [](StaticMemAlloc::UserKeyType key) {
-        return static_cast<const MemChunkLifeInterval*>(key)->chunk->owner_var;
-    };
-#endif
-    ThinHashMap<MemAllocPlan::Chunk*, size_t> chunk2allocatorid;
-    for (auto&& chk : chunks) {
-        auto id = allocator->add(chk.begin, chk.end, chk.chunk->size(), &chk);
-        auto ins_rst = chunk2allocatorid.emplace(chk.chunk, id);
+    ThinHashMap<MemAllocPlan::Chunk*, size_t> chunk2idx;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        auto ins_rst = chunk2idx.emplace(chunks[i].chunk, i);
         mgb_assert(ins_rst.second);
-        size_ub += chk.chunk->size();
+        size_ub += chunks[i].chunk->size();
     }
 
+    std::vector<OverwriteSpec> overwrite_specs;
     for (auto&& i : m_writable_fwd_mem_plans) {
-        auto from_iter = chunk2allocatorid.find(&i.first->chunk()),
-             to_iter = chunk2allocatorid.find(&i.second->chunk());
+        auto from_iter = chunk2idx.find(&i.first->chunk()),
+             to_iter = chunk2idx.find(&i.second->chunk());
 
         // ignore mem fwd specs that involve other chunks
-        if (from_iter != chunk2allocatorid.end() &&
-            to_iter != chunk2allocatorid.end()) {
-            allocator->add_overwrite_spec(
-                    to_iter->second, from_iter->second,
-                    i.first->offset_in_chunk_byte());
+        if (from_iter != chunk2idx.end() && to_iter != chunk2idx.end()) {
+            overwrite_specs.push_back(
+                    {to_iter->second, from_iter->second,
+                     i.first->offset_in_chunk_byte()});
         }
     }
     {
-        decltype(chunk2allocatorid) v;
-        chunk2allocatorid.swap(v);
+        decltype(chunk2idx) v;
+        chunk2idx.swap(v);
     }
 
-    allocator->solve();
-    size_t size = allocator->tot_alloc(), size_lb = allocator->tot_alloc_lower_bound();
+    auto&& plan = get_static_mem_plan(comp_node, chunks, overwrite_specs);
+    size_t size = plan.size, size_lb = plan.size_lb;
 
     static_mem_alloc_logger.push(comp_node, size, size_lb, size_ub);
 
@@ -343,9 +339,8 @@ bool SeqMemOptimizer::run_static_mem_alloc_on_comp_node(
 
     if (!should_realloc) {
         m_static_mem_usage.val()[comp_node] = size;
-        for (auto&& chk : chunks) {
-            chk.chunk->mem_alloc_status.set_static_offset(
-                    allocator->get_start_addr(&chk));
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            chunks[i].chunk->mem_alloc_status.set_static_offset(plan.offsets[i]);
         }
 #ifndef __IN_TEE_ENV__
         auto& recorder = StaticMemRecorder::Instance();
@@ -362,6 +357,256 @@ bool SeqMemOptimizer::run_static_mem_alloc_on_comp_node(
     return should_realloc;
 }
 
+const SeqMemOptimizer::StaticMemPlan& SeqMemOptimizer::get_static_mem_plan(
+        CompNode comp_node, const std::vector<MemChunkLifeInterval>& chunks,
+        const std::vector<OverwriteSpec>& overwrite_specs) {
+    StaticMemPlan plan;
+    auto&& key = plan.key;
+    key.reserve(2 + chunks.size() * 3);
+    key.push_back(comp_node.get_mem_addr_alignment());
+    key.push_back(comp_node.get_mem_padding());
+    for (auto&& chk : chunks) {
+        key.push_back(chk.begin);
+        key.push_back(chk.end);
+        key.push_back(chk.chunk->size());
+    }
+    plan.overwrite_key.reserve(overwrite_specs.size() * 3);
+    for (auto&& i : overwrite_specs) {
+        plan.overwrite_key.insert(plan.overwrite_key.end(), i.begin(), i.end());
+    }
+    plan.hash = hash_plan_key(plan);
+
+    auto capacity = m_graph->options().seq_opt.static_mem_plan_cache_size;
+    auto&& cache = m_static_mem_plan_cache[comp_node];
+    if (capacity) {
+        for (auto iter = cache.begin(); iter != cache.end(); ++iter) {
+            if (iter->hash == plan.hash && iter->key == key &&
+                iter->overwrite_key == plan.overwrite_key) {
+                ++m_static_mem_plan_cache_stat.nr_hit;
+                cache.splice(cache.begin(), cache, iter);
+                return cache.front();
+            }
+        }
+        ++m_static_mem_plan_cache_stat.nr_miss;
+    }
+
+    auto algo = StaticMemAlloc::AllocatorAlgo::PUSHDOWN;
+#if !MGB_BUILD_SLIM_SERVING
+    auto optimal_time = m_graph->options().seq_opt.static_mem_optimal_alloc_time;
+    if (optimal_time > 0) {
+        algo = StaticMemAlloc::AllocatorAlgo::OPTIMAL;
+    }
+#endif
+    auto allocator = StaticMemAlloc::make(algo);
+#if !MGB_BUILD_SLIM_SERVING
+    allocator->time_limit(optimal_time);
+#endif
+    allocator->alignment(comp_node.get_mem_addr_alignment());
+    allocator->padding(comp_node.get_mem_padding());
+#if MGB_ENABLE_DEBUG_UTIL
+    allocator->dbg_key2varnode = [](StaticMemAlloc::UserKeyType key) {
+        return static_cast<const MemChunkLifeInterval*>(key)->chunk->owner_var;
+    };
+#endif
+    std::vector<size_t> allocator_ids;
+    allocator_ids.reserve(chunks.size());
+    for (auto&& chk : chunks) {
+        allocator_ids.push_back(
+                allocator->add(chk.begin, chk.end, chk.chunk->size(), &chk));
+    }
+    for (auto&& i : overwrite_specs) {
+        allocator->add_overwrite_spec(allocator_ids[i[0]], allocator_ids[i[1]], i[2]);
+    }
+
+    allocator->solve();
+    plan.size = allocator->tot_alloc();
+    plan.size_lb = allocator->tot_alloc_lower_bound();
+    plan.offsets.reserve(chunks.size());
+    for (auto&& chk : chunks) {
+        plan.offsets.push_back(allocator->get_start_addr(&chk));
+    }
+
+    cache.emplace_front(std::move(plan));
+    // the newly solved plan is always kept since its reference is returned
+    while (cache.size() > std::max<size_t>(capacity, 1)) {
+        cache.pop_back();
+    }
+    return cache.front();
+}
+
+AsyncExecutable::StaticMemPlanCacheStat SeqMemOptimizer::static_mem_plan_cache_stat()
+        const {
+    auto ret = m_static_mem_plan_cache_stat;
+    ret.nr_cached = 0;
+    for (auto&& i : m_static_mem_plan_cache) {
+        ret.nr_cached += i.second.size();
+    }
+    return ret;
+}
+
+namespace {
+constexpr uint64_t STATIC_MEM_PLAN_MAGIC = 0x4d47425350303032;  // "MGBSP002"
+
+class PlanWriter {
+    std::string m_buf;
+
+public:
+    void put(uint64_t v) { m_buf.append(reinterpret_cast<const char*>(&v), 8); }
+
+    void put(const std::string& s) {
+        put(s.size());
+        m_buf.append(s);
+    }
+
+    void put(const std::vector<size_t>& v) {
+        put(v.size());
+        for (auto i : v)
+            put(i);
+    }
+
+    std::string take() { return std::move(m_buf); }
+};
+
+class PlanReader {
+    const std::string& m_buf;
+    size_t m_pos = 0;
+
+    void check(size_t size) {
+        mgb_throw_if(
+                m_buf.size() - m_pos < size, SerializationError,
+                "truncated static memory plan: need %zu bytes at %zu, total %zu",
+                size, m_pos, m_buf.size());
+    }
+
+public:
+    explicit PlanReader(const std::string& buf) : m_buf{buf} {}
+
+    bool eof() const { return m_pos == m_buf.size(); }
+
+    uint64_t get_u64() {
+        check(8);
+        uint64_t v;
+        memcpy(&v, m_buf.data() + m_pos, 8);
+        m_pos += 8;
+        return v;
+    }
+
+    std::string get_str() {
+        auto size = get_u64();
+        check(size);
+        std::string ret = m_buf.substr(m_pos, size);
+        m_pos += size;
+        return ret;
+    }
+
+    std::vector<size_t> get_vec() {
+        auto size = get_u64();
+        check(size * 8);
+        std::vector<size_t> ret(size);
+        for (auto&& i : ret)
+            i = get_u64();
+        return ret;
+    }
+};
+}  // anonymous namespace
+
+size_t SeqMemOptimizer::hash_plan_key(const StaticMemPlan& plan) {
+    size_t hash = plan.key.size();
+    for (auto i : plan.key) {
+        hash = hash_pair_combine(hash, i);
+    }
+    for (auto i : plan.overwrite_key) {
+        hash = hash_pair_combine(hash, i);
+    }
+    return hash;
+}
+
+void SeqMemOptimizer::check_loaded_plan(const StaticMemPlan& plan) {
+    auto nr_chunk = plan.offsets.size();
+    mgb_throw_if(
+            plan.key.size() != 2 + nr_chunk * 3, SerializationError,
+            "bad static memory plan: key size %zu, %zu offsets", plan.key.size(),
+            nr_chunk);
+    mgb_throw_if(
+            plan.overwrite_key.size() % 3, SerializationError,
+            "bad static memory plan: overwrite spec size %zu",
+            plan.overwrite_key.size());
+    for (size_t i = 0; i < plan.overwrite_key.size(); i += 3) {
+        mgb_throw_if(
+                plan.overwrite_key[i] >= nr_chunk ||
+                        plan.overwrite_key[i + 1] >= nr_chunk,
+                SerializationError,
+                "bad static memory plan: overwrite spec (%zu, %zu) with %zu chunks",
+                plan.overwrite_key[i], plan.overwrite_key[i + 1], nr_chunk);
+    }
+    for (size_t i = 0; i < nr_chunk; ++i) {
+        auto offset = plan.offsets[i], size = plan.key[2 + i * 3 + 2];
+        mgb_throw_if(
+                offset > plan.size || size > plan.size - offset, SerializationError,
+                "bad static memory plan: chunk %zu at [%zu, +%zu) exceeds size %zu",
+                i, offset, size, plan.size);
+    }
+}
+
+std::string SeqMemOptimizer::dump_static_mem_plan() const {
+    PlanWriter writer;
+    writer.put(STATIC_MEM_PLAN_MAGIC);
+    for (auto&& i : m_static_mem_plan_cache) {
+        if (i.second.empty())
+            continue;
+        writer.put(i.first.to_string());
+        writer.put(i.second.size());
+        for (auto&& plan : i.second) {
+            writer.put(plan.key);
+            writer.put(plan.offsets);
+            writer.put(plan.overwrite_key);
+            writer.put(plan.size);
+            writer.put(plan.size_lb);
+        }
+    }
+    return writer.take();
+}
+
+void SeqMemOptimizer::load_static_mem_plan(const std::string& buf) {
+    PlanReader reader{buf};
+    mgb_throw_if(
+            reader.get_u64() != STATIC_MEM_PLAN_MAGIC, SerializationError,
+            "bad magic of static memory plan");
+    auto capacity = m_graph->options().seq_opt.static_mem_plan_cache_size;
+    while (!reader.eof()) {
+        auto cn_name = reader.get_str();
+        CompNode comp_node;
+        for (auto&& cn : m_all_comp_nodes) {
+            if (cn.to_string() == cn_name) {
+                comp_node = cn;
+                break;
+            }
+        }
+        auto nr_plan = reader.get_u64();
+        for (size_t i = 0; i < nr_plan; ++i) {
+            StaticMemPlan plan;
+            plan.key = reader.get_vec();
+            plan.offsets = reader.get_vec();
+            plan.overwrite_key = reader.get_vec();
+            plan.size = reader.get_u64();
+            plan.size_lb = reader.get_u64();
+            check_loaded_plan(plan);
+            if (!comp_node.valid())
+                continue;
+            plan.hash = hash_plan_key(plan);
+            auto&& cache = m_static_mem_plan_cache[comp_node];
+            bool dup = false;
+            for (auto&& j : cache) {
+                dup |= j.hash == plan.hash && j.key == plan.key &&
+                       j.overwrite_key == plan.overwrite_key;
+            }
+            if (!dup && cache.size() < capacity) {
+                cache.emplace_back(std::move(plan));
+            }
+        }
+    }
+}
+
 void SeqMemOptimizer::reset_opr_seq(
         const OprNodeArray* seq, const OprNodeArray* seq_sys_alloc,
         const VarNodeSet* static_alloc_var, SmallVector<CompNode> all_comp_nodes) {
@@ -371,6 +616,8 @@ void SeqMemOptimizer::reset_opr_seq(
     m_cur_static_alloc_var = static_alloc_var;
     m_all_comp_nodes = std::move(all_comp_nodes);
     m_static_mem_usage.invalidate();
+    m_static_mem_plan_cache.clear();
+    m_static_mem_plan_cache_stat = {};
 }
 
 void SeqMemOptimizer::add_writable_fwd_mem_plan_pair(
@@ -13,6 +13,9 @@
 
 #include "../impl_common.h"
 
+#include <array>
+#include <list>
+
 namespace mgb {
 namespace cg {
 
@@ -33,6 +36,28 @@ class SeqMemOptimizer {
         CompNode comp_node;
     };
 
+    /*!
+     * \brief solution of the static allocation problem on a comp node
+     *
+     * The key describes the whole problem (alignment, padding, life
+     * intervals and sizes of the chunks, and the writable forwarding specs),
+     * so a plan can be reused whenever the same problem is seen again, e.g.
+     * when input shapes switch back to previously seen values.
+     */
+    struct StaticMemPlan {
+        size_t hash = 0;
+        //! alignment, padding and (begin, end, size) of each chunk
+        std::vector<size_t> key;
+        //! flattened overwrite specs, which are also part of the problem
+        std::vector<size_t> overwrite_key;
+        //! offset of each chunk, in the order of the chunks given to solver
+        std::vector<size_t> offsets;
+        size_t size = 0, size_lb = 0;
+    };
+
+    //! (dest, src, offset) of writable forwarding, see add_overwrite_spec
+    using OverwriteSpec = std::array<size_t, 3>;
+
     using CompNode2Chunkset = CompNode::UnorderedMap<ThinHashSet<MemAllocPlan::Chunk*>>;
 
     ComputingGraphImpl* m_graph;
@@ -46,6 +71,10 @@ class SeqMemOptimizer {
     size_t m_status = 0;
     std::vector<std::pair<MemAllocPlan*, MemAllocPlan*>> m_writable_fwd_mem_plans;
 
+    //! solved plans on each comp node, most recently used first
+    CompNode::UnorderedMap<std::list<StaticMemPlan>> m_static_mem_plan_cache;
+    AsyncExecutable::StaticMemPlanCacheStat m_static_mem_plan_cache_stat;
+
     bool should_static_alloc_var(VarNode* var);
 
     bool in_sys_alloc(OperatorNodeBase* opr) const {
@@ -60,6 +89,22 @@ class SeqMemOptimizer {
             CompNode cn, const std::vector<MemChunkLifeInterval>& chunks,
             StaticMemAllocLogger& static_mem_alloc_logger);
 
+    /*!
+     * \brief get the static allocation plan for chunks on a comp node, from
+     *      the plan cache or by running the solver
+     */
+    const StaticMemPlan& get_static_mem_plan(
+            CompNode cn, const std::vector<MemChunkLifeInterval>& chunks,
+            const std::vector<OverwriteSpec>& overwrite_specs);
+
+    static size_t hash_plan_key(const StaticMemPlan& plan);
+
+    /*!
+     * \brief check that a loaded plan describes exactly its own chunks and
+     *      that every chunk fits in the planned size
+     */
+    static void check_loaded_plan(const StaticMemPlan& plan);
+
 public:
     SeqMemOptimizer(ComputingGraphImpl* graph) : m_graph(graph) {}
 
@@ -111,6 +156,20 @@ public:
 
     void optimize_mem_plan_dynamic(OperatorNodeBase* opr);
 
+    //! hit/miss statistics of the static memory plan cache
+    AsyncExecutable::StaticMemPlanCacheStat static_mem_plan_cache_stat() const;
+
+    //! serialize cached static memory plans of all comp nodes
+    std::string dump_static_mem_plan() const;
+
+    /*!
+     * \brief add plans given by dump_static_mem_plan() to the plan cache
+     *
+     * This should be called after reset_opr_seq(), since the cache is
+     * cleared there
+     */
+    void load_static_mem_plan(const std::string& buf);
+
     /*!
      * \brief bitmask for status
      */
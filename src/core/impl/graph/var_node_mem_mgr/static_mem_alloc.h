@@ -40,6 +40,10 @@ public:
 
         //! O(n log n) allocator with better performance
         PUSHDOWN,
+
+        //! branch-and-bound search starting from PUSHDOWN result; slow, for
+        //! offline planning; see time_limit()
+        OPTIMAL,
     };
 
     static std::unique_ptr<StaticMemAlloc> make(AllocatorAlgo algo);
@@ -99,6 +103,14 @@ public:
      */
     virtual StaticMemAlloc& padding(size_t padding) = 0;
 
+    /*!
+     * \brief set time limit in seconds for search-based allocators
+     *
+     * Only used by AllocatorAlgo::OPTIMAL, which returns the best plan found
+     * when time is up; ignored by other allocators.
+     */
+    virtual StaticMemAlloc& time_limit(double) { return *this; }
+
 #if MGB_ENABLE_DEBUG_UTIL
     //! set by the caller to convert key to VarNode* for debug logging
     VarNode* (*dbg_key2varnode)(UserKeyType) = nullptr;
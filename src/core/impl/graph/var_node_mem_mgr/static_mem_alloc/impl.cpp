@@ -12,6 +12,7 @@
 #include "./impl.h"
 #include "./best_fit.h"
 #include "./interval_move.h"
+#include "./optimal.h"
 #include "./pushdown.h"
 
 #include <map>
@@ -385,6 +386,8 @@ std::unique_ptr<StaticMemAlloc> StaticMemAlloc::make(AllocatorAlgo algo) {
             return std::make_unique<StaticMemAllocIntervalMove>();
         case AllocatorAlgo::BEST_FIT:
             return std::make_unique<StaticMemAllocBestFit>();
+        case AllocatorAlgo::OPTIMAL:
+            return std::make_unique<StaticMemAllocOptimal>();
 #endif
         case AllocatorAlgo::PUSHDOWN:
             return std::make_unique<StaticMemAllocPushdown>();
@@ -0,0 +1,297 @@
+/**
+ * \file src/core/impl/graph/var_node_mem_mgr/static_mem_alloc/optimal.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "./optimal.h"
+
+#include "megbrain/utils/timer.h"
+
+#include <algorithm>
+
+using namespace mgb;
+using namespace cg;
+
+namespace {
+//! give up searching if there are too many conflicting interval pairs
+constexpr size_t MAX_NR_CONFLICT = 1 << 22;
+
+//! try all placement orders if there are no more groups than this;
+//! otherwise only the most promising few are tried at each step
+constexpr size_t FULL_BRANCH_MAX_NR_GROUP = 128;
+constexpr size_t LIMITED_BRANCH = 4;
+
+constexpr size_t NONE = -1;
+}  // anonymous namespace
+
+class StaticMemAllocOptimal::BranchAndBound {
+public:
+    //! an interval of a group, with offset relative to the group address
+    struct Segment {
+        size_t time_begin, time_end, offset, size, group;
+    };
+
+    /*!
+     * \brief group *other* placed at address a forbids this group from the
+     *      open interval (a + lo, a + hi)
+     */
+    struct Conflict {
+        size_t other;
+        int64_t lo, hi;
+    };
+
+    //! an overwrite root with all its overwriters
+    struct Group {
+        Interval* root;
+        size_t height;
+    };
+
+    BranchAndBound(StaticMemAllocOptimal* owner) : m_owner{owner} {}
+
+    //! build groups and conflicts; return false if the problem is too large
+    bool init(const IntervalPtrArray& intervals);
+
+    /*!
+     * \brief search for a plan better than the one in Interval::addr_begin
+     * \return new peak usage, or the old one if nothing better is found
+     */
+    size_t run(size_t cur_peak, double time_limit);
+
+    size_t nr_group() const { return m_groups.size(); }
+    size_t nr_node() const { return m_nr_node; }
+    size_t lower_bound() const { return m_lower_bound; }
+
+private:
+    StaticMemAllocOptimal* const m_owner;
+    std::vector<Group> m_groups;
+    std::vector<std::vector<Conflict>> m_conflicts;
+    size_t m_lower_bound = 0;
+
+    std::vector<int64_t> m_addr, m_best_addr;
+    size_t m_best = 0, m_nr_node = 0, m_mark_stamp = 0;
+    std::vector<size_t> m_mark;
+    std::vector<std::pair<int64_t, int64_t>> m_forbidden;
+    std::vector<std::pair<int64_t, size_t>> m_cand_buf;
+    bool m_timeout = false;
+    double m_time_limit = 0;
+    RealTimer m_timer;
+
+    size_t align(size_t addr) const { return m_owner->align(addr); }
+
+    //! lowest aligned address where a group can be placed
+    int64_t lowest_addr(size_t group);
+
+    void dfs(size_t depth, size_t peak, size_t last);
+};
+
+bool StaticMemAllocOptimal::BranchAndBound::init(
+        const IntervalPtrArray& intervals) {
+    std::vector<Segment> segments;
+    for (auto i : intervals) {
+        if (!i->is_overwrite_root())
+            continue;
+        size_t gid = m_groups.size(), height = 0;
+        for (auto j = i; j; j = j->overwrite_src()) {
+            auto offset = j->offset_in_overwrite_dest_root();
+            segments.push_back({j->time_begin, j->time_end, offset, j->size, gid});
+            update_max(height, offset + j->size);
+        }
+        m_groups.push_back({i, height});
+    }
+
+    std::sort(
+            segments.begin(), segments.end(),
+            [](const Segment& a, const Segment& b) {
+                return a.time_begin < b.time_begin;
+            });
+
+    // sweep over time to find segments of different groups that are alive at
+    // the same time; they must not overlap in address
+    m_conflicts.resize(m_groups.size());
+    size_t nr_conflict = 0;
+    std::vector<const Segment*> alive;
+    for (auto&& s : segments) {
+        auto t = s.time_begin;
+        alive.erase(
+                std::remove_if(
+                        alive.begin(), alive.end(),
+                        [t](const Segment* p) { return p->time_end <= t; }),
+                alive.end());
+
+        // lower bound: each group needs at least its largest alive segment
+        {
+            std::vector<std::pair<size_t, size_t>> group_size;
+            for (auto p : alive)
+                group_size.emplace_back(p->group, p->size);
+            group_size.emplace_back(s.group, s.size);
+            std::sort(group_size.begin(), group_size.end());
+            size_t usage = 0;
+            for (size_t i = 0; i < group_size.size(); ++i) {
+                if (i + 1 == group_size.size() ||
+                    group_size[i].first != group_size[i + 1].first)
+                    usage += group_size[i].second;
+            }
+            update_max(m_lower_bound, usage);
+        }
+
+        for (auto p : alive) {
+            if (p->group == s.group)
+                continue;
+            auto os = static_cast<int64_t>(s.offset),
+                 ss = static_cast<int64_t>(s.size),
+                 op = static_cast<int64_t>(p->offset),
+                 sp = static_cast<int64_t>(p->size);
+            m_conflicts[s.group].push_back({p->group, op - os - ss, op + sp - os});
+            m_conflicts[p->group].push_back({s.group, os - op - sp, os + ss - op});
+            if (++nr_conflict > MAX_NR_CONFLICT)
+                return false;
+        }
+        alive.push_back(&s);
+    }
+    return true;
+}
+
+int64_t StaticMemAllocOptimal::BranchAndBound::lowest_addr(size_t group) {
+    m_forbidden.clear();
+    for (auto&& c : m_conflicts[group]) {
+        auto a = m_addr[c.other];
+        if (a >= 0)
+            m_forbidden.emplace_back(a + c.lo, a + c.hi);
+    }
+    std::sort(m_forbidden.begin(), m_forbidden.end());
+    int64_t addr = 0;
+    for (auto&& i : m_forbidden) {
+        // intervals are sorted by begin, so none of the remaining ones could
+        // contain addr
+        if (i.first >= addr)
+            break;
+        if (i.second > addr)
+            addr = align(i.second);
+    }
+    return addr;
+}
+
+size_t StaticMemAllocOptimal::BranchAndBound::run(
+        size_t cur_peak, double time_limit) {
+    auto nr = m_groups.size();
+    m_best = cur_peak;
+    m_best_addr.resize(nr);
+    for (size_t i = 0; i < nr; ++i)
+        m_best_addr[i] = m_groups[i].root->addr_begin;
+    m_addr.assign(nr, -1);
+    m_mark.assign(nr, 0);
+    m_time_limit = time_limit;
+    m_timer.reset();
+
+    if (m_best > align(m_lower_bound))
+        dfs(0, 0, NONE);
+
+    if (m_best < cur_peak) {
+        for (size_t i = 0; i < nr; ++i) {
+            auto root = m_groups[i].root;
+            auto addr = static_cast<size_t>(m_best_addr[i]);
+            for (auto j = root; j; j = j->overwrite_src())
+                j->addr_begin = addr + j->offset_in_overwrite_dest_root();
+        }
+    }
+    return m_best;
+}
+
+void StaticMemAllocOptimal::BranchAndBound::dfs(
+        size_t depth, size_t peak, size_t last) {
+    ++m_nr_node;
+    if (m_timer.get_secs() > m_time_limit)
+        m_timeout = true;
+    if (m_timeout)
+        return;
+
+    auto nr = m_groups.size();
+    if (depth == nr) {
+        if (align(peak) < m_best) {
+            m_best = align(peak);
+            m_best_addr = m_addr;
+        }
+        return;
+    }
+
+    // the lowest feasible address of a group never decreases as more groups
+    // are placed, so it gives a lower bound of the peak in this subtree
+    m_cand_buf.clear();
+    size_t bound = peak;
+    for (size_t i = 0; i < nr; ++i) {
+        if (m_addr[i] < 0) {
+            auto addr = lowest_addr(i);
+            update_max(bound, static_cast<size_t>(addr) + m_groups[i].height);
+            m_cand_buf.emplace_back(addr, i);
+        }
+    }
+    if (align(bound) >= m_best)
+        return;
+
+    auto cmp = [this](const std::pair<int64_t, size_t>& a,
+                      const std::pair<int64_t, size_t>& b) {
+        if (a.first != b.first)
+            return a.first < b.first;
+        return m_groups[a.second].height > m_groups[b.second].height;
+    };
+    size_t width = m_cand_buf.size();
+    bool full_branch = nr <= FULL_BRANCH_MAX_NR_GROUP;
+    if (!full_branch)
+        width = std::min(width, LIMITED_BRANCH);
+    std::partial_sort(
+            m_cand_buf.begin(), m_cand_buf.begin() + width, m_cand_buf.end(), cmp);
+    std::vector<std::pair<int64_t, size_t>> cands(
+            m_cand_buf.begin(), m_cand_buf.begin() + width);
+
+    // placing two groups without conflict in either order gives the same
+    // plan, so only try them in increasing id order
+    auto stamp = ++m_mark_stamp;
+    if (full_branch && last != NONE) {
+        for (auto&& c : m_conflicts[last])
+            m_mark[c.other] = stamp;
+    }
+
+    for (auto&& i : cands) {
+        auto group = i.second;
+        if (full_branch && last != NONE && group < last && m_mark[group] != stamp)
+            continue;
+        auto new_peak =
+                std::max(peak, static_cast<size_t>(i.first) + m_groups[group].height);
+        if (align(new_peak) >= m_best)
+            continue;
+        m_addr[group] = i.first;
+        dfs(depth + 1, new_peak, group);
+        m_addr[group] = -1;
+        if (m_timeout || m_best <= align(m_lower_bound) || align(bound) >= m_best)
+            return;
+    }
+}
+
+void StaticMemAllocOptimal::do_solve() {
+    StaticMemAllocPushdown::do_solve();
+    m_peak = StaticMemAllocPushdown::tot_alloc();
+
+    BranchAndBound bnb{this};
+    if (!bnb.init(m_interval)) {
+        mgb_log_warn(
+                "too many conflicting intervals for optimal static memory "
+                "allocation; use pushdown result");
+        return;
+    }
+    RealTimer timer;
+    auto init_peak = m_peak;
+    m_peak = bnb.run(m_peak, m_time_limit);
+    mgb_log_debug(
+            "optimal static memory allocation: nr_group=%zu nr_node=%zu "
+            "time=%.3fs peak=%zu(pushdown %zu, lower bound %zu)",
+            bnb.nr_group(), bnb.nr_node(), timer.get_secs(), m_peak, init_peak,
+            bnb.lower_bound());
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
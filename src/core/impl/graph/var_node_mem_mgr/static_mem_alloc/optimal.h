@@ -0,0 +1,49 @@
+/**
+ * \file src/core/impl/graph/var_node_mem_mgr/static_mem_alloc/optimal.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "./pushdown.h"
+
+namespace mgb {
+namespace cg {
+
+/*!
+ * \brief branch-and-bound allocator for offline planning
+ *
+ * Starting from the pushdown result, search over the order in which
+ * intervals are placed, each at its lowest feasible address; an overwrite
+ * root and its overwriters are placed as a whole. Subtrees are pruned when
+ * the lowest feasible addresses of the remaining intervals can not beat the
+ * best plan so far, and the search stops when the lower bound is reached or
+ * the time limit is exceeded.
+ */
+class StaticMemAllocOptimal final : public StaticMemAllocPushdown {
+    class BranchAndBound;
+
+    double m_time_limit = 1;
+    size_t m_peak = 0;
+
+public:
+    void do_solve() override;
+
+    size_t tot_alloc() const override { return m_peak; }
+
+    StaticMemAlloc& time_limit(double seconds) override {
+        m_time_limit = seconds;
+        return *this;
+    }
+};
+
+}  // namespace cg
+}  // namespace mgb
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -16,7 +16,7 @@
 namespace mgb {
 namespace cg {
 
-class StaticMemAllocPushdown final : public StaticMemAllocImplHelper {
+class StaticMemAllocPushdown : public StaticMemAllocImplHelper {
     class BestfitPrealloc;
 
     size_t m_peak_usage = 0;
@@ -0,0 +1,304 @@
+/**
+ * \file src/core/impl/utils/tensor_codec.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/utils/tensor_codec.h"
+#include "megbrain/exception.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace mgb;
+using namespace tensor_codec;
+
+namespace {
+
+/* ============================= lz77 codec ============================= */
+
+//! a simple LZ77 codec in the spirit of LZ4 block format: each sequence is a
+//! token (4-bit literal length, 4-bit match length), literals, and a 16-bit
+//! match offset; the last sequence only contains literals
+namespace lz {
+constexpr size_t MIN_MATCH = 4, MAX_OFFSET = 65535, HASH_BITS = 16;
+constexpr uint32_t NONE = ~0u;
+
+void put_length(std::vector<uint8_t>& dst, size_t len) {
+    for (; len >= 255; len -= 255) {
+        dst.push_back(255);
+    }
+    dst.push_back(len);
+}
+
+void put_sequence(
+        std::vector<uint8_t>& dst, const uint8_t* literal, size_t nr_literal,
+        size_t offset, size_t match_len) {
+    size_t ml = match_len ? match_len - MIN_MATCH : 0;
+    dst.push_back((std::min<size_t>(nr_literal, 15) << 4) | std::min<size_t>(ml, 15));
+    if (nr_literal >= 15) {
+        put_length(dst, nr_literal - 15);
+    }
+    dst.insert(dst.end(), literal, literal + nr_literal);
+    if (match_len) {
+        dst.push_back(offset & 0xff);
+        dst.push_back(offset >> 8);
+        if (ml >= 15) {
+            put_length(dst, ml - 15);
+        }
+    }
+}
+
+void compress(const uint8_t* src, size_t size, std::vector<uint8_t>& dst) {
+    std::vector<uint32_t> table(1 << HASH_BITS, NONE);
+    size_t anchor = 0, pos = 0;
+    while (pos + MIN_MATCH <= size) {
+        uint32_t v;
+        memcpy(&v, src + pos, sizeof(v));
+        auto&& slot = table[(v * 2654435761u) >> (32 - HASH_BITS)];
+        size_t cand = slot;
+        slot = pos;
+        if (cand == NONE || pos - cand > MAX_OFFSET ||
+            memcmp(src + cand, src + pos, MIN_MATCH)) {
+            ++pos;
+            continue;
+        }
+        size_t len = MIN_MATCH;
+        while (pos + len < size && src[cand + len] == src[pos + len]) {
+            ++len;
+        }
+        put_sequence(dst, src + anchor, pos - anchor, pos - cand, len);
+        pos += len;
+        anchor = pos;
+    }
+    put_sequence(dst, src + anchor, size - anchor, 0, 0);
+}
+
+void decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dst_size) {
+    auto end = src + size;
+    auto dst_begin = dst, dst_end = dst + dst_size;
+    auto check = [](bool ok) {
+        mgb_throw_if(!ok, SerializationError, "corrupted compressed tensor value");
+    };
+    auto get_length = [&](size_t len) {
+        if (len == 15) {
+            uint8_t b;
+            do {
+                check(src < end);
+                b = *src++;
+                len += b;
+            } while (b == 255);
+        }
+        return len;
+    };
+    while (src < end) {
+        uint8_t token = *src++;
+        size_t nr_literal = get_length(token >> 4);
+        check(nr_literal <= size_t(end - src) && nr_literal <= size_t(dst_end - dst));
+        memcpy(dst, src, nr_literal);
+        src += nr_literal;
+        dst += nr_literal;
+        if (src == end) {
+            break;
+        }
+        check(end - src >= 2);
+        size_t offset = src[0] | (src[1] << 8);
+        src += 2;
+        size_t match_len = get_length(token & 15) + MIN_MATCH;
+        check(offset && offset <= size_t(dst - dst_begin) &&
+              match_len <= size_t(dst_end - dst));
+        // copy byte by byte since the match may overlap with the output
+        for (auto match = dst - offset; match_len; --match_len) {
+            *dst++ = *match++;
+        }
+    }
+    check(dst == dst_end);
+}
+}  // namespace lz
+
+//! element size used to group bytes for lossless compression
+size_t shuffle_unit(const DType& dtype) {
+    return dtype.is_low_bit() ? 1 : dtype.size();
+}
+
+/* ============================ per-method ============================ */
+
+bool encode_float16(const HostTensorND& src, std::vector<uint8_t>& dst) {
+#if MEGDNN_DISABLE_FLOAT16
+    MGB_MARK_USED_VAR(src);
+    MGB_MARK_USED_VAR(dst);
+    return false;
+#else
+    if (src.dtype() != dtype::Float32()) {
+        return false;
+    }
+    auto nr = src.shape().total_nr_elems();
+    auto ptr = src.ptr<float>();
+    dst.resize(nr * sizeof(dt_float16));
+    auto out = reinterpret_cast<dt_float16*>(dst.data());
+    for (size_t i = 0; i < nr; ++i) {
+        out[i] = static_cast<dt_float16>(ptr[i]);
+    }
+    return true;
+#endif
+}
+
+void decode_float16(const void* src, size_t size, size_t nr, float* dst) {
+#if MEGDNN_DISABLE_FLOAT16
+    MGB_MARK_USED_VAR(src);
+    MGB_MARK_USED_VAR(size);
+    MGB_MARK_USED_VAR(nr);
+    MGB_MARK_USED_VAR(dst);
+    mgb_throw(SerializationError, "float16 is disabled; can not decode tensor");
+#else
+    mgb_throw_if(
+            size != nr * sizeof(dt_float16), SerializationError,
+            "bad size of float16 tensor value: %zu", size);
+    auto in = static_cast<const dt_float16*>(src);
+    for (size_t i = 0; i < nr; ++i) {
+        dst[i] = static_cast<float>(in[i]);
+    }
+#endif
+}
+
+//! number of channels (i.e. slices along the first axis) for int8 encoding
+size_t nr_channel(const TensorShape& shape) {
+    return shape.ndim >= 2 && shape[0] ? shape[0] : 1;
+}
+
+bool encode_int8(const HostTensorND& src, std::vector<uint8_t>& dst) {
+    if (src.dtype() != dtype::Float32()) {
+        return false;
+    }
+    auto nr = src.shape().total_nr_elems(), nr_chan = nr_channel(src.shape()),
+         chan_size = nr / nr_chan;
+    // per-channel scales may outweigh the saving for small channels
+    if (nr_chan * sizeof(float) + nr >= nr * sizeof(float)) {
+        return false;
+    }
+    auto ptr = src.ptr<float>();
+    dst.resize(nr_chan * sizeof(float) + nr);
+    auto scales = reinterpret_cast<float*>(dst.data());
+    auto out = reinterpret_cast<int8_t*>(dst.data() + nr_chan * sizeof(float));
+    for (size_t c = 0; c < nr_chan; ++c) {
+        auto chan = ptr + c * chan_size;
+        float amax = 0;
+        for (size_t i = 0; i < chan_size; ++i) {
+            if (!std::isfinite(chan[i])) {
+                return false;
+            }
+            amax = std::max(amax, std::abs(chan[i]));
+        }
+        float scale = amax / 127.f, inv = scale ? 1.f / scale : 0.f;
+        scales[c] = scale;
+        for (size_t i = 0; i < chan_size; ++i) {
+            auto q = std::round(chan[i] * inv);
+            out[c * chan_size + i] = std::max(-127.f, std::min(127.f, q));
+        }
+    }
+    return true;
+}
+
+void decode_int8(const void* src, size_t size, const TensorShape& shape, float* dst) {
+    auto nr = shape.total_nr_elems(), nr_chan = nr_channel(shape),
+         chan_size = nr / nr_chan;
+    mgb_throw_if(
+            size != nr_chan * sizeof(float) + nr, SerializationError,
+            "bad size of int8 tensor value: %zu", size);
+    auto in = static_cast<const int8_t*>(src) + nr_chan * sizeof(float);
+    for (size_t c = 0; c < nr_chan; ++c) {
+        // the value blob may be unaligned
+        float scale;
+        memcpy(&scale, static_cast<const uint8_t*>(src) + c * sizeof(float),
+               sizeof(float));
+        for (size_t i = 0; i < chan_size; ++i) {
+            dst[c * chan_size + i] = in[c * chan_size + i] * scale;
+        }
+    }
+}
+
+bool encode_lossless(const HostTensorND& src, std::vector<uint8_t>& dst) {
+    auto size = src.layout().span().high_byte;
+    auto unit = shuffle_unit(src.dtype());
+    auto nr = size / unit;
+    auto ptr = reinterpret_cast<const uint8_t*>(src.raw_ptr());
+    std::vector<uint8_t> shuffled(size);
+    for (size_t i = 0; i < nr; ++i) {
+        for (size_t b = 0; b < unit; ++b) {
+            shuffled[b * nr + i] = ptr[i * unit + b];
+        }
+    }
+    dst.clear();
+    lz::compress(shuffled.data(), size, dst);
+    return dst.size() < size;
+}
+
+void decode_lossless(
+        const void* src, size_t size, const TensorLayout& layout, uint8_t* dst) {
+    auto dst_size = layout.span().high_byte;
+    auto unit = shuffle_unit(layout.dtype);
+    auto nr = dst_size / unit;
+    std::vector<uint8_t> shuffled(dst_size);
+    lz::decompress(static_cast<const uint8_t*>(src), size, shuffled.data(), dst_size);
+    for (size_t i = 0; i < nr; ++i) {
+        for (size_t b = 0; b < unit; ++b) {
+            dst[i * unit + b] = shuffled[b * nr + i];
+        }
+    }
+}
+
+}  // anonymous namespace
+
+bool tensor_codec::encode(
+        Method method, const HostTensorND& src, std::vector<uint8_t>& dst) {
+    mgb_assert(src.layout().is_contiguous());
+    switch (method) {
+        case Method::NONE:
+            return false;
+        case Method::FLOAT16:
+            return encode_float16(src, dst);
+        case Method::INT8_PER_CHANNEL:
+            return encode_int8(src, dst);
+        case Method::LOSSLESS:
+            return encode_lossless(src, dst);
+    }
+    mgb_throw(
+            SerializationError, "unknown tensor compression method: %d",
+            static_cast<int>(method));
+}
+
+void tensor_codec::decode(
+        Method method, const void* src, size_t size, const TensorLayout& layout,
+        void* dst) {
+    auto check_float32 = [&]() {
+        mgb_throw_if(
+                layout.dtype != dtype::Float32(), SerializationError,
+                "lossy compressed tensor must be float32, got %s",
+                layout.dtype.name());
+    };
+    switch (method) {
+        case Method::FLOAT16:
+            check_float32();
+            decode_float16(
+                    src, size, layout.total_nr_elems(), static_cast<float*>(dst));
+            return;
+        case Method::INT8_PER_CHANNEL:
+            check_float32();
+            decode_int8(src, size, layout, static_cast<float*>(dst));
+            return;
+        case Method::LOSSLESS:
+            decode_lossless(src, size, layout, static_cast<uint8_t*>(dst));
+            return;
+        default:
+            mgb_throw(
+                    SerializationError, "unknown tensor compression method: %d",
+                    static_cast<int>(method));
+    }
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -350,6 +350,16 @@ public:
     }
 
 #if !MGB_BUILD_SLIM_SERVING
+    //! statistics of free blocks cached by the memory allocator of a comp
+    //! node, which are not returned to the device yet
+    struct CachedFreeMem {
+        size_t tot = 0;      //!< total size of the free blocks
+        size_t largest = 0;  //!< size of the largest free block
+        size_t nr_blk = 0;   //!< number of free blocks
+    };
+
+    CachedFreeMem get_cached_free_mem() const { return m_impl->get_cached_free_mem(); }
+
     std::pair<size_t, size_t> get_free_left_and_right(
             size_t begin_ptr, size_t end_ptr) {
         return m_impl->get_free_left_and_right(begin_ptr, end_ptr);
@@ -577,6 +587,7 @@ protected:
         virtual size_t get_max_reserved_memory() { return 0; }
         virtual size_t get_max_used_memory() { return 0; }
         virtual size_t get_max_block_size_available() { return 0; }
+        virtual CachedFreeMem get_cached_free_mem() { return {}; }
         virtual size_t get_free_mem() { return get_mem_status_bytes().second; }
         virtual void reset_max_reserved_memory() {}
         virtual void reset_max_used_memory() {}
@@ -653,6 +664,20 @@ public:
     virtual void stop(const CompNode& comp_node) = 0;
 
     virtual void replay() = 0;
+
+    /*!
+     * \brief whether the recorded sequence can still be replayed after other
+     *      sequences have been executed on the comp node
+     *
+     * It is used for keeping sequences recorded for multiple input shapes
+     * (see ComputingGraph::Options::comp_node_seq_record_cache_bytes), and
+     * should return false if memory that may be accessed by the recorded
+     * kernels has been released since recording stopped.
+     */
+    virtual bool reusable() const { return false; }
+
+    //! approximate host memory in bytes used for the recorded sequence
+    virtual size_t recorded_bytes() const { return 0; }
 };
 
 /*!
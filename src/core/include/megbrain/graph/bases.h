@@ -26,11 +26,8 @@
 #define MGB_ENABLE_SUBLINEAR ((!MGB_BUILD_SLIM_SERVING) && (!!MGB_HAVE_THREAD))
 #endif  //  MGB_ENABLE_SUBLINEAR
 
-// FIXME: reopen when rewriting memory swap or existing tests are passed
-#define MGB_ENABLE_MEMORY_SWAP 0
 #ifndef MGB_ENABLE_MEMORY_SWAP
-#define MGB_ENABLE_MEMORY_SWAP \
-    ((!MGB_BUILD_SLIM_SERVING) && (!!MGB_HAVE_THREAD) && (MGB_CUDA))
+#define MGB_ENABLE_MEMORY_SWAP ((!MGB_BUILD_SLIM_SERVING) && (!!MGB_HAVE_THREAD))
 #endif  //  MGB_ENABLE_MEMORY_SWAP
 
 #ifndef MGB_ENABLE_PARTIAL_EXECUTION
@@ -46,7 +43,9 @@
 #define MGB_IF_COND_EXEC(x...)
 #endif
 
-#if MGB_CUDA && MGB_ENABLE_EXCEPTION
+// defragmenting on allocation failure is only enabled for CUDA, but live vars
+// can also be compacted between executions on CPU
+#if MGB_ENABLE_EXCEPTION
 #define MGB_ENABLE_VAR_DEV_MEM_DEFRAGMENTER 1
 #else
 #define MGB_ENABLE_VAR_DEV_MEM_DEFRAGMENTER 0
@@ -169,6 +168,45 @@ public:
     //! get the graph that owns this executable; nullptr if no owner graph
     virtual ComputingGraph* owner_graph() const = 0;
 
+    //! statistics of the static memory plan cache
+    struct StaticMemPlanCacheStat {
+        size_t nr_hit = 0, nr_miss = 0;
+        //! number of plans currently cached over all comp nodes
+        size_t nr_cached = 0;
+    };
+
+    /*!
+     * \brief get statistics of the cache of solved static memory plans
+     *
+     * See ComputingGraph::Options::SeqOpt::static_mem_plan_cache_size
+     */
+    virtual StaticMemPlanCacheStat get_static_mem_plan_cache_stat() const {
+        return {};
+    }
+
+    /*!
+     * \brief serialize the static memory plans in the plan cache
+     *
+     * The result can be given to load_static_mem_plan() of an executable
+     * compiled from the same graph, so the solver is skipped when the same
+     * allocation problem is seen again. Offsets are stored together with the
+     * whole problem description, so a stale plan is never used.
+     */
+    virtual std::string dump_static_mem_plan() const {
+        mgb_throw(MegBrainError, "dump_static_mem_plan() not supported");
+    }
+
+    /*!
+     * \brief load plans given by dump_static_mem_plan() into the plan cache
+     *
+     * This must be called before execution. Plans of comp nodes unused by
+     * this executable are ignored.
+     */
+    virtual void load_static_mem_plan(const std::string& buf) {
+        MGB_MARK_USED_VAR(buf);
+        mgb_throw(MegBrainError, "load_static_mem_plan() not supported");
+    }
+
     //! user data associated with a compiled executable
     UserDataContainer& user_data() { return m_user_data; }
 
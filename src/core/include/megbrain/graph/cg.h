@@ -326,6 +326,23 @@ public:
             //! whether to enable comp node optimization (e.g. using copy
             //! stream for I/O operators)
             bool enable_seq_comp_node_opt = true;
+
+            //! max number of solved static memory plans kept on each comp
+            //! node, so switching back to previously seen shapes does not
+            //! re-run the allocation solver; 0 to disable the cache
+            size_t static_mem_plan_cache_size = 8;
+
+            //! max number of static shape inference results kept for
+            //! different input shapes and values, so switching back to
+            //! previously seen inputs does not re-run shape inference;
+            //! 0 to disable the cache
+            size_t static_infer_cache_size = 8;
+
+            //! if positive, search for a better static memory plan than the
+            //! pushdown allocator gives, spending at most this many seconds
+            //! on each comp node; useful when the plan is dumped once (see
+            //! AsyncExecutable::dump_static_mem_plan) and reused at deployment
+            double static_mem_optimal_alloc_time = 0;
         } seq_opt;
 
         //! graph optimization options
@@ -446,6 +463,30 @@ public:
             int genetic_pool_size = 20;
             int lb_memory_mb = 0;
             int num_worker = sys::get_cpu_count() / 2;
+
+            /*!
+             * if positive, the plan with the least recompute cost whose
+             * memory bottleneck is within this budget is picked from the
+             * time/memory Pareto front of searched plans, rather than the
+             * plan with the least memory
+             */
+            int memory_budget_mb = 0;
+
+            /*!
+             * recompute cost of an opr, e.g. its time measured by fastrun
+             * or GraphProfiler; computation given by OprFootprint is used
+             * if it is empty
+             */
+            thin_function<double(OperatorNodeBase*)> opr_cost;
+
+            /*!
+             * whether to store searched plans in PersistentCache, keyed by
+             * the hash of the opr seq and the recompute cost of its oprs on
+             * each comp node, so the search can be skipped when the same
+             * graph is compiled again; plans are persisted to file if the
+             * cache is file-backed
+             */
+            bool enable_plan_cache = false;
         } sublinear_mem_config;
 
         //! whether to enable DTR memory optimization
@@ -457,6 +498,13 @@ public:
             size_t evictee_minimum_size = 1ULL << 20;
             double recomp_memory_factor = 1;
             double recomp_time_factor = 1;
+
+            /*!
+             * recompute time of an opr, e.g. its kernel time measured by
+             * GraphProfiler; estimated from the size of its inputs and
+             * outputs if it is empty
+             */
+            thin_function<double(OperatorNodeBase*)> opr_cost;
         } dtr_config;
 
         //! do not re-profile to select best impl algo when input shape
@@ -467,6 +515,15 @@ public:
         //! dynamic var fails
         bool enable_var_mem_defragment = true;
 
+        /*!
+         * if positive, dynamic memory is compacted (see
+         * ComputingGraph::compact_dynamic_memory()) when a compiled
+         * function is waited by the user and the fragmentation ratio (see
+         * MemFragmentation::ratio()) on any of its comp nodes exceeds
+         * this value; useful for long-running graphs with varying shapes
+         */
+        float dynamic_mem_compact_threshold = 0;
+
         //! whether to reshape grad var whose wrt shape is statically
         //! inferrable but its own shape is dynamic
         bool enable_grad_var_static_reshape = false;
@@ -505,6 +562,22 @@ public:
          */
         uint8_t comp_node_seq_record_level = 0;
 
+        /*!
+         * Max total bytes of recorded sequences to be kept for var memory
+         * layouts other than the current one when
+         * comp_node_seq_record_level is 1; 0 to disable.
+         *
+         * When input shapes change, the sequence recorded for the previous
+         * shapes is kept in a LRU cache, and it is directly replayed if
+         * the same shapes and var addresses are seen again, so a graph
+         * serving a few input shapes can always be replayed after warmup.
+         * Sequences are dropped once memory they might access is freed;
+         * currently only CPU comp nodes support this. Note that output
+         * callbacks are not invoked on replay, so their host buffers
+         * keep the layout of the last normal execution.
+         */
+        size_t comp_node_seq_record_cache_bytes = 0;
+
 #if !MGB_BUILD_SLIM_SERVING
         //! whether to evaulate var node values as they are inserted
         bool eager_evaluation = false;
@@ -603,6 +676,38 @@ public:
      */
     virtual size_t clear_device_memory() = 0;
 
+    //! fragmentation status of device memory on a comp node
+    struct MemFragmentation {
+        //! free memory cached by the allocator of the comp node
+        size_t free = 0;
+        size_t largest_free_block = 0;
+        size_t nr_free_block = 0;
+
+        //! size of live dynamic memory in this graph that can be moved by
+        //! compact_dynamic_memory()
+        size_t movable_dynamic = 0;
+
+        //! 1 - largest_free_block / free; 0 means no fragmentation
+        float ratio() const {
+            return free ? 1.f - static_cast<float>(largest_free_block) / free : 0.f;
+        }
+    };
+
+    //! get fragmentation status of device memory on given comp node
+    virtual MemFragmentation get_mem_fragmentation(CompNode cn) = 0;
+
+    /*!
+     * \brief move live dynamic vars together and return cached free
+     *      memory to the device
+     *
+     * This waits for the current execution to finish. Vars are only moved
+     * on CUDA and CPU, when Options::enable_var_mem_defragment is set and
+     * exceptions are enabled.
+     *
+     * \return total size of moved memory in bytes
+     */
+    virtual size_t compact_dynamic_memory() = 0;
+
     /*!
      * \brief set this graph as subgraph of another
      *
@@ -131,6 +131,25 @@ struct StaticMemAlloc {
     MGB_TYPEINFO_OBJ_DECL_WITH_EXPORT;
 };
 
+/*!
+ * \brief signaled after static shapes of a computing sequence are updated
+ *      before execution
+ */
+struct StaticInferUpdated {
+    ComputingGraph* graph;
+
+    //! host time spent on static inference, in seconds
+    double time;
+
+    //! number of inferred traits other than sources; 0 for cache hit
+    size_t nr_updated;
+
+    //! whether shapes come from SeqOpt::static_infer_cache_size cache
+    bool cache_hit;
+
+    MGB_TYPEINFO_OBJ_DECL_WITH_EXPORT;
+};
+
 /*!
  * \brief signaled after the order of oprs and comp nodes in a computing
  * sequence is determined
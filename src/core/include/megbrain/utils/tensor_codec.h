@@ -0,0 +1,62 @@
+/**
+ * \file src/core/include/megbrain/utils/tensor_codec.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#pragma once
+
+#include "megbrain/tensor.h"
+
+#include <vector>
+
+namespace mgb {
+/*!
+ * \brief codecs for compressing tensor values
+ *
+ * Used for tensor values in dumped graphs (see
+ * GraphDumpConfig::tensor_value_compression) and for swapped-out vars.
+ */
+namespace tensor_codec {
+
+//! the values are also stored in dumped graphs, so they must not be changed
+enum class Method : uint8_t {
+    NONE = 0,
+    //! float32 values stored as float16
+    FLOAT16 = 1,
+    //! float32 values stored as int8, with a float32 scale for each
+    //! slice along the first axis
+    INT8_PER_CHANNEL = 2,
+    //! lossless; bytes are grouped by their position in the element
+    //! and compressed by a built-in LZ77 codec
+    LOSSLESS = 3,
+};
+
+/*!
+ * \brief encode a contiguous tensor value with given method
+ * \param[out] dst encoded bytes
+ * \return false if the method is not applicable to this tensor, or the
+ *      encoded value would not be smaller than the raw value
+ */
+bool encode(Method method, const HostTensorND& src, std::vector<uint8_t>& dst);
+
+/*!
+ * \brief decode a value produced by encode()
+ *
+ * SerializationError is thrown if the value is malformed.
+ *
+ * \param layout contiguous layout of the original tensor
+ * \param dst buffer of layout.span().high_byte bytes
+ */
+void decode(
+        Method method, const void* src, size_t size, const TensorLayout& layout,
+        void* dst);
+
+}  // namespace tensor_codec
+}  // namespace mgb
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
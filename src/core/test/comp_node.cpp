@@ -892,4 +892,46 @@ TEST(TestCPUCompSeqRec, run_dyn_ptr) {
     }
 }
 
+TEST(TestCPUCompSeqRec, multi_shape_cache) {
+    CompNode cn = CompNode::load("cpux");
+    TensorShape small{2, 3}, large{64, 64};
+    auto host_x = std::make_shared<HostTensorND>(cn, large, dtype::Float32());
+
+    int iter = 0;
+    std::vector<int> executed;
+    auto graph = ComputingGraph::make();
+    graph->options().comp_node_seq_record_level = 1;
+    graph->options().comp_node_seq_record_cache_bytes = 1 << 20;
+    auto x = opr::Host2DeviceCopy::make(*graph, host_x),
+         y = opr::CallbackInjector::make(
+                 x * 2.f + 1.f, [&](DeviceTensorND&) { executed.push_back(iter); });
+    auto func = graph->compile({{y, [](DeviceTensorND&) {}}});
+
+    // the input buffer has been allocated for the large shape, so resizing
+    // it does not release memory accessed by recorded sequences
+    TensorShape shapes[] = {small, small, large, large, small,
+                            small, large, small, large, small};
+    for (; iter < 10; ++iter) {
+        host_x->resize(shapes[iter]);
+        auto px = host_x->ptr<float>();
+        for (size_t i = 0; i < host_x->shape().total_nr_elems(); ++i) {
+            px[i] = static_cast<float>(i % 7) - iter;
+        }
+        func->execute().wait();
+
+        // callbacks are not invoked on replay, so check the var directly
+        auto y_val = HostTensorND::make_proxy(y.node()->dev_tensor());
+        ASSERT_EQ(shapes[iter], y_val.shape()) << "iter " << iter;
+        auto py = y_val.ptr<float>();
+        for (size_t i = 0; i < y_val.shape().total_nr_elems(); ++i) {
+            ASSERT_EQ(px[i] * 2.f + 1.f, py[i]) << "iter " << iter;
+        }
+    }
+
+    // each shape is executed normally once and then recorded once, and
+    // later executions replay the cached sequences
+    std::vector<int> expect{0, 1, 2, 3, 4, 5};
+    ASSERT_EQ(expect, executed);
+}
+
 // vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
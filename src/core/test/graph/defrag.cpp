@@ -115,4 +115,47 @@ TEST(TestGraph, Defragment) {
 }
 #endif  // MGB_CUDA && MGB_ENABLE_EXCEPTION
 
+TEST(TestGraph, CompactDynamicMemory) {
+    auto cn = CompNode::load("xpux");
+    HostTensorGenerator<> gen;
+    auto host_x = gen({23, 42}, cn);
+    auto graph = ComputingGraph::make();
+    graph->options().force_dynamic_alloc = true;
+    graph->options().dynamic_mem_compact_threshold = 0.5;
+    graph->options().graph_opt_level = 0;
+    auto x = opr::Host2DeviceCopy::make(*graph, host_x),
+         t = x * 2 + 1, y = opr::reduce_sum(t, x.make_scalar(1));
+    // keep memory of t alive after execution so there is something to move
+    t.node()->add_flag(cg::VarNode::Flag::NO_MEM_RECLAIM);
+    HostTensorND host_y, expect;
+    auto func = graph->compile({make_callback_copy(y, host_y)});
+    for (int i = 0; i < 3; ++i) {
+        func->execute().wait();
+        if (!i) {
+            expect.copy_from(host_y);
+        }
+        MGB_ASSERT_TENSOR_EQ(expect, host_y);
+
+        auto frag = graph->get_mem_fragmentation(cn);
+        ASSERT_LE(frag.largest_free_block, frag.free);
+        ASSERT_GE(frag.ratio(), 0.f);
+        ASSERT_LE(frag.ratio(), 1.f);
+
+        HostTensorND t_before, t_after;
+        t_before.copy_from(t.node()->dev_tensor()).sync();
+        auto moved = graph->compact_dynamic_memory();
+#if MGB_ENABLE_VAR_DEV_MEM_DEFRAGMENTER
+        // t is the only live dynamic var, and it is moved with its value
+        ASSERT_GE(frag.movable_dynamic, host_x->layout().span().dist_byte());
+        ASSERT_GE(moved, frag.movable_dynamic);
+        ASSERT_TRUE(t.node()->dev_tensor_valid());
+        t_after.copy_from(t.node()->dev_tensor()).sync();
+        MGB_ASSERT_TENSOR_EQ(t_before, t_after);
+#else
+        ASSERT_EQ(0u, frag.movable_dynamic);
+        ASSERT_EQ(0u, moved);
+#endif
+    }
+}
+
 // vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
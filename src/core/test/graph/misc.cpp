@@ -1748,6 +1748,108 @@ TEST(TestGraph, UpdateStaticAllocPlan) {
     func->execute();
 }
 
+TEST(TestGraph, StaticMemPlanCache) {
+    auto run = [](size_t cache_size) {
+        HostTensorGenerator<> gen;
+        auto host_x = gen({2, 3});
+        auto graph = ComputingGraph::make();
+        graph->options().seq_opt.static_mem_plan_cache_size = cache_size;
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x),
+             y = (x + 1) * (x + 2) + x;
+        HostTensorND host_y;
+        auto func = graph->compile({make_callback_copy(y, host_y)});
+        for (size_t batch : {2, 5, 2, 5, 7, 2}) {
+            *host_x = *gen({batch, 3});
+            func->execute();
+            auto px = host_x->ptr<float>();
+            auto py = host_y.ptr<float>();
+            ASSERT_EQ(host_x->shape(), host_y.shape());
+            for (size_t i = 0; i < batch * 3; ++i) {
+                MGB_ASSERT_FLOAT_EQ((px[i] + 1) * (px[i] + 2) + px[i], py[i]);
+            }
+        }
+        return func->get_static_mem_plan_cache_stat();
+    };
+
+    auto stat = run(8);
+    ASSERT_EQ(3u, stat.nr_miss);
+    ASSERT_EQ(3u, stat.nr_hit);
+    ASSERT_EQ(3u, stat.nr_cached);
+
+    // 7 evicts the least recently used plan for 2, so the last run misses
+    stat = run(2);
+    ASSERT_EQ(4u, stat.nr_miss);
+    ASSERT_EQ(2u, stat.nr_hit);
+    ASSERT_EQ(2u, stat.nr_cached);
+
+    stat = run(0);
+    ASSERT_EQ(0u, stat.nr_miss);
+    ASSERT_EQ(0u, stat.nr_hit);
+}
+
+TEST(TestGraph, StaticMemPlanDumpLoad) {
+    HostTensorGenerator<> gen;
+    auto host_x = gen({2, 3});
+    auto run = [&](const std::string& plan) {
+        auto graph = ComputingGraph::make();
+        graph->options().seq_opt.static_mem_optimal_alloc_time = 0.1;
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x),
+             y = (x + 1) * (x + 2) + x;
+        HostTensorND host_y;
+        auto func = graph->compile({make_callback_copy(y, host_y)});
+        if (!plan.empty()) {
+            func->load_static_mem_plan(plan);
+        }
+        for (size_t batch : {2, 5}) {
+            *host_x = *gen({batch, 3});
+            func->execute();
+            auto px = host_x->ptr<float>();
+            auto py = host_y.ptr<float>();
+            for (size_t i = 0; i < batch * 3; ++i) {
+                MGB_ASSERT_FLOAT_EQ((px[i] + 1) * (px[i] + 2) + px[i], py[i]);
+            }
+        }
+        return std::make_pair(func->get_static_mem_plan_cache_stat(),
+                              func->dump_static_mem_plan());
+    };
+
+    auto first = run({});
+    ASSERT_EQ(2u, first.first.nr_miss);
+    auto second = run(first.second);
+    ASSERT_EQ(0u, second.first.nr_miss);
+    ASSERT_EQ(2u, second.first.nr_hit);
+    ASSERT_EQ(first.second.size(), second.second.size());
+
+    ASSERT_THROW(run("bad plan"), SerializationError);
+
+    // locate fields of the first plan: magic, comp node name, nr_plan, key,
+    // offsets, overwrite specs, size and size_lb
+    auto&& plan = first.second;
+    auto get = [&](size_t pos) {
+        uint64_t v;
+        memcpy(&v, plan.data() + pos, 8);
+        return v;
+    };
+    size_t key_pos = 8 + 8 + get(8) + 8,
+           offsets_pos = key_pos + 8 + get(key_pos) * 8,
+           overwrite_pos = offsets_pos + 8 + get(offsets_pos) * 8,
+           size_pos = overwrite_pos + 8 + get(overwrite_pos) * 8;
+    ASSERT_GT(get(offsets_pos), 0u);
+
+    // drop the last offset, so the key describes more chunks than offsets
+    auto bad_key = plan;
+    uint64_t nr_offsets = get(offsets_pos) - 1;
+    memcpy(&bad_key[offsets_pos], &nr_offsets, 8);
+    bad_key.erase(overwrite_pos - 8, 8);
+    ASSERT_THROW(run(bad_key), SerializationError);
+
+    // shrink the planned size, so chunks would be placed out of range
+    auto bad_size = plan;
+    uint64_t zero = 0;
+    memcpy(&bad_size[size_pos], &zero, 8);
+    ASSERT_THROW(run(bad_size), SerializationError);
+}
+
 TEST(TestGraph, CPUGPUHybrid) {
     REQUIRE_GPU(1);
     auto cn_gpu = CompNode::load("gpu0");
@@ -16,24 +16,39 @@
 #include "megbrain/opr/dnn/convolution.h"
 #include "megbrain/opr/io.h"
 
+#include "../impl/graph/swap/swap_helper.h"
+
 using namespace mgb;
 
 using Elemwise = opr::Elemwise;
 using Mode = Elemwise::Mode;
 #if MGB_ENABLE_MEMORY_SWAP
-auto run = [](const int flag) {
+auto run = [](const int flag, const char* compression = "0") {
     auto KEY = "MGB_MEMORY_SWAP_PARAM_BUCKET_IMPLEMENT";
     auto old_value = getenv(KEY);
     if (flag)
         setenv(KEY, "1", 1);
     else
         setenv(KEY, "0", 1);
+    auto COMPRESSION_KEY = "MGB_MEMORY_SWAP_PARAM_COMPRESSION";
+    setenv(COMPRESSION_KEY, compression, 1);
+
+    // a smaller network on CPU, with a lower size limit of swapped vars
+    auto cn = CompNode::load("xpu0");
+    bool on_cpu = cn.device_type() == CompNode::DeviceType::CPU;
+    auto SIZE_LB_KEY = "MGB_MEMORY_SWAP_PARAM_SWAP_OUT_VAR_SIZE_LB";
+    if (on_cpu) {
+        setenv(SIZE_LB_KEY, "16384", 1);
+    }
 
     HostTensorGenerator<> gen_;
 
-    auto gen = [&](const TensorShape& shp) { return gen_(shp, "gpu0"); };
-    constexpr size_t batch_size = 5, C = 8, H = 100, W = 128;
-    constexpr size_t limit = 200;
+    auto gen = [&](const TensorShape& shp) { return gen_(shp, cn); };
+    size_t batch_size = 5, C = 8, H = 100, W = 128, limit = 200, oc = 30,
+           kern = 5;
+    if (on_cpu) {
+        batch_size = 2, H = W = 32, limit = 20, oc = 8, kern = 3;
+    }
     auto host_data = gen({batch_size, C, H, W});
     auto graph = ComputingGraph::make();
 
@@ -61,7 +76,7 @@ auto run = [](const int flag) {
     };
 
     for (size_t i = 1; i <= limit; ++i)
-        add_layer(30, 5, 2);
+        add_layer(oc, kern, kern / 2);
 
     auto loss = opr::Dot::make(conv_res[limit].flatten(), conv_res[limit].flatten());
     std::vector<HostTensorND> grad_kernels_get(kernels.size());
@@ -88,18 +103,58 @@ auto run = [](const int flag) {
     } else {
         unsetenv(KEY);
     }
+    unsetenv(COMPRESSION_KEY);
+    if (on_cpu) {
+        unsetenv(SIZE_LB_KEY);
+    }
 };
 
 TEST(TestMemorySwap, FullConvSerial) {
-    REQUIRE_GPU(1);
     run(0);
 }
 
 TEST(TestMemorySwap, FullConvParallel) {
-    REQUIRE_GPU(1);
     run(0);
 }
 
+TEST(TestMemorySwap, FullConvParallelLossless) {
+    run(1, "1");
+}
+
+TEST(TestMemorySwap, SwappedValue) {
+    using swap::SwapCompression;
+    HostTensorGenerator<> gen;
+    auto cn = CompNode::load("cpu0");
+    auto host_x = gen({23, 45}, cn);
+    // repeated values to make lossless compression effective
+    for (size_t i = 0; i < 23 * 45; i += 3) {
+        host_x->ptr<float>()[i] = 1.f;
+    }
+    DeviceTensorND dev_x, dev_y;
+    dev_x.copy_from(*host_x);
+    dev_y.comp_node(cn).dtype(dtype::Float32()).resize(host_x->shape());
+    size_t raw_bytes = host_x->layout().span().dist_byte();
+    for (auto method :
+         {SwapCompression::NONE, SwapCompression::LOSSLESS, SwapCompression::FLOAT16,
+          SwapCompression::BFLOAT16}) {
+        swap::SwappedValue value;
+        HostTensorND staging, host_y;
+        value.store(dev_x, method, staging);
+        ASSERT_EQ(method != SwapCompression::NONE, value.compressed());
+        if (method == SwapCompression::NONE || method == SwapCompression::LOSSLESS) {
+            value.load(dev_y, staging);
+            MGB_ASSERT_TENSOR_EQ(*host_x, host_y.copy_from(dev_y).sync());
+        } else {
+            ASSERT_EQ(raw_bytes / 2, value.nr_bytes());
+            value.load(dev_y, staging);
+            MGB_ASSERT_TENSOR_NEAR(*host_x, host_y.copy_from(dev_y).sync(), 1e-2);
+        }
+        if (method == SwapCompression::LOSSLESS) {
+            ASSERT_LT(value.nr_bytes(), raw_bytes);
+        }
+    }
+}
+
 #endif  // MGB_ENABLE_MEMORY_SWAP
 
 // vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
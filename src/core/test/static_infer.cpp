@@ -9,6 +9,7 @@
  * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
  */
 
+#include "megbrain/graph/event.h"
 #include "megbrain/opr/basic_arith_wrapper.h"
 #include "megbrain/opr/io.h"
 #include "megbrain/opr/tensor_manip.h"
@@ -410,4 +411,99 @@ TEST(TestStaticInfer, NeedSharedDeviceTensorHostValueCrossCN) {
     ASSERT_EQ(1u, host_out.shape().ndim);
     MGB_ASSERT_FLOAT_EQ(0.0f, host_out.ptr<float>()[0]);
 }
+
+TEST(TestStaticInfer, IncrementalAndCache) {
+    HostTensorGenerator<> gen;
+    auto host_x0 = gen({2, 3}), host_x1 = gen({4});
+    auto graph = ComputingGraph::make();
+    auto x0 = opr::Host2DeviceCopy::make(*graph, host_x0),
+         x1 = opr::Host2DeviceCopy::make(*graph, host_x1);
+    // two independent chains
+    auto y0 = ((x0 + 1) * 2).flatten(), y1 = (x1 - 1).reshape(x1.symshape() * 1);
+
+    size_t nr_updated = 0, nr_hit = 0, nr_event = 0;
+    auto on_infer = [&](const cg::event::StaticInferUpdated& ev) {
+        ++nr_event;
+        nr_updated += ev.nr_updated;
+        nr_hit += ev.cache_hit;
+    };
+    auto handle =
+            graph->event().register_receiver<cg::event::StaticInferUpdated>(on_infer);
+    auto reset = [&]() { nr_updated = nr_hit = nr_event = 0; };
+
+    HostTensorND host_y0, host_y1;
+    auto func = graph->compile(
+            {make_callback_copy(y0, host_y0), make_callback_copy(y1, host_y1)});
+    auto check = [&]() {
+        ASSERT_EQ(TensorShape{host_x0->shape().total_nr_elems()}, host_y0.shape());
+        ASSERT_EQ(host_x1->shape(), host_y1.shape());
+        auto px = host_x0->ptr<float>(), py = host_y0.ptr<float>();
+        for (size_t i = 0; i < host_y0.shape().total_nr_elems(); ++i) {
+            MGB_ASSERT_FLOAT_EQ((px[i] + 1) * 2, py[i]);
+        }
+    };
+
+    func->execute();
+    check();
+    ASSERT_GT(nr_event, 0u);
+    auto nr_total = nr_updated;
+    ASSERT_GT(nr_total, 0u);
+
+    // unchanged inputs
+    reset();
+    func->execute();
+    check();
+    ASSERT_EQ(0u, nr_updated);
+
+    // only the cone of x0 is updated
+    reset();
+    *host_x0 = *gen({3, 5});
+    func->execute();
+    check();
+    ASSERT_GT(nr_updated, 0u);
+    ASSERT_LT(nr_updated, nr_total);
+    ASSERT_EQ(0u, nr_hit);
+
+    // previously seen shapes hit the cache
+    reset();
+    *host_x0 = *gen({2, 3});
+    func->execute();
+    check();
+    ASSERT_EQ(1u, nr_hit);
+    ASSERT_EQ(0u, nr_updated);
+
+    reset();
+    *host_x0 = *gen({3, 5});
+    *host_x1 = *gen({7});
+    func->execute();
+    check();
+    ASSERT_EQ(0u, nr_hit);
+
+    // same as the third execution
+    reset();
+    *host_x1 = *gen({4});
+    func->execute();
+    check();
+    ASSERT_EQ(1u, nr_hit);
+
+    // both inputs match the first execution
+    reset();
+    *host_x0 = *gen({2, 3});
+    func->execute();
+    check();
+    ASSERT_EQ(1u, nr_hit);
+
+    // the cache can be disabled
+    graph->options().seq_opt.static_infer_cache_size = 0;
+    func = graph->compile(
+            {make_callback_copy(y0, host_y0), make_callback_copy(y1, host_y1)});
+    func->execute();
+    reset();
+    *host_x0 = *gen({3, 5});
+    func->execute();
+    *host_x0 = *gen({2, 3});
+    func->execute();
+    check();
+    ASSERT_EQ(0u, nr_hit);
+}
 // vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -14,6 +14,7 @@
 #include "megbrain/utils/arith_helper.h"
 #include "megbrain/utils/timer.h"
 
+#include <array>
 #include <random>
 
 using namespace mgb;
@@ -24,7 +25,7 @@ using namespace cg;
         "static_mem_alloc disabled because it causes the program to crash at startup"
 #else
 
-#define ITER_ALGO(cb) cb(INTERVAL_MOVE) cb(BEST_FIT) cb(PUSHDOWN)
+#define ITER_ALGO(cb) cb(INTERVAL_MOVE) cb(BEST_FIT) cb(PUSHDOWN) cb(OPTIMAL)
 
 namespace {
 
@@ -86,6 +87,7 @@ public:
         m_allocator = StaticMemAlloc::make(GetParam().algo);
         m_allocator->alignment(GetParam().align);
         m_allocator->padding(GetParam().padding);
+        m_allocator->time_limit(0.1);
     }
 };
 
@@ -233,6 +235,29 @@ TEST(TestStaticMemAllocAlgo, PushdownChain) {
     ASSERT_EQ(NR + NR - 1, allocator->tot_alloc());
 }
 
+TEST(TestStaticMemAllocAlgo, OptimalNotWorseThanPushdown) {
+    using Algo = StaticMemAlloc::AllocatorAlgo;
+    std::mt19937_64 rng(next_rand_seed());
+    for (size_t nr : {8, 20, 40}) {
+        std::vector<std::array<size_t, 3>> reqs;
+        for (size_t i = 0; i < nr; ++i) {
+            size_t begin = rng() % nr, end = begin + 1 + rng() % (nr / 2),
+                   size = 1 + rng() % 4096;
+            reqs.push_back({begin, end, size});
+        }
+        size_t tot[2];
+        for (auto algo : {Algo::PUSHDOWN, Algo::OPTIMAL}) {
+            auto allocator = StaticMemAlloc::make(algo);
+            allocator->alignment(64).time_limit(0.2);
+            for (size_t i = 0; i < nr; ++i)
+                allocator->add(reqs[i][0], reqs[i][1], reqs[i][2], makeuk(i));
+            allocator->solve();
+            tot[algo == Algo::OPTIMAL] = allocator->tot_alloc();
+        }
+        ASSERT_LE(tot[1], tot[0]) << "nr=" << nr;
+    }
+}
+
 #endif  // WIN32
 
 // vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
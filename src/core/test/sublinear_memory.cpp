@@ -19,6 +19,7 @@
 #include "megbrain/opr/utility.h"
 #include "megbrain/serialization/sereg.h"
 #include "megbrain/test/helper.h"
+#include "megbrain/utils/persistent_cache.h"
 
 using namespace mgb;
 
@@ -30,6 +31,13 @@ namespace cg {
 class SeqModifierForSublinearMemory {
 public:
     const CompNode::UnorderedMap<size_t>& prev_min_bottleneck();
+    const CompNode::UnorderedMap<size_t>& prev_bottleneck();
+
+    struct PlanCost {
+        size_t bottleneck;
+        double recompute;
+    };
+    const CompNode::UnorderedMap<std::vector<PlanCost>>& prev_pareto_front();
 };
 
 class ComputingGraphImpl : public ComputingGraph {
@@ -574,6 +582,210 @@ TEST(TestSublinearMemory, BadOpr) {
     }
 }
 
+namespace {
+//! grads of params in a chain of elementwise oprs
+class ChainGrads {
+    static constexpr size_t NR_LAYER = 16;
+    HostTensorGenerator<> m_gen;
+    std::shared_ptr<HostTensorND> m_host_x;
+    std::vector<std::shared_ptr<HostTensorND>> m_host_params;
+
+public:
+    std::shared_ptr<ComputingGraph> graph;
+    std::unique_ptr<cg::AsyncExecutable> func;
+    std::vector<HostTensorND> grads;
+
+    //! \param size number of elements of each var in the chain
+    explicit ChainGrads(size_t size = 1024) : m_host_x{m_gen({size})} {
+        for (size_t i = 0; i < NR_LAYER; ++i) {
+            m_host_params.push_back(m_gen({size}));
+        }
+    }
+
+    //! build the graph with given sublinear config and execute it; grads
+    //! are stored in new tensors
+    void run(
+            bool sublinear,
+            const ComputingGraph::Options::SublinearMemConfig& config = {}) {
+        run([&](ComputingGraph::Options& options) {
+            options.enable_sublinear_memory_opt = sublinear;
+            options.sublinear_mem_config = config;
+        });
+    }
+
+    void run_dtr(const ComputingGraph::Options::DTRConfig& config) {
+        run([&](ComputingGraph::Options& options) {
+            options.enable_dtr_memory_opt = true;
+            options.dtr_config = config;
+        });
+    }
+
+    void run(thin_function<void(ComputingGraph::Options&)> set_options) {
+        grads = std::vector<HostTensorND>(NR_LAYER);
+        graph = ComputingGraph::make();
+        graph->options().graph_opt_level = 0;
+        set_options(graph->options());
+        auto y = opr::Host2DeviceCopy::make_no_fwd(*graph, m_host_x);
+        SymbolVarArray params;
+        for (auto&& i : m_host_params) {
+            params.push_back(opr::SharedDeviceTensor::make(*graph, *i));
+            y = y * params.back() + 1.f;
+        }
+        auto loss = opr::reduce_sum(y * y, y.make_scalar(1));
+        ComputingGraph::OutputSpec out_spec;
+        for (size_t i = 0; i < NR_LAYER; ++i) {
+            out_spec.push_back(make_callback_copy(cg::grad(loss, params[i]), grads[i]));
+        }
+        func = graph->compile(out_spec);
+        func->execute();
+    }
+
+    cg::SeqModifierForSublinearMemory& seq_modifier() const {
+        return static_cast<cg::ComputingGraphImpl*>(graph.get())
+                ->seq_modifier_for_sublinear_memory();
+    }
+
+    size_t bottleneck() const {
+        return seq_modifier().prev_min_bottleneck().at(m_host_x->comp_node());
+    }
+
+    //! bottleneck of the plan actually applied
+    size_t applied_bottleneck() const {
+        return seq_modifier().prev_bottleneck().at(m_host_x->comp_node());
+    }
+
+    std::vector<cg::SeqModifierForSublinearMemory::PlanCost> pareto_front() const {
+        return seq_modifier().prev_pareto_front().at(m_host_x->comp_node());
+    }
+
+    size_t nr_opr() const {
+        size_t nr = 0;
+        func->iter_opr_seq([&nr](cg::OperatorNodeBase*) {
+            ++nr;
+            return true;
+        });
+        return nr;
+    }
+};
+}  // anonymous namespace
+
+TEST(TestSublinearMemory, PlanCache) {
+    class CountingCache final : public PersistentCache {
+        std::shared_ptr<PersistentCache> m_impl =
+                std::make_shared<InMemoryPersistentCache>();
+
+    public:
+        std::atomic_size_t nr_hit{0}, nr_put{0};
+
+        Maybe<Blob> get(const std::string& category, const Blob& key) override {
+            auto ret = m_impl->get(category, key);
+            if (ret.valid() && category == "sublinear_memory_plan") {
+                ++nr_hit;
+            }
+            return ret;
+        }
+
+        void put(const std::string& category, const Blob& key,
+                 const Blob& value) override {
+            if (category == "sublinear_memory_plan") {
+                ++nr_put;
+            }
+            m_impl->put(category, key, value);
+        }
+    };
+    auto cache = std::make_shared<CountingCache>();
+    auto old_cache = PersistentCache::set_impl(cache);
+
+    ChainGrads chain;
+    chain.run(false);
+    auto expect = chain.grads;
+
+    ComputingGraph::Options::SublinearMemConfig config;
+    config.enable_plan_cache = true;
+    chain.run(true, config);
+    auto bottleneck = chain.bottleneck();
+    ASSERT_EQ(0u, cache->nr_hit.load());
+    ASSERT_EQ(1u, cache->nr_put.load());
+    for (size_t i = 0; i < expect.size(); ++i) {
+        MGB_ASSERT_TENSOR_EQ(expect[i], chain.grads[i]);
+    }
+
+    // the plan searched by the first graph is reused by an identical graph
+    chain.run(true, config);
+    ASSERT_EQ(1u, cache->nr_hit.load());
+    ASSERT_EQ(1u, cache->nr_put.load());
+    ASSERT_EQ(bottleneck, chain.bottleneck());
+    for (size_t i = 0; i < expect.size(); ++i) {
+        MGB_ASSERT_TENSOR_EQ(expect[i], chain.grads[i]);
+    }
+    PersistentCache::set_impl(old_cache);
+}
+
+TEST(TestSublinearMemory, MemoryBudget) {
+    // each var takes 1MiB so that plans differ by whole MiBs
+    ChainGrads chain{1 << 18};
+    ComputingGraph::Options::SublinearMemConfig config;
+    // recompute cost is the number of duplicated oprs
+    config.opr_cost = [](cg::OperatorNodeBase*) { return 1.; };
+    chain.run(true, config);
+    auto expect = chain.grads;
+    auto nr_opr_min_mem = chain.nr_opr();
+    auto min_bottleneck = chain.bottleneck();
+    ASSERT_EQ(min_bottleneck, chain.applied_bottleneck());
+
+    // pick a budget below the bottleneck of the plan with least recompute
+    // cost on the Pareto front, so that the budget has to be respected
+    auto front = chain.pareto_front();
+    ASSERT_GE(front.size(), 2u);
+    auto to_mb = [](size_t bytes) {
+        return static_cast<int>((bytes + (1 << 20) - 1) >> 20);
+    };
+    int budget_mb = 0;
+    for (size_t i = front.size() - 1; i--;) {
+        auto mb = to_mb(front[i].bottleneck);
+        if (static_cast<size_t>(mb) << 20 < front.back().bottleneck) {
+            budget_mb = mb;
+            break;
+        }
+    }
+    ASSERT_GT(budget_mb, 0);
+
+    config.memory_budget_mb = budget_mb;
+    chain.run(true, config);
+    ASSERT_LE(chain.applied_bottleneck(), static_cast<size_t>(budget_mb) << 20);
+    ASSERT_GE(chain.applied_bottleneck(), chain.bottleneck());
+    ASSERT_LE(chain.nr_opr(), nr_opr_min_mem);
+    for (size_t i = 0; i < expect.size(); ++i) {
+        MGB_ASSERT_TENSOR_EQ(expect[i], chain.grads[i]);
+    }
+
+    // a budget that fits every plan selects the one with least recompute
+    config.memory_budget_mb = to_mb(front.back().bottleneck);
+    chain.run(true, config);
+    ASSERT_LE(chain.applied_bottleneck(), front.back().bottleneck);
+    ASSERT_LE(chain.nr_opr(), nr_opr_min_mem);
+}
+
+TEST(TestSublinearMemory, DTROprCost) {
+    ChainGrads chain;
+    chain.run(false);
+    auto expect = chain.grads;
+
+    ComputingGraph::Options::DTRConfig config;
+    config.eviction_threshold = 64 * 1024;
+    config.evictee_minimum_size = 0;
+    size_t nr_call = 0;
+    config.opr_cost = [&nr_call](cg::OperatorNodeBase*) {
+        ++nr_call;
+        return 1.;
+    };
+    chain.run_dtr(config);
+    ASSERT_GT(nr_call, 0u);
+    for (size_t i = 0; i < expect.size(); ++i) {
+        MGB_ASSERT_TENSOR_EQ(expect[i], chain.grads[i]);
+    }
+}
+
 #else
 #pragma message "tests are disabled as Sublinear is not enabled."
 #endif  // MGB_ENABLE_SUBLINEAR
@@ -242,6 +242,57 @@ size_t IndexingSetOneHot::get_workspace_size_bytes(
             {input_shapes[2], input(2)->dtype()});
 }
 
+/* ==================== EmbeddingBag ==================== */
+namespace {
+void check_embedding_bag_index_dtype(const cg::OperatorNodeBase& opr) {
+    mgb_throw_if(
+            opr.input(1)->dtype() != dtype::Int32() ||
+                    opr.input(2)->dtype() != dtype::Int32(),
+            GraphError, "%s requires index and offsets to be int32, got %s and %s",
+            opr.cname(), opr.input(1)->dtype().name(), opr.input(2)->dtype().name());
+}
+}  // anonymous namespace
+
+MGB_DYN_TYPE_OBJ_FINAL_IMPL(EmbeddingBag);
+MEGDNN_OPR_INIT3(EmbeddingBag, "embedding_bag")
+
+void EmbeddingBag::init_output_dtype() {
+    check_embedding_bag_index_dtype(*this);
+    output(0)->dtype(input(0)->dtype());
+}
+
+#if MGB_ENABLE_GRAD
+MGB_IMPL_OPR_GRAD(EmbeddingBag) {
+    if (wrt_idx != 0) {
+        return InvalidGrad::make(opr, wrt_idx);
+    }
+    // scatter the per-index rows into a zero table; duplicated indices are
+    // accumulated by IndexingIncrMultiAxisVec
+    SymbolVar weight{opr.input(0)}, index{opr.input(1)};
+    auto rows = EmbeddingBagBackward::make(
+            out_grad[0], index, opr.input(2), opr.param());
+    return IndexingIncrMultiAxisVec::make(
+                   weight.fill_retain_dtype(0), rows,
+                   {indexing::AxisIndexer::make_index(0, index)})
+            .node();
+}
+#endif
+
+/* ==================== EmbeddingBagBackward ==================== */
+MGB_DYN_TYPE_OBJ_FINAL_IMPL(EmbeddingBagBackward);
+MEGDNN_OPR_INIT3(EmbeddingBagBackward, "embedding_bag_bwd")
+
+void EmbeddingBagBackward::init_output_dtype() {
+    check_embedding_bag_index_dtype(*this);
+    output(0)->dtype(input(0)->dtype());
+}
+
+#if MGB_ENABLE_GRAD
+MGB_IMPL_OPR_GRAD(EmbeddingBagBackward) {
+    return InvalidGrad::make(opr, wrt_idx);
+}
+#endif
+
 /* ==================== IndexingRemap ==================== */
 MGB_DYN_TYPE_OBJ_FINAL_IMPL(IndexingRemap);
 MEGDNN_OPR_INIT2(IndexingRemap, "indexing_remap")
@@ -27,6 +27,8 @@ namespace mgb {
 namespace opr {
 MGB_SEREG_OPR(Diag, 1);
 MGB_SEREG_OPR(DiagBackward, 2);
+MGB_SEREG_OPR(EmbeddingBag, 3);
+MGB_SEREG_OPR(EmbeddingBagBackward, 3);
 MGB_SEREG_OPR(IndexingOneHot, 2);
 MGB_SEREG_OPR(IndexingRemap, 2);
 MGB_SEREG_OPR(IndexingRemapBackward, 3);
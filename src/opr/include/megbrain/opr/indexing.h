@@ -90,6 +90,51 @@ private:
             const TensorShapeArray& output_shapes) const override;
 };
 
+/*!
+ * \brief fused gather and per-bag sum/mean over rows of an embedding table
+ *
+ * See megdnn::EmbeddingBagForward for the semantics of the inputs. The
+ * gradient w.r.t. weight is the output of EmbeddingBagBackward scattered into
+ * a zero table; index and offsets have no gradient.
+ */
+MGB_DEFINE_OPR_CLASS(
+        EmbeddingBag, intl::MegDNNOprWrapperFwd<megdnn::EmbeddingBagForward>) // {
+public:
+    MGE_WIN_DECLSPEC_FUC EmbeddingBag(
+            VarNode* weight, VarNode* index, VarNode* offsets, const Param& param,
+            const OperatorNodeConfig& config);
+    MGE_WIN_DECLSPEC_FUC static SymbolVar make(
+            SymbolVar weight, SymbolVar index, SymbolVar offsets, const Param& param,
+            const OperatorNodeConfig& config = {});
+
+private:
+    void init_output_dtype() override;
+};
+
+/*!
+ * \brief sparse gradient of EmbeddingBag: one row per looked up index
+ *
+ * The output together with the index input is an (indices, rows)
+ * representation of the table gradient. An optimizer applies it row by row
+ * with IndexingIncrMultiAxisVec on the table itself, e.g.
+ * IndexingIncrMultiAxisVec::make(weight, rows * (-lr), {make_index(0, index)}),
+ * so no dense gradient of the whole table is allocated.
+ */
+MGB_DEFINE_OPR_CLASS(
+        EmbeddingBagBackward,
+        intl::MegDNNOprWrapperFwd<megdnn::EmbeddingBagBackward>) // {
+public:
+    MGE_WIN_DECLSPEC_FUC EmbeddingBagBackward(
+            VarNode* diff, VarNode* index, VarNode* offsets, const Param& param,
+            const OperatorNodeConfig& config);
+    MGE_WIN_DECLSPEC_FUC static SymbolVar make(
+            SymbolVar diff, SymbolVar index, SymbolVar offsets, const Param& param,
+            const OperatorNodeConfig& config = {});
+
+private:
+    void init_output_dtype() override;
+};
+
 MGB_DEFINE_OPR_CLASS(
         IndexingRemap, intl::MegDNNOprWrapperFwd<megdnn::IndexingRemap>) // {
 public:
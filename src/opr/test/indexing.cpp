@@ -206,6 +206,108 @@ TEST(TestOprIndexing, OneHot5D) {
         test_one_hot(i, cases);
 }
 
+TEST(TestOprIndexing, EmbeddingBag) {
+    constexpr size_t NUM = 10, DIM = 5;
+    std::vector<int> index_val{3, 1, 3, 7, 0, 9, 2}, offsets_val{0, 3, 3, 5};
+    size_t nnz = index_val.size(), nr_bags = offsets_val.size();
+    HostTensorGenerator<> gen;
+    auto host_weight = gen({NUM, DIM}), host_coef = gen({nr_bags, DIM});
+    auto cn = host_weight->comp_node();
+    auto host_index =
+                 std::make_shared<HostTensorND>(cn, TensorShape{nnz}, dtype::Int32()),
+         host_offsets = std::make_shared<HostTensorND>(
+                 cn, TensorShape{nr_bags}, dtype::Int32());
+    std::copy(index_val.begin(), index_val.end(), host_index->ptr<int>());
+    std::copy(offsets_val.begin(), offsets_val.end(), host_offsets->ptr<int>());
+
+    using Mode = opr::EmbeddingBag::Param::Mode;
+    for (auto mode : {Mode::SUM, Mode::MEAN}) {
+        auto graph = ComputingGraph::make();
+        auto weight = opr::Host2DeviceCopy::make(*graph, host_weight),
+             index = opr::Host2DeviceCopy::make(*graph, host_index),
+             offsets = opr::Host2DeviceCopy::make(*graph, host_offsets),
+             coef = opr::Host2DeviceCopy::make(*graph, host_coef),
+             y = opr::EmbeddingBag::make(weight, index, offsets, {mode}),
+             // the gradient of sum(y * coef) is coef; apply the sparse rows
+             // to the table row by row
+             rows = opr::EmbeddingBagBackward::make(coef, index, offsets, {mode}),
+             updated = opr::IndexingIncrMultiAxisVec::make(
+                     weight, rows, {opr::indexing::AxisIndexer::make_index(0, index)});
+        HostTensorND host_y, host_rows, host_updated;
+        auto func = graph->compile(
+                {make_callback_copy(y, host_y), make_callback_copy(rows, host_rows),
+                 make_callback_copy(updated, host_updated)});
+        func->execute();
+        ASSERT_EQ(TensorShape({nr_bags, DIM}), host_y.shape());
+        ASSERT_EQ(TensorShape({nnz, DIM}), host_rows.shape());
+        ASSERT_EQ(TensorShape({NUM, DIM}), host_updated.shape());
+
+        HostTensorND expect_y{cn, {nr_bags, DIM}}, expect_updated{cn, {NUM, DIM}};
+        auto pw = host_weight->ptr<float>(), pc = host_coef->ptr<float>(),
+             py = expect_y.ptr<float>(), pg = expect_updated.ptr<float>();
+        memset(py, 0, sizeof(float) * nr_bags * DIM);
+        memcpy(pg, pw, sizeof(float) * NUM * DIM);
+        for (size_t bag = 0; bag < nr_bags; ++bag) {
+            size_t begin = offsets_val[bag],
+                   end = bag + 1 < nr_bags ? offsets_val[bag + 1] : nnz;
+            float scale = mode == Mode::MEAN && end > begin ? 1.f / (end - begin) : 1.f;
+            for (size_t j = begin; j < end; ++j) {
+                for (size_t c = 0; c < DIM; ++c) {
+                    py[bag * DIM + c] += pw[index_val[j] * DIM + c] * scale;
+                    pg[index_val[j] * DIM + c] += pc[bag * DIM + c] * scale;
+                }
+            }
+        }
+        MGB_ASSERT_TENSOR_NEAR(expect_y, host_y, 1e-5);
+        MGB_ASSERT_TENSOR_NEAR(expect_updated, host_updated, 1e-5);
+    }
+}
+
+TEST(TestOprIndexing, EmbeddingBagGrad) {
+    using Checker = AutoOprChecker<1, 1>;
+    using Mode = opr::EmbeddingBag::Param::Mode;
+    constexpr size_t NUM = 6;
+    std::vector<int> index_val{3, 1, 3, 5, 0, 3}, offsets_val{0, 3, 3, 4};
+    size_t nnz = index_val.size(), nr_bags = offsets_val.size();
+    HostTensorND host_index{CompNode::load("xpu0"), {nnz}, dtype::Int32()},
+            host_offsets{CompNode::load("xpu0"), {nr_bags}, dtype::Int32()};
+    std::copy(index_val.begin(), index_val.end(), host_index.ptr<int>());
+    std::copy(offsets_val.begin(), offsets_val.end(), host_offsets.ptr<int>());
+
+    for (auto mode : {Mode::SUM, Mode::MEAN}) {
+        auto make_graph =
+                [&](const Checker::SymInpArray& inputs) -> Checker::SymOutArray {
+            auto&& graph = *inputs[0].node()->owner_graph();
+            auto index = opr::ImmutableTensor::make(graph, host_index),
+                 offsets = opr::ImmutableTensor::make(graph, host_offsets);
+            return {opr::EmbeddingBag::make(inputs[0], index, offsets, {mode})};
+        };
+
+        auto fwd = [&](Checker::NumOutArray& dest, Checker::NumInpArray inp) {
+            size_t dim = inp[0]->shape(1);
+            auto pw = inp[0]->ptr<float>();
+            auto py = dest[0].comp_node(inp[0]->comp_node())
+                              .resize({nr_bags, dim})
+                              .ptr<float>();
+            memset(py, 0, sizeof(float) * nr_bags * dim);
+            for (size_t bag = 0; bag < nr_bags; ++bag) {
+                size_t begin = offsets_val[bag],
+                       end = bag + 1 < nr_bags ? offsets_val[bag + 1] : nnz;
+                float scale =
+                        mode == Mode::MEAN && end > begin ? 1.f / (end - begin) : 1.f;
+                for (size_t j = begin; j < end; ++j) {
+                    for (size_t c = 0; c < dim; ++c) {
+                        py[bag * dim + c] += pw[index_val[j] * dim + c] * scale;
+                    }
+                }
+            }
+        };
+
+        // index 2 and 4 are never looked up, so their gradient must be zero
+        Checker{make_graph, fwd}.run({TensorShape{NUM, 1}}).run({TensorShape{NUM, 4}});
+    }
+}
+
 TEST(TestOprIndexing, Remap) {
     using Checker = AutoOprChecker<2, 1>;
 
@@ -28,6 +28,13 @@ GraphProfiler::GraphProfiler(cg::ComputingGraph* graph) : PluginBase(graph) {
     using namespace cg::event;
     auto on_seq_start = [this](CompSeqExecBeforeStart const& event) {
         m_used_comp_node = event.used_comp_node;
+        m_static_infer.push_back(m_cur_static_infer);
+        m_cur_static_infer = {};
+    };
+    auto on_static_infer = [this](StaticInferUpdated const& event) {
+        m_cur_static_infer.time += event.time;
+        m_cur_static_infer.nr_updated += event.nr_updated;
+        m_cur_static_infer.cache_hit |= event.cache_hit;
     };
     auto on_opr_start = [this](OprExecStart const& event) {
         ensure_start_time();
@@ -96,10 +103,12 @@ GraphProfiler::GraphProfiler(cg::ComputingGraph* graph) : PluginBase(graph) {
         m_host_time.clear();
         m_kern_event.clear();
         m_opr_fp_rst.clear();
+        m_static_infer.clear();
         m_start_of_time = None;
     };
     auto&& ev = graph->event();
     add_event_handler(ev.register_receiver<CompSeqExecBeforeStart>(on_seq_start));
+    add_event_handler(ev.register_receiver<StaticInferUpdated>(on_static_infer));
     add_event_handler(ev.register_receiver<OprExecStart>(on_opr_start));
     add_event_handler(ev.register_receiver<OprExecFinished>(on_opr_finish));
     add_event_handler(ev.register_receiver<BeforeKernel>(on_before_kern));
@@ -202,11 +211,19 @@ std::shared_ptr<json::Object> GraphProfiler::to_json() const {
             opr_itnl_pf_item[pf_pair.first->id_str()] = pf_pair.second;
         }
     }
+    auto static_infer = Array::make();
+    for (auto&& i : m_static_infer) {
+        static_infer->add(Object::make(
+                {{"time", Number::make(i.time)},
+                 {"nr_updated", NumberInt::make(i.nr_updated)},
+                 {"cache_hit", Bool::make(i.cache_hit)}}));
+    }
     return Object::make(
             {{"device", dev_prof},
              {"host", host_prof},
              {"opr_footprint", opr_fp},
-             {"opr_internal_pf", opr_internal_pf}});
+             {"opr_internal_pf", opr_internal_pf},
+             {"static_infer", static_infer}});
 }
 
 #endif  // MGB_ENABLE_JSON
@@ -71,6 +71,16 @@ class GraphProfiler final : public PluginBase {
 
     std::unique_ptr<OprFootprint> m_opr_footprint_ptr{std::make_unique<OprFootprint>()};
 
+    //! static shape inference done before an execution
+    struct StaticInferRecord {
+        double time = 0;
+        size_t nr_updated = 0;
+        bool cache_hit = false;
+    };
+    //! records of finished executions, and the one being prepared
+    std::vector<StaticInferRecord> m_static_infer;
+    StaticInferRecord m_cur_static_infer;
+
     //! first event on each comp node
     Maybe<CompNode::UnorderedMap<CompNodeEventPtr>> m_start_of_time;
     std::mutex m_mtx;
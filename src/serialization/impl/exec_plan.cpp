@@ -0,0 +1,225 @@
+/**
+ * \file src/serialization/impl/exec_plan.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/serialization/exec_plan.h"
+#include "megbrain/version.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <map>
+
+using namespace mgb;
+using namespace serialization;
+
+namespace {
+enum class CpuArch : uint64_t { UNKNOWN = 0, X86 = 1, ARM = 2 };
+
+constexpr int ARCH_SHIFT = 56;
+
+//! the recorder whose cache is installed as PersistentCache; only one
+//! recorder may be alive at a time since the cache is process-global
+MGB_MUTEX g_recorder_mtx;
+const void* g_active_recorder = nullptr;
+}  // anonymous namespace
+
+/* ======================= ExecPlan::Recorder::Cache ======================= */
+
+//! forward to the original cache and remember every entry that is accessed
+class ExecPlan::Recorder::Cache final : public PersistentCache {
+    std::shared_ptr<PersistentCache> m_orig;
+    std::map<std::pair<std::string, std::string>, std::string> m_entries;
+    MGB_MUTEX m_mtx;
+
+    void record(const std::string& category, const Blob& key, const Blob& value) {
+        MGB_LOCK_GUARD(m_mtx);
+        m_entries[{category, {static_cast<const char*>(key.ptr), key.size}}] = {
+                static_cast<const char*>(value.ptr), value.size};
+    }
+
+public:
+    void set_orig(std::shared_ptr<PersistentCache> orig) { m_orig = std::move(orig); }
+
+    Maybe<Blob> get(const std::string& category, const Blob& key) override {
+        auto ret = m_orig->get(category, key);
+        if (ret.valid()) {
+            record(category, key, ret.val());
+        }
+        return ret;
+    }
+
+    void put(const std::string& category, const Blob& key, const Blob& value)
+            override {
+        m_orig->put(category, key, value);
+        record(category, key, value);
+    }
+
+    std::vector<AlgoCacheEntry> entries() {
+        MGB_LOCK_GUARD(m_mtx);
+        std::vector<AlgoCacheEntry> ret;
+        for (auto&& i : m_entries) {
+            ret.push_back({i.first.first, i.first.second, i.second});
+        }
+        return ret;
+    }
+};
+
+/* ============================== ExecPlan ============================== */
+
+uint32_t ExecPlan::runtime_version() {
+    return (MGE_MAJOR * 1000 + MGE_MINOR) * 100 + MGE_PATCH;
+}
+
+uint64_t ExecPlan::host_cpu_features() {
+    uint64_t ret = 0;
+    auto arch = CpuArch::UNKNOWN;
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    arch = CpuArch::X86;
+    __builtin_cpu_init();
+    int bit = 0;
+#define cb(_feature)                        \
+    if (__builtin_cpu_supports(_feature)) { \
+        ret |= uint64_t(1) << bit;          \
+    }                                       \
+    ++bit;
+    cb("sse4.2");
+    cb("avx");
+    cb("avx2");
+    cb("fma");
+    cb("avx512f");
+#undef cb
+#elif defined(__aarch64__) || defined(__arm__)
+    arch = CpuArch::ARM;
+#if defined(__ARM_NEON)
+    ret |= 1;
+#endif
+#if defined(__ARM_FEATURE_DOTPROD)
+    ret |= 2;
+#endif
+#if defined(__ARM_FEATURE_FP16_VECTOR_ARITHMETIC)
+    ret |= 4;
+#endif
+#endif
+    return ret | (static_cast<uint64_t>(arch) << ARCH_SHIFT);
+}
+
+bool ExecPlan::usable(std::string* reason) const {
+    auto set_reason = [reason](std::string msg) {
+        if (reason) {
+            *reason = std::move(msg);
+        }
+        return false;
+    };
+    if (mgb_version != runtime_version()) {
+        return set_reason(ssprintf(
+                "plan is made by runtime version %u, current version is %u",
+                mgb_version, runtime_version()));
+    }
+    auto host = host_cpu_features();
+    if ((cpu_features >> ARCH_SHIFT) != (host >> ARCH_SHIFT)) {
+        return set_reason("plan is made on another CPU architecture");
+    }
+    if (cpu_features & ~host) {
+        return set_reason(ssprintf(
+                "plan needs CPU features %#" PRIx64 ", but host only has %#" PRIx64,
+                cpu_features, host));
+    }
+    return true;
+}
+
+bool ExecPlan::match_inputs(
+        const std::unordered_map<std::string, std::shared_ptr<HostTensorND>>& inputs,
+        std::string* reason) const {
+    for (auto&& i : input_shapes) {
+        auto iter = inputs.find(i.first);
+        if (iter == inputs.end()) {
+            if (reason) {
+                *reason = ssprintf("input %s in the plan not found", i.first.c_str());
+            }
+            return false;
+        }
+        if (!iter->second->shape().eq_shape(i.second)) {
+            if (reason) {
+                *reason = ssprintf(
+                        "shape of input %s is %s, but the plan is for %s",
+                        i.first.c_str(), iter->second->shape().to_string().c_str(),
+                        i.second.to_string().c_str());
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void ExecPlan::write_algo_cache() const {
+    auto&& cache = PersistentCache::inst();
+    for (auto&& i : algo_cache) {
+        cache.put(
+                i.category, {i.key.data(), i.key.size()},
+                {i.value.data(), i.value.size()});
+    }
+}
+
+void ExecPlan::apply_after_compile(cg::AsyncExecutable& func) const {
+    if (!static_mem_plan.empty()) {
+        func.load_static_mem_plan(static_mem_plan);
+    }
+}
+
+/* ========================== ExecPlan::Recorder ========================== */
+
+ExecPlan::Recorder::Recorder() : m_cache{std::make_shared<Cache>()} {
+    MGB_LOCK_GUARD(g_recorder_mtx);
+    mgb_throw_if(
+            g_active_recorder, MegBrainError,
+            "another ExecPlan::Recorder is alive; recorders can not be nested");
+    g_active_recorder = this;
+    m_orig_cache = PersistentCache::set_impl(m_cache);
+    m_cache->set_orig(m_orig_cache);
+}
+
+ExecPlan::Recorder::~Recorder() {
+    MGB_LOCK_GUARD(g_recorder_mtx);
+    mgb_assert(g_active_recorder == this);
+    g_active_recorder = nullptr;
+    auto cur = PersistentCache::set_impl(m_orig_cache);
+    if (cur != m_cache) {
+        // the implementation is replaced by others while recording; keep
+        // theirs rather than restoring the one before the recorder
+        mgb_log_warn(
+                "PersistentCache implementation is changed during "
+                "ExecPlan::Recorder; algorithm cache entries may be missing "
+                "from the plan");
+        PersistentCache::set_impl(std::move(cur));
+    }
+}
+
+std::shared_ptr<ExecPlan> ExecPlan::Recorder::finish(
+        cg::AsyncExecutable& func,
+        const std::unordered_map<std::string, std::shared_ptr<HostTensorND>>&
+                inputs) {
+    auto ret = std::make_shared<ExecPlan>();
+    ret->mgb_version = runtime_version();
+    ret->cpu_features = host_cpu_features();
+    for (auto&& i : inputs) {
+        ret->input_shapes.emplace_back(i.first, i.second->shape());
+    }
+    std::sort(
+            ret->input_shapes.begin(), ret->input_shapes.end(),
+            [](const std::pair<std::string, TensorShape>& a,
+               const std::pair<std::string, TensorShape>& b) {
+                return a.first < b.first;
+            });
+    ret->static_mem_plan = func.dump_static_mem_plan();
+    ret->algo_cache = m_cache->entries();
+    return ret;
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -11,6 +11,26 @@
 
 #include "megbrain/serialization/file.h"
 
+#if !defined(_WIN32) && !defined(__IN_TEE_ENV__)
+#define MGB_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define MGB_HAVE_MMAP 0
+#endif
+
+#if MGB_HAVE_MMAP && defined(__linux__)
+#define MGB_HAVE_PAGEMAP 1
+#include "megbrain/graph/event.h"
+
+#include <algorithm>
+#include <tuple>
+#else
+#define MGB_HAVE_PAGEMAP 0
+#endif
+
 namespace mgb {
 namespace serialization {
 
@@ -231,6 +251,282 @@ SharedBuffer InputFile::SharedMemProxyImpl::read_shared(size_t size) {
     return {std::move(ret), size};
 }
 
+/* ====================== MmapResidency ====================== */
+namespace {
+#if MGB_HAVE_PAGEMAP
+//! read present pages from /proc/self/pagemap to find chunks of the mapping
+//! that have been touched, and unmap them by madvise(MADV_DONTNEED)
+class MmapResidencyImpl final : public MmapResidency {
+    //! number of pages in a chunk, the unit to be unmapped
+    static constexpr size_t CHUNK_PAGES = 16;
+    static constexpr uint64_t PM_PRESENT = 1ull << 63, PM_SWAP = 1ull << 62,
+                              PM_FILE = 1ull << 61;
+
+    struct Chunk {
+        //! scan epoch when the chunk was first found paged in since it was
+        //! last unmapped; 0 if not mapped
+        size_t paged_in = 0;
+        //! value of m_clock at the last observed touch; 0 if never touched
+        size_t last_access = 0;
+        size_t nr_present = 0;
+        //! whether it contains private copies of written pages
+        bool dirty = false;
+    };
+
+    std::weak_ptr<void> m_mapping;
+    uint8_t* const m_ptr;
+    const size_t m_size, m_page_size;
+    size_t m_epoch = 0, m_clock = 0, m_budget = NO_BUDGET;
+    //! sum of nr_present of all chunks in bytes; touched chunks are counted
+    //! as fully present until the next scan
+    size_t m_resident = 0;
+    std::vector<Chunk> m_chunks;
+    std::vector<uint64_t> m_pagemap;
+    std::vector<SyncEventConnecter::ReceiverHandler> m_event_handlers;
+    MGB_MUTEX m_mtx;
+
+    size_t nr_page() const { return (m_size + m_page_size - 1) / m_page_size; }
+
+    //! update m_chunks from pagemap; return false if pagemap is unavailable
+    bool scan();
+
+    //! mark chunks overlapping with [ptr, ptr + size) as recently used
+    void touch(const void* ptr, size_t size);
+
+    Stat trim_locked(size_t budget);
+
+    Stat make_stat(bool supported, size_t nr_trimmed) const {
+        Stat ret;
+        ret.supported = supported;
+        ret.mapped_bytes = m_size;
+        ret.resident_bytes = m_resident;
+        ret.nr_trimmed_chunk = nr_trimmed;
+        return ret;
+    }
+
+public:
+    MmapResidencyImpl(const std::shared_ptr<void>& mapping, size_t size)
+            : m_mapping{mapping},
+              m_ptr{static_cast<uint8_t*>(mapping.get())},
+              m_size{size},
+              m_page_size(sysconf(_SC_PAGESIZE)) {
+        m_chunks.resize((nr_page() + CHUNK_PAGES - 1) / CHUNK_PAGES);
+    }
+
+    Stat stat() override {
+        MGB_LOCK_GUARD(m_mtx);
+        auto mapping = m_mapping.lock();
+        return make_stat(mapping && scan(), 0);
+    }
+
+    Stat trim(size_t budget) override {
+        MGB_LOCK_GUARD(m_mtx);
+        return trim_locked(budget);
+    }
+
+    void set_budget(size_t budget) override {
+        MGB_LOCK_GUARD(m_mtx);
+        m_budget = budget;
+    }
+
+    void track(cg::ComputingGraph& graph) override;
+};
+
+bool MmapResidencyImpl::scan() {
+    int fd = open("/proc/self/pagemap", O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    auto nr_page = this->nr_page();
+    m_pagemap.resize(nr_page);
+    auto nbytes = nr_page * sizeof(uint64_t);
+    auto offset = reinterpret_cast<uintptr_t>(m_ptr) / m_page_size * sizeof(uint64_t);
+    auto nr_read = pread(fd, m_pagemap.data(), nbytes, offset);
+    close(fd);
+    if (nr_read != static_cast<ssize_t>(nbytes)) {
+        return false;
+    }
+    ++m_epoch;
+    m_resident = 0;
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+        auto&& chunk = m_chunks[i];
+        auto begin = i * CHUNK_PAGES, end = std::min(begin + CHUNK_PAGES, nr_page);
+        chunk.nr_present = 0;
+        for (size_t j = begin; j < end; ++j) {
+            auto entry = m_pagemap[j];
+            if (entry & PM_PRESENT) {
+                ++chunk.nr_present;
+                if (!(entry & PM_FILE)) {
+                    chunk.dirty = true;
+                }
+            } else if (entry & PM_SWAP) {
+                // only private copies of written pages can be swapped out;
+                // they are not present but would be lost by MADV_DONTNEED
+                chunk.dirty = true;
+            }
+        }
+        if (!chunk.nr_present) {
+            chunk.paged_in = 0;
+        } else if (!chunk.paged_in) {
+            chunk.paged_in = m_epoch;
+        }
+        m_resident += chunk.nr_present * m_page_size;
+    }
+    return true;
+}
+
+void MmapResidencyImpl::touch(const void* ptr, size_t size) {
+    auto addr = static_cast<const uint8_t*>(ptr);
+    if (!size || addr + size <= m_ptr || addr >= m_ptr + m_size) {
+        return;
+    }
+    auto chunk_bytes = CHUNK_PAGES * m_page_size;
+    auto begin = addr > m_ptr ? static_cast<size_t>(addr - m_ptr) : 0,
+         end = std::min<size_t>(addr + size - m_ptr, m_size);
+    auto nr_page = this->nr_page();
+    MGB_LOCK_GUARD(m_mtx);
+    ++m_clock;
+    for (size_t i = begin / chunk_bytes; i * chunk_bytes < end; ++i) {
+        auto&& chunk = m_chunks[i];
+        chunk.last_access = m_clock;
+        auto pages = std::min(CHUNK_PAGES, nr_page - i * CHUNK_PAGES);
+        m_resident += (pages - chunk.nr_present) * m_page_size;
+        chunk.nr_present = pages;
+    }
+}
+
+MmapResidency::Stat MmapResidencyImpl::trim_locked(size_t budget) {
+    auto mapping = m_mapping.lock();
+    if (!mapping || !scan()) {
+        return make_stat(false, 0);
+    }
+    // least recently touched first; chunks never touched by tracked oprs are
+    // ordered by when they were found paged in
+    std::vector<std::tuple<size_t, size_t, size_t>> candidates;
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+        auto&& chunk = m_chunks[i];
+        if (chunk.nr_present && !chunk.dirty) {
+            candidates.emplace_back(chunk.last_access, chunk.paged_in, i);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    size_t nr_trimmed = 0;
+    for (auto&& i : candidates) {
+        if (m_resident <= budget) {
+            break;
+        }
+        auto idx = std::get<2>(i);
+        auto&& chunk = m_chunks[idx];
+        auto begin = idx * CHUNK_PAGES * m_page_size;
+        auto len = std::min(CHUNK_PAGES * m_page_size, m_size - begin);
+        // pages of the chunk are clean, so they are reloaded from the file
+        // with the same content on next touch
+        if (madvise(m_ptr + begin, len, MADV_DONTNEED)) {
+            mgb_log_warn("madvise failed: %s", strerror(errno));
+            break;
+        }
+        m_resident -= chunk.nr_present * m_page_size;
+        chunk.nr_present = 0;
+        chunk.paged_in = 0;
+        ++nr_trimmed;
+    }
+    return make_stat(true, nr_trimmed);
+}
+
+void MmapResidencyImpl::track(cg::ComputingGraph& graph) {
+    auto on_opr = [this](const cg::event::OprExecKernelStart& event) {
+        for (auto var : event.opr->input()) {
+            if (var->dev_tensor_valid()) {
+                auto&& dv = var->dev_tensor();
+                if (!dv.empty()) {
+                    touch(dv.raw_ptr(), dv.layout().span().dist_byte());
+                }
+            }
+        }
+    };
+    // trimming is deferred to the end of execution, when no opr is reading
+    // or writing the params
+    auto on_finish = [this](const cg::event::CompSeqExecFinished& event) {
+        if (!event.device_actually_finished) {
+            return;
+        }
+        MGB_LOCK_GUARD(m_mtx);
+        if (m_budget != NO_BUDGET && m_resident > m_budget) {
+            trim_locked(m_budget);
+        }
+    };
+    MGB_LOCK_GUARD(m_mtx);
+    m_event_handlers.emplace_back(
+            graph.event().register_receiver<cg::event::OprExecKernelStart>(on_opr));
+    m_event_handlers.emplace_back(
+            graph.event().register_receiver<cg::event::CompSeqExecFinished>(
+                    on_finish));
+}
+#else
+class MmapResidencyImpl final : public MmapResidency {
+    size_t m_size;
+
+public:
+    MmapResidencyImpl(const std::shared_ptr<void>&, size_t size) : m_size{size} {}
+
+    Stat stat() override {
+        Stat ret;
+        ret.mapped_bytes = m_size;
+        return ret;
+    }
+
+    Stat trim(size_t) override { return stat(); }
+
+    void set_budget(size_t) override {}
+
+    void track(cg::ComputingGraph&) override {}
+};
+#endif
+}  // anonymous namespace
+
+std::unique_ptr<InputFile> InputFile::make_mmap(
+        const char* path, std::shared_ptr<MmapResidency>* residency) {
+#if MGB_HAVE_MMAP
+    int fd = open(path, O_RDONLY);
+    mgb_assert(fd >= 0, "failed to open %s: %s", path, strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st)) {
+        auto err = errno;
+        close(fd);
+        mgb_throw(SystemError, "failed to stat %s: %s", path, strerror(err));
+    }
+    size_t size = st.st_size;
+    mgb_assert(size, "can not map empty file %s", path);
+    // writable private mapping, so that oprs modifying their params inplace
+    // only get their own copies of touched pages
+    auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    auto err = errno;
+    close(fd);
+    mgb_assert(ptr != MAP_FAILED, "failed to mmap %s: %s", path, strerror(err));
+    std::shared_ptr<void> refhold{ptr, [size](void* p) { munmap(p, size); }};
+    if (residency) {
+        *residency = std::make_shared<MmapResidencyImpl>(refhold, size);
+    }
+    // the buffer is not modified by the reader to keep pages shared
+    return std::make_unique<SharedMemProxyImpl>(std::move(refhold), size, false);
+#else
+    FILE* fptr = fopen(path, "rb");
+    mgb_assert(fptr, "failed to open %s: %s", path, strerror(errno));
+    fseek(fptr, 0, SEEK_END);
+    auto size = ftell(fptr);
+    std::rewind(fptr);
+    mgb_assert(size > 0, "can not read empty file %s", path);
+    std::shared_ptr<void> buf{new uint8_t[size], [](uint8_t* p) { delete[] p; }};
+    auto nr = fread(buf.get(), 1, size, fptr);
+    fclose(fptr);
+    mgb_assert(nr == static_cast<size_t>(size), "failed to read %s", path);
+    if (residency) {
+        *residency = std::make_shared<MmapResidencyImpl>(buf, size);
+    }
+    return std::make_unique<SharedMemProxyImpl>(std::move(buf), size, true);
+#endif
+}
+
 std::unique_ptr<InputFile> InputFile::make_mem_proxy(const void* ptr, size_t size) {
     return std::make_unique<MemProxyImpl>(ptr, size);
 }
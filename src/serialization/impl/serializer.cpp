@@ -21,7 +21,20 @@ GraphLoader::LoadResult::~LoadResult() noexcept = default;
 
 std::unique_ptr<cg::AsyncExecutable> GraphLoader::LoadResult::graph_compile(
         const ComputingGraph::OutputSpec& outspec) {
+    std::string reason;
+    bool try_plan = exec_plan && exec_plan_option.enable;
+    bool use_plan = try_plan && exec_plan->usable(&reason) &&
+                    exec_plan->match_inputs(tensor_map, &reason);
+    if (try_plan && !use_plan) {
+        mgb_log_warn("execution plan in the model ignored: %s", reason.c_str());
+    }
+    if (use_plan && exec_plan_option.write_algo_cache) {
+        exec_plan->write_algo_cache();
+    }
     auto ret = graph->compile(outspec);
+    if (use_plan) {
+        exec_plan->apply_after_compile(*ret);
+    }
     if (graph->options().comp_node_seq_record_level == 2) {
         ComputingGraph::assert_destroy(graph);
     }
@@ -32,6 +32,8 @@
 #include "megbrain/serialization/metadata.h"
 #include "megbrain/serialization/opr_load_dump.h"
 #include "megbrain/serialization/serializer.h"
+#include "megbrain/utils/async_worker.h"
+#include "megbrain/utils/tensor_codec.h"
 #include "megbrain/version.h"
 
 #include <flatbuffers/flatbuffers.h>
@@ -39,6 +41,7 @@
 #include <cerrno>
 #include <cinttypes>
 #include <cstdio>
+#include <deque>
 
 using namespace mgb;
 using namespace mgb::serialization;
@@ -130,6 +133,7 @@ class GraphDumperOSS final : public GraphDumper, OprDumpContextFlatBuffers {
 
     void init_oprs_to_dump(const SymbolVarArray& endpoints);
     flatbuffers::Offset<fbs::Metadata> build_metadata(const Metadata& metadata);
+    flatbuffers::Offset<fbs::ExecPlan> build_exec_plan(const ExecPlan& plan);
     flatbuffers::Offset<fbs::Operator> build_single_opr(
             cg::OperatorNodeBase* opr, const OprRegistry* registry);
 
@@ -212,6 +216,31 @@ flatbuffers::Offset<fbs::Metadata> GraphDumperOSS::build_metadata(
     return builder.Finish();
 }
 
+flatbuffers::Offset<fbs::ExecPlan> GraphDumperOSS::build_exec_plan(
+        const ExecPlan& plan) {
+    auto make_bytes = [this](const std::string& s) {
+        return m_builder.CreateVector(
+                reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    };
+    std::vector<flatbuffers::Offset<fbs::InputShape>> input_shapes;
+    for (auto&& i : plan.input_shapes) {
+        input_shapes.emplace_back(fbs::CreateInputShape(
+                m_builder, m_builder.CreateSharedString(i.first),
+                m_builder.CreateVectorScalarCast<uint32_t>(
+                        i.second.shape, i.second.ndim)));
+    }
+    std::vector<flatbuffers::Offset<fbs::AlgoCacheEntry>> algo_cache;
+    for (auto&& i : plan.algo_cache) {
+        algo_cache.emplace_back(fbs::CreateAlgoCacheEntry(
+                m_builder, m_builder.CreateSharedString(i.category),
+                make_bytes(i.key), make_bytes(i.value)));
+    }
+    return fbs::CreateExecPlan(
+            m_builder, plan.mgb_version, plan.cpu_features,
+            m_builder.CreateVector(input_shapes), make_bytes(plan.static_mem_plan),
+            m_builder.CreateVector(algo_cache));
+}
+
 flatbuffers::Offset<fbs::Operator> GraphDumperOSS::build_single_opr(
         cg::OperatorNodeBase* opr, const OprRegistry* registry) {
     m_cur_opr = opr;
@@ -374,6 +403,12 @@ GraphDumper::DumpResult GraphDumperOSS::dump(
     content_hash.update(m_builder.GetCurrentBufferPointer(), m_builder.GetSize());
     auto graph_hash = content_hash.digest();
 
+    // the plan is not part of the graph, so it is excluded from the hash
+    flatbuffers::Offset<fbs::ExecPlan> fb_exec_plan;
+    if (m_config.exec_plan) {
+        fb_exec_plan = build_exec_plan(*m_config.exec_plan);
+    }
+
     fbs::GraphBuilder graph(m_builder);
     graph.add_mgb_version(MGB_VERSION);
     graph.add_hash(graph_hash);
@@ -381,6 +416,7 @@ GraphDumper::DumpResult GraphDumperOSS::dump(
     graph.add_output_vars_idx(fb_output_vars);
     graph.add_nr_shared_tensor(m_nr_shared_tensor);
     graph.add_metadata(fbmeta);
+    graph.add_exec_plan(fb_exec_plan);
     m_builder.FinishSizePrefixed(graph.Finish(), fbs::GraphIdentifier());
 
     // Write actual offset_to_fbs
@@ -442,13 +478,37 @@ void GraphDumperOSS::dump_tensor(
             break;
     }
 
-    size_t value_size = 0;
+    using Compression = GraphDumpConfig::TensorCompression;
+    size_t value_size = 0, padding = 0;
+    auto compression = Compression::NONE;
     if (has_value) {
         check_tensor_value_valid(name, tensor);
+        if (auto align = m_config.tensor_value_alignment) {
+            // the loader skips Tensor::offset bytes before reading value
+            padding = (align - m_file->tell() % align) % align;
+            std::vector<uint8_t> zeros(padding);
+            m_file->write(zeros.data(), padding);
+        }
         auto begin = m_file->tell();
         auto&& dumper = m_config.tensor_value_dumper;
+        auto want_compression = m_config.tensor_value_compression;
+        mgb_throw_if(
+                dumper && want_compression != Compression::NONE, SerializationError,
+                "tensor value compression can not be used with custom tensor "
+                "value dumper");
+        std::vector<uint8_t> encoded;
+        // only params and constants are compressed; input values are
+        // usually replaced by the caller and should be kept exact
+        if (want_compression != Compression::NONE && method != Meth::VALUE_INPUT &&
+            tensor.shape().total_nr_elems() >=
+                    m_config.tensor_compression_min_nr_elems &&
+            tensor_codec::encode(want_compression, tensor, encoded)) {
+            compression = want_compression;
+        }
         if (dumper) {
             dumper(*m_file, *m_cur_opr, tensor);
+        } else if (compression != Compression::NONE) {
+            m_file->write(encoded.data(), encoded.size());
         } else {
             m_file->write(tensor.raw_ptr(), tensor.layout().span().high_byte);
         }
@@ -463,8 +523,9 @@ void GraphDumperOSS::dump_tensor(
             m_builder,
             m_builder.CreateSharedString(tensor.comp_node().to_string_logical()));
     auto dtype = build_dtype(tensor.dtype());
-    auto serialized_tensor =
-            fbs::CreateTensor(m_builder, fbname, shape, comp_node, dtype, value_size);
+    auto serialized_tensor = fbs::CreateTensor(
+            m_builder, fbname, shape, comp_node, dtype, padding + value_size, padding,
+            static_cast<fbs::TensorCompression>(compression));
     m_cur_opr_tensor.emplace_back(serialized_tensor);
 }
 
@@ -522,6 +583,26 @@ class GraphLoaderOSS::OprLoadContextImpl final : public OprLoadContextFlatBuffer
     size_t m_cur_opr_blob_cnt;
     size_t m_cur_opr_param_cnt;
 
+    //! a tensor value read ahead and being decoded by m_preload_pool
+    struct PreloadedValue {
+        const fbs::Tensor* tensor;
+        //! raw blob, released by the worker once it is decoded
+        std::shared_ptr<SharedBuffer> blob;
+        HostTensorND value;
+        FutureThreadPool<void>::Future done;
+    };
+    //! tensors with values, in the order they are loaded
+    std::vector<const fbs::Tensor*> m_preload_order;
+    //! number of tensors in m_preload_order whose blobs have been read
+    size_t m_nr_preload_read = 0;
+    //! max number of values read ahead but not consumed yet
+    size_t m_preload_window = 0;
+    //! values being read ahead in load order; deque is used so that
+    //! references held by workers stay valid
+    std::deque<PreloadedValue> m_preload;
+    //! declared after m_preload so workers are joined before it is freed
+    std::unique_ptr<FutureThreadPool<void>> m_preload_pool;
+
     ComputingGraph& graph() override { return *m_graph; }
 
     const GraphLoadConfig& config() const override {
@@ -531,6 +612,14 @@ class GraphLoaderOSS::OprLoadContextImpl final : public OprLoadContextFlatBuffer
     void load_tensor_value(
             HostTensorND* dest, const TensorLayout& layout, const fbs::Tensor* tensor);
 
+    /*!
+     * \brief read a tensor value from file at the beginning of its blob
+     * \param dest where to store the value; skip the blob if it is null
+     */
+    static void read_tensor_value(
+            const GraphLoadConfig& config, InputFile& file, HostTensorND* dest,
+            const TensorLayout& layout, const fbs::Tensor* tensor);
+
     std::shared_ptr<HostTensorND> load_tensor() override;
 
     std::shared_ptr<DeviceTensorND> load_tensor_shared() override;
@@ -559,6 +648,23 @@ public:
     }
 
     Metadata load_metadata();
+    std::shared_ptr<ExecPlan> load_exec_plan();
+
+    /*!
+     * \brief decode tensor values on a thread pool, so that values are ready
+     *      (or being prepared) when oprs are loaded
+     *
+     * Blobs are read ahead in load order, at most a few values per thread
+     * beyond the one being consumed, so I/O and decoding overlap with opr
+     * construction while memory usage stays bounded.
+     */
+    void preload_tensor_values(size_t nr_thread);
+
+    //! read blobs until the read-ahead window is full
+    void read_ahead();
+
+    //! skip blobs never consumed so the file is left at the end of tensor data
+    void finish_preload();
     LoadResult load_oprs();
     CompNode load_comp_node(const fbs::CompNode* comp_node);
 
@@ -629,33 +735,47 @@ TensorLayout load_tensor_layout(const fbs::Tensor* tensor) {
     return layout;
 }
 
-void GraphLoaderOSS::OprLoadContextImpl::load_tensor_value(
-        HostTensorND* dest, const TensorLayout& layout, const fbs::Tensor* tensor) {
-    auto&& loader = m_loader->m_cur_load_config->tensor_value_loader;
-    auto&& file = m_loader->m_file;
-    auto begin_pos = file->tell();
-    file->skip(tensor->offset());
-    if (loader) {
+void GraphLoaderOSS::OprLoadContextImpl::read_tensor_value(
+        const GraphLoadConfig& config, InputFile& file, HostTensorND* dest,
+        const TensorLayout& layout, const fbs::Tensor* tensor) {
+    auto&& loader = config.tensor_value_loader;
+    auto begin_pos = file.tell();
+    file.skip(tensor->offset());
+    auto compression = tensor->compression();
+    if (compression != fbs::TensorCompression_NONE) {
+        // compressed values are written by the builtin codec, so custom
+        // loaders are not involved
+        size_t size = tensor->data_size() - tensor->offset();
+        if (dest) {
+            auto buf = file.read_shared(size);
+            dest->dtype(layout.dtype).resize(layout);
+            tensor_codec::decode(
+                    static_cast<GraphDumpConfig::TensorCompression>(compression),
+                    buf.data(), size, layout, dest->raw_ptr());
+        } else {
+            file.skip(size);
+        }
+    } else if (loader) {
         // call custom loader
         void* dest_ptr = nullptr;
         if (dest) {
             dest->dtype(layout.dtype).resize(layout);
             dest_ptr = dest->raw_ptr();
         }
-        loader(dest_ptr, layout, *file);
+        loader(dest_ptr, layout, file);
     } else {
         if (dest) {
-            file->read_into_tensor(*dest, layout);
+            file.read_into_tensor(*dest, layout);
         } else {
-            file->skip(layout.span().high_byte);
+            file.skip(layout.span().high_byte);
         }
     }
     mgb_throw_if(
-            file->tell() < begin_pos, SerializationError,
+            file.tell() < begin_pos, SerializationError,
             "Custom tensor value loader accessed out of range data before "
             "start of data blob");
     auto data_size = tensor->data_size();
-    auto consumed_size = file->tell() - begin_pos;
+    auto consumed_size = file.tell() - begin_pos;
     mgb_throw_if(
             consumed_size > data_size, SerializationError,
             "Custom tensor value loader consumed more data than "
@@ -666,7 +786,90 @@ void GraphLoaderOSS::OprLoadContextImpl::load_tensor_value(
                 "Tensor value loader consumed less data than available: "
                 "consumed %zu bytes, has %u bytes",
                 consumed_size, data_size);
-        file->skip(data_size - consumed_size);
+        file.skip(data_size - consumed_size);
+    }
+}
+
+void GraphLoaderOSS::OprLoadContextImpl::load_tensor_value(
+        HostTensorND* dest, const TensorLayout& layout, const fbs::Tensor* tensor) {
+    if (!m_preload_pool) {
+        read_tensor_value(
+                *m_loader->m_cur_load_config, *m_loader->m_file, dest, layout, tensor);
+        return;
+    }
+    if (m_preload.empty()) {
+        read_ahead();
+    }
+    // values are consumed in the same order as they are stored
+    mgb_assert(!m_preload.empty() && m_preload.front().tensor == tensor);
+    auto&& item = m_preload.front();
+    // rethrow exception from the worker
+    item.done.get();
+    if (dest) {
+        if (item.value.comp_node() == dest->comp_node()) {
+            *dest = std::move(item.value);
+        } else {
+            dest->copy_from(item.value);
+        }
+    }
+    m_preload.pop_front();
+    read_ahead();
+}
+
+void GraphLoaderOSS::OprLoadContextImpl::preload_tensor_values(size_t nr_thread) {
+    m_preload_pool =
+            std::make_unique<FutureThreadPool<void>>(std::string{"load_tensor"});
+    m_preload_pool->start(nr_thread);
+    m_preload_window = nr_thread * 2;
+    const auto* oprs = m_loader->m_graph->oprs();
+    for (flatbuffers::uoffset_t i = 0; i < oprs->size(); ++i) {
+        auto tensors = oprs->Get(i)->tensors();
+        if (!tensors) {
+            continue;
+        }
+        for (auto tensor : *tensors) {
+            if (tensor->data_size()) {
+                m_preload_order.push_back(tensor);
+            }
+        }
+    }
+    read_ahead();
+}
+
+void GraphLoaderOSS::OprLoadContextImpl::read_ahead() {
+    auto&& config = *m_loader->m_cur_load_config;
+    auto&& file = *m_loader->m_file;
+    while (m_preload.size() < m_preload_window &&
+           m_nr_preload_read < m_preload_order.size()) {
+        // blobs are stored in the order they are loaded, so the file is
+        // read sequentially here
+        auto tensor = m_preload_order[m_nr_preload_read++];
+        auto cn = load_comp_node(tensor->comp_node());
+        if (!cn.valid() || cn.device_type() != CompNode::DeviceType::CPU) {
+            cn = CompNode::default_cpu();
+        }
+        m_preload.emplace_back();
+        auto item = &m_preload.back();
+        item->tensor = tensor;
+        item->blob = std::make_shared<SharedBuffer>(
+                file.read_shared(tensor->data_size()));
+        item->value = HostTensorND{cn};
+        auto task = [&config, item]() {
+            auto buf = std::move(item->blob);
+            std::shared_ptr<void> ptr{buf, const_cast<void*>(buf->data())};
+            auto blob_file = InputFile::make_mem_proxy(ptr, buf->size(), false);
+            read_tensor_value(
+                    config, *blob_file, &item->value,
+                    load_tensor_layout(item->tensor), item->tensor);
+        };
+        item->done = m_preload_pool->launch(task);
+    }
+}
+
+void GraphLoaderOSS::OprLoadContextImpl::finish_preload() {
+    auto&& file = *m_loader->m_file;
+    for (; m_nr_preload_read < m_preload_order.size(); ++m_nr_preload_read) {
+        file.skip(m_preload_order[m_nr_preload_read]->data_size());
     }
 }
 
@@ -750,6 +953,48 @@ Metadata GraphLoaderOSS::OprLoadContextImpl::load_metadata() {
     return ret;
 }
 
+std::shared_ptr<ExecPlan> GraphLoaderOSS::OprLoadContextImpl::load_exec_plan() {
+    const auto* fbplan = m_loader->m_graph->exec_plan();
+    if (!fbplan) {
+        return {};
+    }
+    auto load_bytes = [](const flatbuffers::Vector<uint8_t>* v) -> std::string {
+        if (!v) {
+            return {};
+        }
+        return {reinterpret_cast<const char*>(v->data()), v->size()};
+    };
+    auto ret = std::make_shared<ExecPlan>();
+    ret->mgb_version = fbplan->mgb_version();
+    ret->cpu_features = fbplan->cpu_features();
+    if (fbplan->input_shapes()) {
+        for (auto i : *fbplan->input_shapes()) {
+            mgb_throw_if(
+                    !i->name() ||
+                            (i->shape() && i->shape()->size() > TensorShape::MAX_NDIM),
+                    SerializationError, "bad input shape in execution plan");
+            TensorShape shape;
+            if (i->shape()) {
+                shape.ndim = i->shape()->size();
+                std::copy(i->shape()->begin(), i->shape()->end(), shape.shape);
+            }
+            ret->input_shapes.emplace_back(i->name()->str(), shape);
+        }
+    }
+    ret->static_mem_plan = load_bytes(fbplan->static_mem_plan());
+    if (fbplan->algo_cache()) {
+        for (auto i : *fbplan->algo_cache()) {
+            mgb_throw_if(
+                    !i->category(), SerializationError,
+                    "bad algo cache entry in execution plan");
+            ret->algo_cache.push_back(
+                    {i->category()->str(), load_bytes(i->key()),
+                     load_bytes(i->value())});
+        }
+    }
+    return ret;
+}
+
 void GraphLoaderOSS::OprLoadContextImpl::load_single_opr(const fbs::Operator* fbopr) {
     m_cur_opr_tensor_cnt = 0;
     m_cur_opr_blob_cnt = 0;
@@ -937,9 +1182,17 @@ GraphLoader::LoadResult GraphLoaderOSS::load(const LoadConfig& config, bool rewi
     }
 
     OprLoadContextImpl ctx{this, m_graph->mgb_version()};
+    if (config.nr_load_thread > 1) {
+        ctx.preload_tensor_values(config.nr_load_thread);
+    }
     auto metadata = ctx.load_metadata();
     auto result = ctx.load_oprs();
+    if (config.nr_load_thread > 1) {
+        ctx.finish_preload();
+    }
     result.metadata = metadata;
+    result.exec_plan = ctx.load_exec_plan();
+    result.exec_plan_option = config.exec_plan_option;
 
     auto fbs_end = tensor_begin + offset_to_fbs + sizeof(size) + size;
     auto cur = m_file->tell();
@@ -0,0 +1,136 @@
+/**
+ * \file src/serialization/include/megbrain/serialization/exec_plan.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "megbrain/graph.h"
+#include "megbrain/utils/persistent_cache.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mgb {
+namespace serialization {
+
+/*!
+ * \brief solved execution plan of a graph for fixed input shapes
+ *
+ * The plan can be stored in a model by GraphDumper (see
+ * GraphDumpConfig::exec_plan). If GraphLoadConfig::exec_plan_option enables
+ * it, GraphLoader::LoadResult::graph_compile() uses the plan to skip static
+ * memory planning (and algorithm profiling if write_algo_cache is set), as
+ * long as the input shapes, the runtime version and CPU features match those
+ * recorded in the plan.
+ *
+ * Only solver results are stored: graph optimization, topological sorting,
+ * shape inference and workspace size queries still run on compile.
+ */
+struct ExecPlan {
+    struct AlgoCacheEntry {
+        std::string category, key, value;
+    };
+
+    //! version of the runtime that produced the plan
+    uint32_t mgb_version = 0;
+
+    //! CPU features of the host that produced the plan; see cpu_features()
+    uint64_t cpu_features = 0;
+
+    //! shapes of input tensors (i.e. LoadResult::tensor_map) the plan is for
+    std::vector<std::pair<std::string, TensorShape>> input_shapes;
+
+    //! result of AsyncExecutable::dump_static_mem_plan()
+    std::string static_mem_plan;
+
+    //! PersistentCache entries accessed during algorithm selection
+    std::vector<AlgoCacheEntry> algo_cache;
+
+    //! how a loaded plan is used; see GraphLoadConfig::exec_plan_option
+    struct UseOption {
+        //! use the plan when input shapes are the same as the plan
+        bool enable = false;
+
+        //! also write algo_cache into the global PersistentCache
+        bool write_algo_cache = false;
+    };
+
+    //! version of current runtime, in the format of mgb_version
+    MGE_WIN_DECLSPEC_FUC static uint32_t runtime_version();
+
+    /*!
+     * \brief CPU features of current host
+     *
+     * The highest byte identifies the architecture, and other bits are
+     * instruction set extensions that may be used by chosen algorithms
+     */
+    MGE_WIN_DECLSPEC_FUC static uint64_t host_cpu_features();
+
+    /*!
+     * \brief check whether this plan can be used on current runtime and host
+     * \param[out] reason why the plan can not be used, if it is not null
+     */
+    MGE_WIN_DECLSPEC_FUC bool usable(std::string* reason = nullptr) const;
+
+    /*!
+     * \brief check whether input tensors have the shapes of this plan
+     * \param[out] reason why the shapes do not match, if it is not null
+     */
+    MGE_WIN_DECLSPEC_FUC bool match_inputs(
+            const std::unordered_map<std::string, std::shared_ptr<HostTensorND>>&
+                    inputs,
+            std::string* reason = nullptr) const;
+
+    //! write algo_cache into the global PersistentCache
+    MGE_WIN_DECLSPEC_FUC void write_algo_cache() const;
+
+    //! load the static memory plan into a newly compiled function
+    MGE_WIN_DECLSPEC_FUC void apply_after_compile(cg::AsyncExecutable& func) const;
+
+    class Recorder;
+};
+
+/*!
+ * \brief record an ExecPlan while a graph is compiled and executed
+ *
+ * The recorder replaces the PersistentCache implementation during its
+ * lifetime to capture entries used by algorithm selection, so at most one
+ * recorder can be alive at a time and entries used by other graphs running
+ * concurrently are also recorded. Typical usage:
+ *
+ *      ExecPlan::Recorder recorder;
+ *      auto func = load_result.graph_compile(outspec);
+ *      func->execute().wait();
+ *      auto plan = recorder.finish(*func, load_result.tensor_map);
+ */
+class ExecPlan::Recorder : public NonCopyableObj {
+    class Cache;
+    std::shared_ptr<Cache> m_cache;
+    std::shared_ptr<PersistentCache> m_orig_cache;
+
+public:
+    MGE_WIN_DECLSPEC_FUC Recorder();
+    MGE_WIN_DECLSPEC_FUC ~Recorder();
+
+    /*!
+     * \brief make the plan from a function that has been executed
+     * \param inputs input tensors whose shapes are recorded
+     */
+    MGE_WIN_DECLSPEC_FUC std::shared_ptr<ExecPlan> finish(
+            cg::AsyncExecutable& func,
+            const std::unordered_map<std::string, std::shared_ptr<HostTensorND>>&
+                    inputs);
+};
+
+}  // namespace serialization
+}  // namespace mgb
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -16,6 +16,8 @@
 namespace mgb {
 namespace serialization {
 
+class MmapResidency;
+
 class SharedBuffer {
     std::shared_ptr<const void> m_buf;
     size_t m_size;
@@ -74,6 +76,23 @@ public:
     //! create an InputFile correspoding to a file on local file system
     MGE_WIN_DECLSPEC_FUC static std::unique_ptr<InputFile> make_fs(const char* path);
 
+    /*!
+     * \brief create an InputFile that maps a file on local file system into
+     *      memory
+     *
+     * Tensor values are shared with the mapping when they are suitably
+     * aligned (see GraphDumpConfig::tensor_value_alignment), so CPU params
+     * alias the page cache and are shared by all processes loading the same
+     * model. The mapping is private: pages are copied only if written to.
+     *
+     * On platforms without mmap, the whole file is read into memory.
+     *
+     * \param[out] residency if not null, it is set to an object to limit
+     *      resident memory of the mapping; see MmapResidency
+     */
+    MGE_WIN_DECLSPEC_FUC static std::unique_ptr<InputFile> make_mmap(
+            const char* path, std::shared_ptr<MmapResidency>* residency = nullptr);
+
     //! create an InputFile correspoding to a memory region; the memory
     //! region must be alive throughout lifespan of this InputFile
     MGE_WIN_DECLSPEC_FUC static std::unique_ptr<InputFile> make_mem_proxy(
@@ -91,6 +110,61 @@ public:
             std::shared_ptr<void> ptr, size_t size, bool writable = true);
 };
 
+/*!
+ * \brief control resident memory of a file mapped by InputFile::make_mmap()
+ *
+ * Params shared with the mapping are only paged in when they are touched.
+ * trim() unmaps the least recently used chunks of the mapping until resident
+ * memory is within a budget; unmapped chunks stay in the page cache and are
+ * mapped again on next touch.
+ *
+ * Touches are observed on graphs given to track(): each executed opr whose
+ * inputs lie in the mapping marks their chunks as used. Chunks that are only
+ * found paged in by stat() or trim() (e.g. during loading) are older than any
+ * observed touch, and are ordered by when they were found. If a budget is set
+ * by set_budget(), tracked graphs call trim() automatically after each
+ * execution once the resident bytes exceed it.
+ *
+ * Chunks containing pages that have been written to (including such pages
+ * swapped out) are never unmapped.
+ * trim() should not be called while a function using the params is running.
+ * It does nothing on platforms other than Linux.
+ */
+class MmapResidency : public NonCopyableObj {
+public:
+    struct Stat {
+        //! whether residency can be queried and controlled on this platform
+        bool supported = false;
+        size_t mapped_bytes = 0;
+        //! bytes mapped into current process (not only in page cache)
+        size_t resident_bytes = 0;
+        //! number of chunks unmapped by the last trim()
+        size_t nr_trimmed_chunk = 0;
+    };
+
+    //! budget value to disable automatic trimming
+    static constexpr size_t NO_BUDGET = ~size_t(0);
+
+    virtual ~MmapResidency() = default;
+
+    //! query current residency
+    virtual Stat stat() = 0;
+
+    //! unmap chunks until at most *budget* bytes are resident
+    virtual Stat trim(size_t budget) = 0;
+
+    //! set the budget of automatic trimming for tracked graphs
+    virtual void set_budget(size_t budget) = 0;
+
+    /*!
+     * \brief observe accesses to the mapping by oprs executed in a graph
+     *
+     * The graph can be destructed before this object; tracking stops when
+     * this object is destructed.
+     */
+    virtual void track(cg::ComputingGraph& graph) = 0;
+};
+
 //! abstract output file interface
 class OutputFile {
     class FsImpl;
@@ -10,8 +10,10 @@
  */
 #pragma once
 
+#include "megbrain/serialization/exec_plan.h"
 #include "megbrain/serialization/file.h"
 #include "megbrain/serialization/opr_registry.h"
+#include "megbrain/utils/tensor_codec.h"
 
 namespace mgb {
 namespace serialization {
@@ -58,6 +60,28 @@ struct GraphDumpConfig {
     //! names. this list record the mapping between output node and it's name
     std::vector<std::pair<std::string, SymbolVar>> alias_name_map;
 
+    //! if positive, tensor values are padded to be aligned to this number
+    //! of bytes relative to the file start; values can then be used in
+    //! place when loaded by InputFile::make_mmap() (usually 64 for CPU)
+    size_t tensor_value_alignment = 0;
+
+    //! how to compress values of params and constants; values are decoded
+    //! by the loader (in parallel if GraphLoadConfig::nr_load_thread > 1)
+    using TensorCompression = tensor_codec::Method;
+
+    //! compression of tensor values; can not be used with a custom
+    //! tensor_value_dumper. Values that can not be compressed by the
+    //! method (e.g. non-float tensors for lossy methods) are stored raw
+    TensorCompression tensor_value_compression = TensorCompression::NONE;
+
+    //! tensors with fewer elements are not compressed, so that scalar
+    //! constants are kept exact when using lossy compression
+    size_t tensor_compression_min_nr_elems = 256;
+
+    //! execution plan to be saved with the graph, usually made by
+    //! ExecPlan::Recorder from a function compiled for the same graph
+    std::shared_ptr<ExecPlan> exec_plan;
+
     GraphDumpConfig(
             int keep_var_name_ = 1, bool keep_param_name_ = false,
             bool keep_opr_priority_ = false, bool keep_op_name_ = true,
@@ -132,6 +156,22 @@ struct GraphLoadConfig {
     //! GraphDumpConfig
     TensorValueLoader tensor_value_loader;
 
+    /*!
+     * \brief number of threads to decode tensor values
+     *
+     * If it is more than 1, tensor blobs are read ahead in load order and
+     * decoded (including calling tensor_value_loader) on a thread pool while
+     * oprs are constructed on the caller thread; at most 2 * nr_load_thread
+     * values are held ahead of the opr being loaded. tensor_value_loader
+     * must be thread safe in this case. The loaded graph is the same as
+     * single-threaded loading.
+     */
+    size_t nr_load_thread = 0;
+
+    //! how LoadResult::graph_compile() uses the execution plan saved in the
+    //! model; the plan is not used by default
+    ExecPlan::UseOption exec_plan_option;
+
     GraphLoadConfig(
             const CompNodeMapper& comp_node_mapper_ = {},
             const OprLoaderMaker& opr_loader_maker_ = {},
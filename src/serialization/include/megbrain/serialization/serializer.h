@@ -55,11 +55,21 @@ public:
         //! GraphDumper::dump
         SymbolVarArray output_var_list;
 
+        //! execution plan saved in the model; null if there is none
+        std::shared_ptr<ExecPlan> exec_plan;
+
+        //! copied from GraphLoadConfig::exec_plan_option
+        ExecPlan::UseOption exec_plan_option;
+
         /*!
          * \brief call graph->compile() but also checks for comp seq rec
          *
          * graph would be destructed if comp_node_seq_record_level == 2;
          * this method should be called in favor of graph->compile().
+         *
+         * If exec_plan_option is enabled and the model contains a usable
+         * execution plan for the current input shapes, the static memory
+         * plan is loaded from it. Input tensors are never modified.
          */
         MGE_WIN_DECLSPEC_FUC std::unique_ptr<cg::AsyncExecutable> graph_compile(
                 const ComputingGraph::OutputSpec& outspec);
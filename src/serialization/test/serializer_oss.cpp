@@ -15,9 +15,12 @@
 #include "megbrain/opr/io.h"
 #include "megbrain/opr/tensor_manip.h"
 #include "megbrain/opr/utility.h"
+#include "megbrain/serialization/exec_plan.h"
 #include "megbrain/serialization/serializer.h"
 #include "megbrain/test/helper.h"
 
+#include <atomic>
+
 using namespace mgb;
 using namespace serialization;
 
@@ -173,6 +176,87 @@ TEST(TestSerializer2, APlusB) {
     load();
 }
 
+TEST(TestSerializer2, ExecPlan) {
+    auto fname = GET_OUTPUT_FILE(), fname_plan = fname + ".plan";
+    TensorShape shape{2, 3}, plan_shape{5, 3};
+    HostTensorGenerator<> gen;
+
+    auto dump = [&]() {
+        auto cn = CompNode::load("xpu0");
+        auto host_x = std::make_shared<HostTensorND>(cn, shape);
+        auto graph = ComputingGraph::make();
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x, {"x"});
+        auto dumper = GraphDumper::make(
+                OutputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        dumper->dump({((x + 1) * (x + 2)).rename("z")});
+    };
+
+    // compile and run the model with plan_shape, then save the plan
+    auto dump_plan = [&]() {
+        auto loader = GraphLoader::make(
+                InputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        auto rst = loader->load();
+        ASSERT_FALSE(rst.exec_plan);
+        *rst.tensor_map.at("x") = *gen(plan_shape);
+        HostTensorND host_z;
+        ExecPlan::Recorder recorder;
+        // the recorder owns the global PersistentCache while it is alive
+        ASSERT_THROW(ExecPlan::Recorder{}, MegBrainError);
+        auto func = rst.graph_compile(
+                {make_callback_copy(rst.output_var_map.at("z"), host_z)});
+        func->execute();
+        GraphDumper::DumpConfig config;
+        config.exec_plan = recorder.finish(*func, rst.tensor_map);
+        ASSERT_FALSE(config.exec_plan->static_mem_plan.empty());
+        // the shape of input recorded in the model differs from the plan
+        *rst.tensor_map.at("x") = *gen(shape);
+        auto dumper = GraphDumper::make(
+                OutputFile::make_fs(fname_plan.c_str()), GraphDumpFormat::FLATBUFFERS);
+        dumper->dump(rst.output_var_list, config);
+    };
+
+    // the plan is only used when it is enabled and input shapes match it
+    auto load = [&](bool enable, TensorShape input_shape, bool break_plan) {
+        auto loader = GraphLoader::make(
+                InputFile::make_fs(fname_plan.c_str()), GraphDumpFormat::FLATBUFFERS);
+        GraphLoadConfig config;
+        config.exec_plan_option.enable = enable;
+        auto rst = loader->load(config);
+        ASSERT_TRUE(rst.exec_plan);
+        ASSERT_TRUE(rst.exec_plan->usable());
+        ASSERT_EQ(1u, rst.exec_plan->input_shapes.size());
+        ASSERT_EQ(plan_shape, rst.exec_plan->input_shapes[0].second);
+        if (break_plan) {
+            rst.exec_plan->mgb_version = 0;
+            ASSERT_FALSE(rst.exec_plan->usable());
+        }
+        auto xv = rst.tensor_map.at("x");
+        *xv = *gen(input_shape);
+        HostTensorND host_z;
+        auto func = rst.graph_compile(
+                {make_callback_copy(rst.output_var_map.at("z"), host_z)});
+        // inputs given by caller are not modified
+        ASSERT_EQ(input_shape, xv->shape());
+        func->execute();
+        auto px = xv->ptr<float>();
+        auto pz = host_z.ptr<float>();
+        for (size_t i = 0, it = xv->shape().total_nr_elems(); i < it; ++i) {
+            MGB_ASSERT_FLOAT_EQ((px[i] + 1) * (px[i] + 2), pz[i]);
+        }
+        bool use_plan = enable && !break_plan && input_shape.eq_shape(plan_shape);
+        auto stat = func->get_static_mem_plan_cache_stat();
+        ASSERT_EQ(use_plan ? 1u : 0u, stat.nr_hit);
+        ASSERT_EQ(use_plan ? 0u : 1u, stat.nr_miss);
+    };
+
+    dump();
+    dump_plan();
+    load(true, plan_shape, false);
+    load(true, plan_shape, true);
+    load(true, shape, false);
+    load(false, plan_shape, false);
+}
+
 TEST(TestSerializer2, APlusBParam) {
     auto cns = load_multiple_xpus(2);
     auto fname = GET_OUTPUT_FILE();
@@ -225,6 +309,123 @@ TEST(TestSerializer2, APlusBParam) {
     ASSERT_EQ(1u + (cns[1].mem_node() != cns[0].mem_node()), shmap.at("y")->size());
 }
 
+TEST(TestSerializer2, MmapZeroCopy) {
+    auto fname = GET_OUTPUT_FILE();
+    auto cn = CompNode::load("cpu0");
+    TensorShape shape{16, 32};
+    constexpr size_t ALIGN = 64;
+
+    HostTensorGenerator<> gen;
+    auto bias = std::make_shared<DeviceTensorND>();
+    auto bias_hv = gen(shape, cn);
+    bias->copy_from(*bias_hv);
+    {
+        auto host_x = std::make_shared<HostTensorND>(cn, shape);
+        auto graph = ComputingGraph::make();
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x, {"x"}),
+             // a scalar is dumped first to make the file offset unaligned
+             y = opr::SharedDeviceTensor::make(*graph, *gen({1}, cn), {"y"}),
+             z = opr::SharedDeviceTensor::make(*graph, bias, {"z"});
+        auto dumper = GraphDumper::make(
+                OutputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        GraphDumper::DumpConfig config;
+        config.keep_param_name = true;
+        config.tensor_value_alignment = ALIGN;
+        dumper->dump({(x * y + z).rename("out")}, config);
+    }
+
+    auto loader = GraphLoader::make(
+            InputFile::make_mmap(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+    auto rst = loader->load();
+    auto xv = rst.tensor_map.at("x");
+    *xv = *gen(shape, cn);
+    HostTensorND host_out;
+    auto func = rst.graph_compile(
+            {make_callback_copy(rst.output_var_map.at("out"), host_out)});
+    func->execute();
+
+    auto&& shmap = loader->shared_tensor_name_map();
+    auto&& y = shmap.at("y")->begin()->second;
+    auto&& z = shmap.at("z")->begin()->second;
+    auto py = y->ptr<float>(), pz = z->ptr<float>();
+    // the param is aligned so it can be used in place
+    ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(pz) % ALIGN);
+    MGB_ASSERT_TENSOR_EQ(*bias_hv, HostTensorND{}.copy_from(*z).sync());
+
+    auto px = xv->ptr<float>(), pout = host_out.ptr<float>();
+    for (size_t i = 0, it = shape.total_nr_elems(); i < it; ++i) {
+        MGB_ASSERT_FLOAT_EQ(px[i] * py[0] + pz[i], pout[i]);
+    }
+
+    // aligned values read from the same position share the mapping
+    auto file = InputFile::make_mmap(fname.c_str());
+    TensorLayout layout{{ALIGN / sizeof(float)}, dtype::Float32()};
+    HostTensorND t0{cn}, t1{cn};
+    file->read_into_tensor(t0, layout);
+    file->rewind();
+    file->read_into_tensor(t1, layout);
+    ASSERT_EQ(t0.raw_ptr(), t1.raw_ptr());
+}
+
+TEST(TestSerializer2, MmapResidency) {
+    auto fname = GET_OUTPUT_FILE();
+    auto cn = CompNode::load("cpu0");
+    TensorShape shape{512, 1024};
+
+    HostTensorGenerator<> gen;
+    auto host_x = gen(shape, cn);
+    {
+        auto graph = ComputingGraph::make();
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x, {"x"}),
+             w = opr::SharedDeviceTensor::make(*graph, *gen(shape, cn));
+        auto dumper = GraphDumper::make(
+                OutputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        GraphDumper::DumpConfig config;
+        config.tensor_value_alignment = 64;
+        dumper->dump({(x + w).rename("y")}, config);
+    }
+
+    std::shared_ptr<MmapResidency> residency;
+    auto loader = GraphLoader::make(
+            InputFile::make_mmap(fname.c_str(), &residency),
+            GraphDumpFormat::FLATBUFFERS);
+    ASSERT_TRUE(residency);
+    auto rst = loader->load();
+    rst.tensor_map.at("x")->copy_from(*host_x);
+    HostTensorND host_y, host_y_expect;
+    auto func = rst.graph_compile(
+            {make_callback_copy(rst.output_var_map.at("y"), host_y)});
+    func->execute();
+    host_y_expect.copy_from(host_y);
+
+    auto stat = residency->stat();
+    if (!stat.supported) {
+        return;
+    }
+    ASSERT_GT(stat.resident_bytes, 0u);
+    auto trimmed = residency->trim(0);
+    ASSERT_GT(trimmed.nr_trimmed_chunk, 0u);
+    ASSERT_EQ(0u, residency->stat().resident_bytes);
+
+    // params are paged in again on next touch
+    func->execute();
+    MGB_ASSERT_TENSOR_EQ(host_y_expect, host_y);
+    ASSERT_GT(residency->stat().resident_bytes, 0u);
+
+    // touched params are trimmed automatically after each execution once
+    // the budget is exceeded
+    residency->track(*rst.graph);
+    residency->set_budget(0);
+    func->execute().wait();
+    MGB_ASSERT_TENSOR_EQ(host_y_expect, host_y);
+    ASSERT_EQ(0u, residency->stat().resident_bytes);
+
+    residency->set_budget(MmapResidency::NO_BUDGET);
+    func->execute().wait();
+    MGB_ASSERT_TENSOR_EQ(host_y_expect, host_y);
+    ASSERT_GT(residency->stat().resident_bytes, 0u);
+}
+
 TEST(TestSerializer2, Immutable) {
     auto fname = GET_OUTPUT_FILE();
     TensorShape shape{2, 3};
@@ -339,6 +540,174 @@ TEST(TestSerializer2, CustomLoader) {
     ASSERT_EQ(4, load_nr_call);
 }
 
+TEST(TestSerializer2, ParallelLoad) {
+    auto fname = GET_OUTPUT_FILE();
+    constexpr size_t NR_PARAM = 16;
+    constexpr uint8_t KEY = 0x5a;
+    TensorShape shape{4, 5};
+
+    // a trivial "encryption" to check that custom loaders run correctly on
+    // worker threads
+    auto tensor_value_dumper = [](OutputFile& fout, const cg::OperatorNodeBase&,
+                                  const HostTensorND& tensor) {
+        auto size = tensor.layout().span().high_byte;
+        std::vector<uint8_t> buf(size);
+        auto src = reinterpret_cast<const uint8_t*>(tensor.raw_ptr());
+        for (size_t i = 0; i < size; ++i) {
+            buf[i] = src[i] ^ KEY;
+        }
+        fout.write(buf.data(), size);
+    };
+    std::atomic_size_t load_nr_call{0};
+    auto tensor_value_loader = [&load_nr_call](
+                                       void* ptr, const TensorLayout& layout,
+                                       InputFile& fin) {
+        ++load_nr_call;
+        auto size = layout.span().high_byte;
+        if (!ptr) {
+            fin.skip(size);
+            return;
+        }
+        fin.read(ptr, size);
+        auto dst = static_cast<uint8_t*>(ptr);
+        for (size_t i = 0; i < size; ++i) {
+            dst[i] ^= KEY;
+        }
+    };
+
+    HostTensorGenerator<> gen;
+    auto host_x = gen(shape);
+    {
+        auto graph = ComputingGraph::make();
+        auto y = opr::Host2DeviceCopy::make(*graph, host_x, {"x"});
+        for (size_t i = 0; i < NR_PARAM; ++i) {
+            auto p = opr::SharedDeviceTensor::make(*graph, *gen(shape));
+            y = i % 2 ? y + p : y * p;
+        }
+        auto dumper = GraphDumper::make(
+                OutputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        GraphDumpConfig config;
+        config.tensor_value_dumper = tensor_value_dumper;
+        dumper->dump({y.rename("y")}, config);
+    }
+
+    auto load = [&](size_t nr_load_thread) {
+        GraphLoadConfig config;
+        config.tensor_value_loader = tensor_value_loader;
+        config.nr_load_thread = nr_load_thread;
+        auto loader = GraphLoader::make(
+                InputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        auto rst = loader->load(config);
+        rst.tensor_map.at("x")->copy_from(*host_x);
+        HostTensorND host_y;
+        auto func = rst.graph_compile(
+                {make_callback_copy(rst.output_var_map.at("y"), host_y)});
+        func->execute();
+        return host_y;
+    };
+
+    auto expect = load(0);
+    ASSERT_EQ(NR_PARAM, load_nr_call.load());
+    auto get = load(4);
+    ASSERT_EQ(NR_PARAM * 2, load_nr_call.load());
+    MGB_ASSERT_TENSOR_EQ(expect, get);
+}
+
+TEST(TestSerializer2, TensorCompression) {
+    using Compression = GraphDumpConfig::TensorCompression;
+    auto fname = GET_OUTPUT_FILE();
+    TensorShape shape{16, 32};
+
+    HostTensorGenerator<> gen;
+    auto host_x = gen(shape);
+    auto host_w = gen(shape);
+    // prune half of the channels so that lossless compression works
+    for (size_t i = 0; i < shape[0]; i += 2) {
+        memset(host_w->ptr<float>() + i * shape[1], 0, shape[1] * sizeof(float));
+    }
+    // scalar constants are not compressed
+    const float SCALE = 0.1234567f;
+
+    auto dump = [&](Compression compression) {
+        auto graph = ComputingGraph::make();
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x, {"x"}),
+             w = opr::SharedDeviceTensor::make(*graph, *host_w),
+             y = (x + w) * SCALE;
+        auto dumper = GraphDumper::make(
+                OutputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        GraphDumpConfig config;
+        config.tensor_value_compression = compression;
+        return dumper->dump({y.rename("y")}, config).tensor_value_bytes;
+    };
+
+    auto load = [&](size_t nr_load_thread) {
+        GraphLoadConfig config;
+        config.nr_load_thread = nr_load_thread;
+        auto loader = GraphLoader::make(
+                InputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        auto rst = loader->load(config);
+        rst.tensor_map.at("x")->copy_from(*host_x);
+        HostTensorND host_y;
+        auto func = rst.graph_compile(
+                {make_callback_copy(rst.output_var_map.at("y"), host_y)});
+        func->execute();
+        return host_y;
+    };
+
+    auto raw_bytes = dump(Compression::NONE);
+    auto expect = load(0);
+
+    auto run = [&](Compression compression, float max_err) {
+        auto bytes = dump(compression);
+        ASSERT_LT(bytes, raw_bytes);
+        for (size_t nr_load_thread : {0, 2}) {
+            auto get = load(nr_load_thread);
+            float err = 0;
+            for (size_t i = 0; i < shape.total_nr_elems(); ++i) {
+                err = std::max(
+                        err, std::abs(get.ptr<float>()[i] - expect.ptr<float>()[i]));
+            }
+            ASSERT_LE(err, max_err) << "compression=" << static_cast<int>(compression);
+        }
+    };
+
+    run(Compression::LOSSLESS, 0);
+    run(Compression::FLOAT16, 1e-3);
+    run(Compression::INT8_PER_CHANNEL, 5e-2);
+}
+
+TEST(TestSerializer2, TensorCompressionNoGain) {
+    using Compression = GraphDumpConfig::TensorCompression;
+    auto fname = GET_OUTPUT_FILE();
+    HostTensorGenerator<> gen;
+    // one element per channel: int8 values plus float scales are larger
+    // than the raw value, so it must be stored uncompressed
+    auto host_w = gen({64, 1});
+    auto dump = [&](Compression compression) {
+        auto graph = ComputingGraph::make();
+        auto w = opr::SharedDeviceTensor::make(*graph, *host_w);
+        auto dumper = GraphDumper::make(
+                OutputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        GraphDumpConfig config;
+        config.tensor_value_compression = compression;
+        config.tensor_compression_min_nr_elems = 0;
+        return dumper->dump({(w * 2).rename("y")}, config).tensor_value_bytes;
+    };
+    auto raw_bytes = dump(Compression::NONE);
+    ASSERT_EQ(raw_bytes, dump(Compression::INT8_PER_CHANNEL));
+
+    auto loader = GraphLoader::make(
+            InputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+    auto rst = loader->load();
+    HostTensorND host_y;
+    auto func = rst.graph_compile(
+            {make_callback_copy(rst.output_var_map.at("y"), host_y)});
+    func->execute();
+    for (size_t i = 0; i < 64; ++i) {
+        ASSERT_EQ(host_w->ptr<float>()[i] * 2, host_y.ptr<float>()[i]);
+    }
+}
+
 TEST(TestSerializer2, ManyIOVars) {
     auto fname = GET_OUTPUT_FILE();
     constexpr size_t NR_VARS = 32;